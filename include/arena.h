@@ -0,0 +1,65 @@
+/** @file
+ *
+ */
+
+#ifndef PDF_SIGIL_ARENA_H
+#define PDF_SIGIL_ARENA_H
+
+#include "types.h"
+
+/** @brief Sets up an empty arena, no memory is allocated until needed
+ *
+ * @param arena the arena to be initialized
+ */
+void arena_init(arena_t *arena);
+
+/** @brief Allocates zeroed memory from the arena, valid until arena_release
+ *
+ * @param arena the arena
+ * @param size number of bytes
+ * @param sensitive whether the memory needs to be zeroized on release
+ * @return pointer to the memory, NULL if allocation failed
+ */
+void *arena_alloc(arena_t *arena, size_t size, int sensitive);
+
+/** @brief Grows the allocation from the arena, in place if it is the most
+ *         recent one and there is space left in its block. Otherwise the data
+ *         are copied to a new allocation and the old one is kept (and
+ *         zeroized if sensitive) until arena_release. The added bytes are
+ *         zeroed.
+ *
+ * @param arena the arena
+ * @param ptr the allocation from arena_alloc with the same *sensitive*, or NULL
+ * @param old_size current size of the allocation
+ * @param size new size
+ * @param sensitive whether the memory needs to be zeroized on release
+ * @return pointer to the memory, NULL if allocation failed
+ */
+void *arena_realloc(arena_t *arena, void *ptr, size_t old_size, size_t size,
+                    int sensitive);
+
+/** @brief Zeroizes the sensitive allocations and makes all the memory of the
+ *         arena available again, the blocks are kept for the following
+ *         allocations
+ *
+ * @param arena the arena
+ */
+void arena_reset(arena_t *arena);
+
+/** @brief Zeroizes the sensitive allocations and releases all the memory of
+ *         the arena at once, the arena can be used again
+ *
+ * @param arena the arena
+ */
+void arena_release(arena_t *arena);
+
+/** @brief Tests for the arena module
+ *
+ * @param verbosity output level - 0 means nothing, 1 prints module names with
+ *                  the overall module result, and 2 prints also each test inside
+ *                  of the module
+ * @return 0 if success, 1 if failed
+ */
+int sigil_arena_self_test(int verbosity);
+
+#endif /* PDF_SIGIL_ARENA_H */
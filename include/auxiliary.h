@@ -7,6 +7,7 @@
 
 #include <stdio.h> // size_t, FILE
 #include "types.h"
+#include "uring.h"
 
 /** @brief Find minimum of two values
  *
@@ -38,6 +39,54 @@ int is_digit(const char c);
  */
 int is_whitespace(const char c);
 
+/** @brief Decides whether the character is a delimiter according to PDF
+ *         standard
+ *
+ * @param c character provided for comparison
+ * @return 1 if true, 0 otherwise
+ */
+int is_delimiter(const char c);
+
+/** @brief Finds the first character that is not a whitespace, processing
+ *         16 or 32 bytes at once where SSE2 or AVX2 is available
+ *
+ * @param data input data
+ * @param size number of bytes of the data
+ * @return index of the character found, *size* if there is none
+ */
+size_t find_non_whitespace(const char *data, size_t size);
+
+/** @brief Finds the first delimiter which is significant for skipping the
+ *         objects - one of "<>[]/(%", processing 16 or 32 bytes at once where
+ *         SSE2 or AVX2 is available
+ *
+ * @param data input data
+ * @param size number of bytes of the data
+ * @return index of the character found, *size* if there is none
+ */
+size_t find_delimiter(const char *data, size_t size);
+
+/** @brief Finds the first occurrence of *str* in the data
+ *
+ * @param data input data
+ * @param size number of bytes of the data
+ * @param str string to look for, doesn't need to be null-terminated
+ * @param str_size number of characters of the *str*
+ * @return index of the occurrence found, *size* if there is none
+ */
+size_t find_str(const char *data, size_t size, const char *str, size_t str_size);
+
+/** @brief Finds the last occurrence of *str* in the data
+ *
+ * @param data input data
+ * @param size number of bytes of the data
+ * @param str string to look for, doesn't need to be null-terminated
+ * @param str_size number of characters of the *str*
+ * @return index of the occurrence found, *size* if there is none
+ */
+size_t find_str_reverse(const char *data, size_t size, const char *str,
+                        size_t str_size);
+
 /** @brief Reads *size* bytes from PDF to *result* and adds a terminating null.
  *         Does move the position in PDF.
  *
@@ -49,6 +98,81 @@ int is_whitespace(const char c);
  */
 sigil_err_t pdf_read(sigil_t *sgl, size_t size, char *result, size_t *res_size);
 
+/** @brief Provides a pointer to *length* bytes from the *position* (relative
+ *         like in pdf_move_pos_abs) if these data are available in memory
+ *         (buffer, mapping or a reader able to borrow them), without copying.
+ *         Does not move the position in PDF.
+ *
+ * @param sgl context
+ * @param position starting position of the data
+ * @param length number of bytes
+ * @param data output - pointer to the data
+ * @return ERR_NONE if success, ERR_NO_DATA if not available in memory
+ */
+sigil_err_t pdf_borrow(sigil_t *sgl, size_t position, size_t length,
+                       const char **data);
+
+/** @brief Provides *length* bytes from the *position* (relative like in
+ *         pdf_move_pos_abs) - borrowed if available in memory, otherwise read
+ *         into a newly allocated *copy*. May move the position in PDF.
+ *
+ * @param sgl context
+ * @param position starting position of the data
+ * @param length number of bytes
+ * @param data output - pointer to the data
+ * @param copy output - allocated copy to be freed by the caller, NULL if the
+ *             data were borrowed
+ * @return ERR_NONE if success
+ */
+sigil_err_t pdf_view(sigil_t *sgl, size_t position, size_t length,
+                     const char **data, char **copy);
+
+/** @brief Callback receiving the data read by pdf_read_ahead
+ *
+ */
+typedef sigil_err_t (*consume_fn_t)(void *arg, const char *data, size_t size);
+
+/** @brief Buffers and io_uring instance of pdf_read_ahead, set up on the first
+ *         use and kept for the following calls till read_ahead_free
+ *
+ */
+typedef struct {
+    char   *blocks;     // READ_AHEAD_DEPTH buffers of READ_AHEAD_SIZE bytes
+    uring_t ring;
+    int     ring_state; // 0 not tried yet, 1 ready, -1 not available
+} read_ahead_t;
+
+/** @brief Prepares the read-ahead state, nothing is allocated yet
+ *
+ * @param ahead the state
+ */
+void read_ahead_init(read_ahead_t *ahead);
+
+/** @brief Releases the buffers and the io_uring instance of the read-ahead
+ *         state, no read is in flight after pdf_read_ahead returns
+ *
+ * @param ahead the state
+ */
+void read_ahead_free(read_ahead_t *ahead);
+
+/** @brief Reads *length* bytes from the *position* (relative like in
+ *         pdf_move_pos_abs) of the PDF data that are not available in memory
+ *         and passes them block by block to the *consume* callback, in order.
+ *         Keeps up to READ_AHEAD_DEPTH reads of READ_AHEAD_SIZE in flight
+ *         using io_uring if available, otherwise reads synchronously.
+ *         Does not move the position in PDF.
+ *
+ * @param sgl context
+ * @param ahead read-ahead state shared by the consecutive calls
+ * @param position starting position of the data
+ * @param length number of bytes
+ * @param consume callback receiving the data
+ * @param arg first argument of the callback
+ * @return ERR_NONE if success
+ */
+sigil_err_t pdf_read_ahead(sigil_t *sgl, read_ahead_t *ahead, size_t position,
+                           size_t length, consume_fn_t consume, void *arg);
+
 /** @brief Reads one character from PDF and moves the position in PDF.
  *
  * @param sgl context
@@ -155,6 +279,15 @@ sigil_err_t parse_number(sigil_t *sgl, size_t *number);
  */
 sigil_err_t parse_indirect_reference(sigil_t *sgl, reference_t *ref);
 
+/** @brief Exact match of the name against the dictionary keys known to the
+ *         library, without the leading '/'
+ *
+ * @param name the name, doesn't need to be null-terminated
+ * @param length number of characters of the name
+ * @return one of DICT_KEY_*, DICT_KEY_UNKNOWN if not known
+ */
+dict_key_t lookup_dict_key(const char *name, size_t length);
+
 /** @brief Loads a dictionary key from the current position in the PDF
  *
  * @param sgl context
@@ -224,6 +357,13 @@ sigil_t *test_prepare_sgl_buffer(char *content, size_t size);
  */
 sigil_t *test_prepare_sgl_path(const char *path);
 
+/** @brief Prepares the reader serving the null-terminated data, for the tests
+ *
+ * @param reader output - the reader to be set by sigil_set_pdf_reader
+ * @param data the PDF data, kept by the caller while the reader is used
+ */
+void test_string_reader(sigil_reader_t *reader, char *data);
+
 /** @brief Tests for the auxiliary module
  *
  * @param verbosity output level - 0 means nothing, 1 prints module names with
@@ -11,11 +11,13 @@
  *         and the following are for verifying the authenticity of the signing one
  *
  * @param sgl context
+ * @param sig output - the signature to save the certificates to
  * @return ERR_NONE if success
  */
-sigil_err_t parse_certs(sigil_t *sgl);
+sigil_err_t parse_certs(sigil_t *sgl, signature_t *sig);
 
-/** @brief Cleans-up the provided cert_t structure
+/** @brief Cleans-up the X.509 certificates of the provided list, the cert_t
+ *         structures are in the arena of the context
  *
  */
 void cert_free(cert_t *cert);
@@ -21,6 +21,12 @@
  */
 #define XREF_PREALLOCATION          10
 
+/** @brief highest object number accepted before the /Size from trailer is
+ *         known, the implementation limit from PDF standard
+ *
+ */
+#define XREF_MAX_OBJECT_NUM         8388607
+
 /** @brief capacity to choose for the first allocation in array of fields
  *
  */
@@ -36,21 +42,83 @@
  */
 #define CONTENTS_PREALLOCATION      1024
 
-/** @brief threshold in bytes for loading whole file into buffer
+/** @brief capacity to choose for the first allocation of array for signatures
+ *
+ */
+#define SIGNATURE_PREALLOCATION     4
+
+/** @brief maximum number of threads verifying the signatures of one document,
+ *         limited also by the number of processors and signatures
+ *
+ */
+#define VERIFY_THREADS_MAX          8
+
+/** @brief size of the blocks allocated by the arena of the context, larger
+ *         allocations get a block of their own
+ *
+ */
+#define ARENA_BLOCK_SIZE            4096
+
+/** @brief threshold in bytes for loading whole file into buffer, used only
+ *         if the file can't be mapped into memory
  *
  */
 #define THRESHOLD_FILE_BUFFERING    10485760
 
-/** @brief maximum number of file updates, preventing forever loop in processing
- *         previous cross-reference sections (caused by cyclic links)
+/** @brief size in bytes of the block read at once from a file (or other reader)
+ *         that is not available in memory, the blocks are aligned to it
  *
  */
-#define MAX_FILE_UPDATES            1024
+#define READ_WINDOW_SIZE            65536
 
-/** @brief maximum size we give to hash function at once
+/** @brief size in bytes of one read issued ahead while hashing the data that
+ *         are not available in memory
  *
  */
-#define HASH_UPDATE_SIZE            1024
+#define READ_AHEAD_SIZE             262144
+
+/** @brief maximum number of reads in flight while hashing the data that are
+ *         not available in memory
+ *
+ */
+#define READ_AHEAD_DEPTH            4
+
+/** @brief size in bytes of the blocks passed to all the message digests
+ *         hashing the same data, small enough to stay in the processor cache
+ *
+ */
+#define DIGEST_BLOCK_SIZE           16384
+
+/** @brief size in bytes of the chunks in which the streams (e.g. cross-reference
+ *         streams) are read and inflated
+ *
+ */
+#define STREAM_CHUNK_SIZE           16384
+
+/** @brief number of decoded object streams kept in memory, the least recently
+ *         used one is replaced when another one needs to be decoded
+ *
+ */
+#define OBJSTM_CACHE_SIZE           4
+
+/** @brief maximum number of threads decoding the cross-reference streams of
+ *         the incremental updates, limited also by the number of processors
+ *
+ */
+#define XREF_THREADS_MAX            8
+
+/** @brief number of bytes following the "obj" keyword searched for the type
+ *         of the object (/Catalog, /ObjStm) when reconstructing the
+ *         cross-reference table of a damaged file
+ *
+ */
+#define XREF_RECONSTRUCT_WINDOW     1024
+
+/** @brief maximum number of file updates, preventing forever loop in processing
+ *         previous cross-reference sections (caused by cyclic links)
+ *
+ */
+#define MAX_FILE_UPDATES            1024
 
 /** @brief Tests for the config module
  *
@@ -21,6 +21,13 @@
 #define XREF_TYPE_TABLE                 1
 #define XREF_TYPE_STREAM                2
 
+#define XREF_ENTRY_NONE                 0
+#define XREF_ENTRY_IN_USE               1
+#define XREF_ENTRY_COMPRESSED           2
+
+#define STREAM_FILTER_NONE              0
+#define STREAM_FILTER_FLATE             1
+
 #define DICT_KEY_UNKNOWN                0
 #define DICT_KEY_Size                   1
 #define DICT_KEY_Prev                   2
@@ -34,6 +41,17 @@
 #define DICT_KEY_Cert                   10
 #define DICT_KEY_Contents               11
 #define DICT_KEY_ByteRange              12
+#define DICT_KEY_W                      13
+#define DICT_KEY_Index                  14
+#define DICT_KEY_Filter                 15
+#define DICT_KEY_DecodeParms            16
+#define DICT_KEY_Predictor              17
+#define DICT_KEY_Columns                18
+#define DICT_KEY_Length                 19
+#define DICT_KEY_N                      20
+#define DICT_KEY_First                  21
+#define DICT_KEY_Type                   22
+#define DICT_KEY_XRefStm                23
 
 #define SUBFILTER_UNKNOWN               0
 #define SUBFILTER_adbe_x509_rsa_sha1    1
@@ -58,6 +76,7 @@
 
 #define DEALLOCATE_FILE                 0x01
 #define DEALLOCATE_BUFFER               0x02
+#define DEALLOCATE_MAPPING              0x04
 
 #define ERR_NONE                        0
 #define ERR_ALLOCATION                  1
@@ -10,15 +10,17 @@
 /** @brief Load the data from Contents entry in the signature dictionary
  *
  * @param sgl context
+ * @param sig output - the signature to save the contents to
  * @return ERR_NONE if success
  */
-sigil_err_t parse_contents(sigil_t *sgl);
+sigil_err_t parse_contents(sigil_t *sgl, signature_t *sig);
 
-/** Cleans-up the contents entry from the context
+/** Cleans-up the contents entry from the signature, the memory is released
+ *  (and zeroized) with the arena of the context
  *
- * @param sgl context
+ * @param sig signature
  */
-void contents_free(sigil_t *sgl);
+void contents_free(signature_t *sig);
 
 /** @brief Tests for the contents module
  *
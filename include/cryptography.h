@@ -5,47 +5,84 @@
 #ifndef PDF_SIGIL_CRYPTOGRAPHY_H
 #define PDF_SIGIL_CRYPTOGRAPHY_H
 
+#include "pool.h"
 #include "types.h"
 
+/** @brief Message digest of the ranges of the file, for digest_jobs
+ *
+ */
+typedef struct {
+    const EVP_MD  *evp_md;
+    const range_t *range;  // the ranges hashed, in this order
+    size_t         base;   // position in the file the ranges are relative to
+    unsigned char  digest[EVP_MAX_MD_SIZE];
+    unsigned int   digest_len;
+} digest_job_t;
 
-/** @brief Compute a message digest (hash) for the PKCS#1 signature type
+/** @brief Computes the message digests of all the jobs in one walk through
+ *         the file. Each block of data is passed to all the message digest
+ *         contexts using it before moving on, and the jobs with the same
+ *         function and the same beginning of the ranges (as the ones of the
+ *         incremental updates) share the context till their ranges part.
+ *         Ranges going back in the file are read again.
  *
  * @param sgl context
+ * @param pool the pool hashing the same data for each context in parallel, if
+ *             it has threads - requires the PDF data in memory then
+ * @param job the jobs, the digests saved in them
+ * @param count number of the jobs
  * @return ERR_NONE if success
  */
-sigil_err_t compute_digest_pkcs1(sigil_t *sgl);
+sigil_err_t digest_jobs(sigil_t *sgl, pool_t *pool, digest_job_t *job, size_t count);
 
-/** @brief Load certificates from the hex form to the X.509 object
+/** @brief Compute the message digests (hashes) for the PKCS#1 signatures of
+ *         the document, together with the SHA-256 of the whole file if asked
+ *         for, all in one walk through the file by digest_jobs. The
+ *         signatures already failed are left out, and the ones failing here
+ *         (e.g. with ERR_DIGEST_TYPE) get the error saved inside.
  *
  * @param sgl context
+ * @param pool the pool to hash in, see digest_jobs
+ * @param sig the signatures with the byte ranges and the digest algorithms
+ * @param count number of the signatures
+ * @param file_digest output - SHA-256 of the whole file, NULL if not needed
  * @return ERR_NONE if success
  */
-sigil_err_t load_certificates(sigil_t *sgl);
+sigil_err_t compute_digest_pkcs1(sigil_t *sgl, pool_t *pool, signature_t **sig,
+                                 size_t count, ASN1_OCTET_STRING **file_digest);
+
+/** @brief Load certificates from the hex form to the X.509 object
+ *
+ * @param sig signature
+ * @return ERR_NONE if success
+ */
+sigil_err_t load_certificates(signature_t *sig);
 
 /** @brief Get the original message digest from the loaded hexadecimal form of the
  *         Contents entry from the signature dictionary
  *
- * @param sgl context
+ * @param sig signature
  * @return ERR_NONE if success
  */
-sigil_err_t load_digest(sigil_t *sgl);
+sigil_err_t load_digest(signature_t *sig);
 
 /** @brief Verify validity of the signing certificate. If present, it is using
  *         the other provided certificates to build the chain of trust. Does
- *         save the result inside of the context (NOT the return value)
+ *         save the result inside of the signature (NOT the return value)
  *
- * @param sgl context
+ * @param sgl context with the trusted certificates
+ * @param sig signature
  * @return ERR_NONE if success
  */
-sigil_err_t verify_signing_certificate(sigil_t *sgl);
+sigil_err_t verify_signing_certificate(sigil_t *sgl, signature_t *sig);
 
 /** @brief Compare the message digest from the signature with the computed one.
- *         Does save the result inside of the context (NOT the return value)
+ *         Does save the result inside of the signature (NOT the return value)
  *
- * @param sgl context
+ * @param sig signature
  * @return ERR_NONE if success
  */
-sigil_err_t compare_digest(sigil_t *sgl);
+sigil_err_t compare_digest(signature_t *sig);
 
 /** @brief Tests for the cryptography module
  *
@@ -0,0 +1,72 @@
+/** @file
+ *
+ */
+
+#ifndef PDF_SIGIL_MEM_H
+#define PDF_SIGIL_MEM_H
+
+#include "types.h"
+
+/** @brief Sets the allocator for all the following allocations of the library
+ *
+ * @param allocator the allocator to be copied, NULL restores the one of libc
+ * @return ERR_NONE if success, ERR_PARAMETER if a callback is missing
+ */
+sigil_err_t mem_set_allocator(const sigil_allocator_t *allocator);
+
+/** @brief Allocates the memory through the current allocator
+ *
+ * @param size number of bytes
+ * @return pointer to the memory, NULL if allocation failed
+ */
+void *mem_alloc(size_t size);
+
+/** @brief Allocates zeroed memory through the current allocator
+ *
+ * @param count number of the items
+ * @param size size of one item
+ * @return pointer to the memory, NULL if allocation failed or the total size
+ *         overflows
+ */
+void *mem_calloc(size_t count, size_t size);
+
+/** @brief Resizes the memory through the current allocator
+ *
+ * @param ptr allocation to be resized, NULL to allocate a new one
+ * @param size new number of bytes
+ * @return pointer to the memory, NULL if allocation failed (*ptr* is kept)
+ */
+void *mem_realloc(void *ptr, size_t size);
+
+/** @brief Releases the memory through the current allocator
+ *
+ * @param ptr allocation to be released, may be NULL
+ */
+void mem_free(void *ptr);
+
+/** @brief Counts of the allocations made by test_count_allocator
+ *
+ */
+typedef struct {
+    size_t allocated;
+    size_t released;
+} test_counter_t;
+
+/** @brief Prepares the allocator of libc counting the allocations, for the
+ *         tests
+ *
+ * @param allocator output - the allocator to be set by mem_set_allocator
+ * @param counter the counts, zeroed here
+ */
+void test_count_allocator(sigil_allocator_t *allocator, test_counter_t *counter);
+
+/** @brief Tests for the mem module
+ *
+ * @param verbosity output level - 0 means nothing, 1 prints module names with
+ *                  the overall module result, and 2 prints also each test inside
+ *                  of the module
+ * @return 0 if success, 1 if failed
+ */
+int sigil_mem_self_test(int verbosity);
+
+#endif /* PDF_SIGIL_MEM_H */
@@ -0,0 +1,59 @@
+/** @file
+ *
+ */
+
+#ifndef PDF_SIGIL_OBJSTM_H
+#define PDF_SIGIL_OBJSTM_H
+
+#include "types.h"
+
+/** @brief Moves the position in PDF to the beginning of the object compressed
+ *         in the object stream. The object stream is decoded only if it is not
+ *         in the cache already. Until objstm_leave is called (also by the next
+ *         pdf_goto_obj), the decoded data take the place of the PDF data.
+ *
+ * @param sgl context
+ * @param stream_num object number of the object stream
+ * @param index index of the object within the object stream
+ * @param ref indirect reference to the compressed object
+ * @return ERR_NONE if success
+ */
+sigil_err_t objstm_goto_obj(sigil_t *sgl, size_t stream_num, size_t index,
+                            const reference_t *ref);
+
+/** @brief Puts back the PDF data in place of the decoded object stream, if
+ *         there is any in use
+ *
+ * @param sgl context
+ */
+void objstm_leave(sigil_t *sgl);
+
+/** @brief Decodes the object stream, without using the cache, to get the
+ *         numbers of the objects compressed in it
+ *
+ * @param sgl context
+ * @param stream_num object number of the object stream
+ * @param object output - object numbers in the order of their indexes, to be
+ *               freed by the caller
+ * @param count output - number of the objects
+ * @return ERR_NONE if success
+ */
+sigil_err_t objstm_list_objects(sigil_t *sgl, size_t stream_num,
+                                size_t **object, size_t *count);
+
+/** @brief Clean-up of all the decoded object streams in the cache
+ *
+ * @param sgl context
+ */
+void objstm_free(sigil_t *sgl);
+
+/** @brief Tests for the objstm module
+ *
+ * @param verbosity output level - 0 means nothing, 1 prints module names with
+ *                  the overall module result, and 2 prints also each test inside
+ *                  of the module
+ * @return 0 if success, 1 if failed
+ */
+int sigil_objstm_self_test(int verbosity);
+
+#endif /* PDF_SIGIL_OBJSTM_H */
@@ -0,0 +1,100 @@
+/** @file
+ *
+ */
+
+#ifndef PDF_SIGIL_POOL_H
+#define PDF_SIGIL_POOL_H
+
+#include "types.h"
+
+#ifndef _WIN32
+    #include <pthread.h>
+#endif
+
+struct pool_t;
+
+/** @brief Task run by the pool, may submit other tasks to the same pool
+ *
+ */
+typedef sigil_err_t (*pool_fn_t)(struct pool_t *pool, void *arg);
+
+typedef struct pool_task_t {
+    pool_fn_t           run;
+    void               *arg;
+    struct pool_task_t *next;
+} pool_task_t;
+
+/** @brief Small pool of threads running the queued tasks. Without any thread
+ *         (one requested, or not supported), the tasks are run right away by
+ *         the one submitting them.
+ *
+ */
+typedef struct pool_t {
+    size_t          threads; // threads started, 0 means run on submit
+    pool_task_t    *head;
+    pool_task_t    *tail;
+    size_t          running; // tasks being run by the threads
+    int             shutdown;
+    sigil_err_t     err;     // the first error of a task since pool_wait
+    #ifndef _WIN32
+        pthread_t      *thread;
+        pthread_mutex_t lock;
+        pthread_cond_t  work;    // task queued or shutdown
+        pthread_cond_t  idle;    // nothing queued nor running
+    #endif
+} pool_t;
+
+/** @brief Number of threads for the pool working on *count* independent
+ *         tasks, limited to *max* and the number of processors. 1 if the PDF
+ *         data are not in memory, as the reader is not required to be
+ *         thread-safe.
+ *
+ * @param sgl context
+ * @param count number of the tasks
+ * @param max maximum number of threads
+ * @return the number of threads, at least 1
+ */
+size_t pool_thread_count(const sigil_t *sgl, size_t count, size_t max);
+
+/** @brief Starts the pool
+ *
+ * @param threads number of threads, 1 or less runs the tasks on submit
+ * @return the pool, NULL if allocation failed
+ */
+pool_t *pool_create(size_t threads);
+
+/** @brief Queues the task to be run by one of the threads. Can be called
+ *         also from the tasks.
+ *
+ * @param pool the pool
+ * @param run the task
+ * @param arg argument of the task, still owned by the caller on failure
+ * @return ERR_NONE if success
+ */
+sigil_err_t pool_submit(pool_t *pool, pool_fn_t run, void *arg);
+
+/** @brief Waits till all the tasks submitted so far (and the ones submitted by
+ *         them) are finished, not to be called from the tasks
+ *
+ * @param pool the pool
+ * @return ERR_NONE if all the tasks succeeded, the first error otherwise
+ */
+sigil_err_t pool_wait(pool_t *pool);
+
+/** @brief Stops the threads and releases the pool, the queued tasks are run
+ *         before
+ *
+ * @param pool the pool
+ */
+void pool_free(pool_t *pool);
+
+/** @brief Tests for the pool module
+ *
+ * @param verbosity output level - 0 means nothing, 1 prints module names with
+ *                  the overall module result, and 2 prints also each test inside
+ *                  of the module
+ * @return 0 if success, 1 if failed
+ */
+int sigil_pool_self_test(int verbosity);
+
+#endif /* PDF_SIGIL_POOL_H */
@@ -11,9 +11,10 @@
  *         position in the PDF
  *
  * @param sgl context
+ * @param sig the signature with the position of its dictionary set
  * @return ERR_NONE if success
  */
-sigil_err_t process_sig_dict(sigil_t *sgl);
+sigil_err_t process_sig_dict(sigil_t *sgl, signature_t *sig);
 
 /** @brief Tests for the sig_dict module
  *
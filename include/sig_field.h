@@ -9,21 +9,22 @@
 
 /** @brief Go through all the objects mentioned in the Fields entry from the
  *         interactive form dictionary (AcroForm) and look for the signature
- *         field. If found, save the object reference inside the context
+ *         fields. A signature is added to the context for each one found
  *
  * @param sgl context
- * @return ERR_NONE if success
+ * @return ERR_NONE if success, ERR_NO_DATA if there is no signature field
  */
-sigil_err_t find_sig_field(sigil_t *sgl);
+sigil_err_t find_sig_fields(sigil_t *sgl);
 
 /** @brief Does processing of the signature field and saves the position of the
  *         signature dictionary (V entry). Doesn't depend on the current
  *         position in the PDF
  *
  * @param sgl context
- * @return ERR_NONE if success
+ * @param sig the signature with the reference to its field set
+ * @return ERR_NONE if success, ERR_NO_DATA if the field is not signed
  */
-sigil_err_t process_sig_field(sigil_t *sgl);
+sigil_err_t process_sig_field(sigil_t *sgl, signature_t *sig);
 
 /** @brief Tests for the sig_field module
  *
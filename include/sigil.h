@@ -7,6 +7,17 @@
 
 #include "types.h"
 
+/** @brief Sets the allocator used by the whole library (including zlib, but
+ *         not OpenSSL) for all the following allocations. Needs to be called
+ *         while no context exists, as the memory is released through the
+ *         allocator in use at that time.
+ *
+ * @param allocator input - allocator to be used, the structure is copied, NULL
+ *                  restores malloc, realloc and free of libc
+ * @return ERR_NONE if success, ERR_PARAMETER if a callback is missing
+ */
+sigil_err_t sigil_set_allocator(const sigil_allocator_t *allocator);
+
 /** @brief Does initialization of the provided context. Allocates the structure
  *         and sets default values
  *
@@ -15,9 +26,10 @@
  */
 sigil_err_t sigil_init(sigil_t **sgl);
 
-/** @brief Sets the provided file to the context. If the size is smaller than
- *         the THRESHOLD_FILE_BUFFERING, allocates a new buffer and makes a copy
- *         of the PDF data
+/** @brief Sets the provided file to the context. Where available, the file
+ *         is mapped read-only into memory. Otherwise, if the size is smaller
+ *         than the THRESHOLD_FILE_BUFFERING, allocates a new buffer and makes
+ *         a copy of the PDF data
  *
  * @param sgl context
  * @param pdf_file input - file pointer with the PDF data
@@ -25,6 +37,17 @@ sigil_err_t sigil_init(sigil_t **sgl);
  */
 sigil_err_t sigil_set_pdf_file(sigil_t *sgl, FILE *pdf_file);
 
+/** @brief Sets the provided file descriptor to the context. The file is mapped
+ *         into memory if possible, otherwise it is read with pread at the
+ *         position kept inside of the context. The descriptor is not closed
+ *         by the library and can be shared by multiple contexts or threads
+ *
+ * @param sgl context
+ * @param fd input - file descriptor opened for reading the PDF data
+ * @return ERR_NONE if success, ERR_NOT_IMPLEMENTED on Windows
+ */
+sigil_err_t sigil_set_pdf_fd(sigil_t *sgl, int fd);
+
 /** @brief Opens a file from the provided filepath and calls sigil_set_pdf_file
  *
  * @param sgl context
@@ -33,6 +56,17 @@ sigil_err_t sigil_set_pdf_file(sigil_t *sgl, FILE *pdf_file);
  */
 sigil_err_t sigil_set_pdf_path(sigil_t *sgl, const char *path_to_pdf);
 
+/** @brief Sets the provided reader as the source of the PDF data. If the
+ *         reader is able to borrow the whole document, the data are used
+ *         directly in memory, otherwise they are read through read_at. The
+ *         close callback (if set) is called during sigil_free
+ *
+ * @param sgl context
+ * @param reader input - reader to be used, the structure is copied
+ * @return ERR_NONE if success
+ */
+sigil_err_t sigil_set_pdf_reader(sigil_t *sgl, const sigil_reader_t *reader);
+
 /** @brief Sets the provided buffer with the PDF data to the context
  *
  * @param sgl context
@@ -70,15 +104,33 @@ sigil_err_t sigil_set_trusted_file(sigil_t *sgl, const char *path_to_file);
  */
 sigil_err_t sigil_set_trusted_dir(sigil_t *sgl, const char *path_to_dir);
 
-/** @brief Verifies the digital signature and saves the result in the context.
- *         In order to get the result, call sigil_get_result
+/** @brief Allows sigil_verify to verify the signatures of the document in
+ *         parallel - the certificate chains, the digests and the parts of the
+ *         signed data not shared with the other signatures. Only used when the
+ *         whole PDF is in memory (always the case with sigil_set_pdf_buffer),
+ *         the default is 1 (no threads). The allocator set by
+ *         sigil_set_allocator needs to be thread-safe then.
  *
  * @param sgl context
- * @return ERR_NONE if success (NOT the result of actual verification)
+ * @param threads maximum number of threads, limited to VERIFY_THREADS_MAX and
+ *                the number of processors and signatures
+ * @return ERR_NONE if success
+ */
+sigil_err_t sigil_set_verify_threads(sigil_t *sgl, size_t threads);
+
+/** @brief Verifies all the digital signatures of the document and saves the
+ *         results in the context. In order to get the result, call
+ *         sigil_get_result, or sigil_get_signature_result for each signature
+ *
+ * @param sgl context
+ * @return ERR_NONE if success (NOT the result of actual verification),
+ *         ERR_NOT_IMPLEMENTED if any of the signatures is of unsupported type
+ *         (the other ones are verified anyway)
  */
 sigil_err_t sigil_verify(sigil_t *sgl);
 
-/** @brief Get the result from the provided context
+/** @brief Get the result from the provided context, successful only if all
+ *         the signatures of the document are
  *
  * @param sgl context
  * @param result output - the result of digital signature verification,
@@ -87,8 +139,29 @@ sigil_err_t sigil_verify(sigil_t *sgl);
  */
 sigil_err_t sigil_get_result(sigil_t *sgl, int *result);
 
-/** @brief Get the result of a certificate validation phase from the provided
- *         context, CERT_STATUS_VERIFIED or CERT_STATUS_FAILED (constants.h)
+/** @brief Get the number of the signatures found in the document
+ *
+ * @param sgl context
+ * @param count output - number of the signed signature fields
+ * @return ERR_NONE if success
+ */
+sigil_err_t sigil_get_signature_count(sigil_t *sgl, size_t *count);
+
+/** @brief Get the result of one signature from the provided context, in the
+ *         order of the signature fields in the document
+ *
+ * @param sgl context
+ * @param index index of the signature, less than sigil_get_signature_count
+ * @param result output - the result of digital signature verification,
+ *               VERIFY_SUCCESS or VERIFY_FAILED (constants.h)
+ * @return ERR_NONE if success, ERR_NOT_IMPLEMENTED if the signature is of
+ *         unsupported type, or the error which stopped the verification of
+ *         this signature (the result is VERIFY_FAILED then)
+ */
+sigil_err_t sigil_get_signature_result(sigil_t *sgl, size_t index, int *result);
+
+/** @brief Get the result of a certificate validation phase of the first
+ *         signature, CERT_STATUS_VERIFIED or CERT_STATUS_FAILED (constants.h)
  *
  * @param sgl context
  * @param result output - result of the certificate validation
@@ -97,7 +170,7 @@ sigil_err_t sigil_get_result(sigil_t *sgl, int *result);
 sigil_err_t sigil_get_cert_validation_result(sigil_t *sgl, int *result);
 
 /** @brief Get the result of a data integrity (message digest comparison) phase
- *         from the provided context, HASH_CMP_RESULT_MATCH or
+ *         of the first signature, HASH_CMP_RESULT_MATCH or
  *         HASH_CMP_RESULT_DIFFER (constants.h)
  *
  * @param sgl context
@@ -106,7 +179,7 @@ sigil_err_t sigil_get_cert_validation_result(sigil_t *sgl, int *result);
  */
 sigil_err_t sigil_get_data_integrity_result(sigil_t *sgl, int *result);
 
-/** @brief Get the subfilter value from the provided context
+/** @brief Get the subfilter value of the first signature
  *
  * @param sgl context
  * @param subfilter output - the subfiter value
@@ -114,7 +187,8 @@ sigil_err_t sigil_get_data_integrity_result(sigil_t *sgl, int *result);
  */
 sigil_err_t sigil_get_subfilter(sigil_t *sgl, int *subfilter);
 
-/** @brief Get the hash function used for the integrity check
+/** @brief Get the hash function used for the integrity check of the first
+ *         signature
  *
  * @param sgl context
  * @param hash_fn output - used message digest function
@@ -122,8 +196,17 @@ sigil_err_t sigil_get_subfilter(sigil_t *sgl, int *subfilter);
  */
 sigil_err_t sigil_get_hash_fn(sigil_t *sgl, int *hash_fn);
 
-/** @brief Get the original message digest (from the signature) from the
- *         provided context
+/** @brief Get whether the cross-reference table had to be reconstructed by
+ *         scanning the file, because the one in the file was damaged
+ *
+ * @param sgl context
+ * @param result output - 1 if reconstructed, 0 otherwise
+ * @return ERR_NONE if success
+ */
+sigil_err_t sigil_get_xref_reconstructed(sigil_t *sgl, int *result);
+
+/** @brief Get the original message digest (from the signature) of the first
+ *         signature
  *
  * @param sgl context
  * @param digest output - the original message digest (from the signature)
@@ -131,7 +214,7 @@ sigil_err_t sigil_get_hash_fn(sigil_t *sgl, int *hash_fn);
  */
 sigil_err_t sigil_get_original_digest(sigil_t *sgl, ASN1_OCTET_STRING **digest);
 
-/** @brief Get the computed message digest from the provided context
+/** @brief Get the computed message digest of the first signature
  *
  * @param sgl context
  * @param digest output - the computed message digest
@@ -139,6 +222,15 @@ sigil_err_t sigil_get_original_digest(sigil_t *sgl, ASN1_OCTET_STRING **digest);
  */
 sigil_err_t sigil_get_computed_digest(sigil_t *sgl, ASN1_OCTET_STRING **digest);
 
+/** @brief Get the SHA-256 of the whole file, computed by sigil_verify in the
+ *         same pass as the message digests of the signatures
+ *
+ * @param sgl context
+ * @param digest output - the message digest, to be freed by the caller
+ * @return ERR_NONE if success, ERR_NO_DATA if not computed
+ */
+sigil_err_t sigil_get_file_digest(sigil_t *sgl, ASN1_OCTET_STRING **digest);
+
 /** @brief Print provided message digest to the standard output
  *
  * @param digest input - digest to be printed
@@ -158,6 +250,12 @@ void sigil_print_original_digest(sigil_t *sgl);
  */
 void sigil_print_computed_digest(sigil_t *sgl);
 
+/** @brief Print the SHA-256 of the whole file to the standard output
+ *
+ * @param sgl context
+ */
+void sigil_print_file_digest(sigil_t *sgl);
+
 /** @brief Print digital signature subfilter value to the standard output
  *
  * @param sgl context
@@ -176,6 +274,14 @@ void sigil_print_hash_fn(sigil_t *sgl);
  */
 void sigil_print_cert_info(sigil_t *sgl);
 
+/** @brief Clears the state of the processed document, so the context can be
+ *         used for another one (sigil_set_pdf_* needs to be called again).
+ *         The trusted certificates and the allocated buffers are kept.
+ *
+ * @param sgl context
+ */
+void sigil_reset(sigil_t *sgl);
+
 /** @brief Cleans-up the provided sigil context
  *
  * @param sgl context
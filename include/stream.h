@@ -0,0 +1,97 @@
+/** @file
+ *
+ */
+
+#ifndef PDF_SIGIL_STREAM_H
+#define PDF_SIGIL_STREAM_H
+
+#include <zlib.h>
+#include "types.h"
+
+/** @brief Decoder of the stream data (Flate filter and PNG predictors). The
+ *         encoded data are borrowed if available in memory, otherwise read in
+ *         chunks of STREAM_CHUNK_SIZE, and inflated in chunks of the same
+ *         size, so the whole stream is never held in memory at once
+ *
+ */
+typedef struct {
+    size_t         position;  // position of the next encoded byte to read
+    size_t         remaining; // number of encoded bytes not read yet
+    int            filter;    // STREAM_FILTER_*
+    size_t         predictor; // 1 means none, 10 and above PNG predictors
+    size_t         columns;
+    z_stream       zstream;
+    int            zstream_ready;
+    int            zstream_end;
+    char          *in;        // encoded data read, if not available in memory
+    char          *out;       // data inflated, before the predictor
+    size_t         out_pos;
+    size_t         out_size;
+    unsigned char *row;       // row with the PNG filter type byte
+    unsigned char *prev_row;  // the last decoded row
+    size_t         row_pos;   // bytes of the prev_row already provided
+} stream_t;
+
+/** @brief Sets default values - no filter and no predictor
+ *
+ * @param stream the stream to be initialized
+ */
+void stream_init(stream_t *stream);
+
+/** @brief Loads the value of /Filter from the current position in the PDF,
+ *         only the FlateDecode filter is supported
+ *
+ * @param sgl context
+ * @param stream output - the stream to set the filter for
+ * @return ERR_NONE if success, ERR_NOT_IMPLEMENTED for other filters
+ */
+sigil_err_t stream_parse_filter(sigil_t *sgl, stream_t *stream);
+
+/** @brief Loads the value of /DecodeParms from the current position in the PDF
+ *
+ * @param sgl context
+ * @param stream output - the stream to set the parameters for
+ * @return ERR_NONE if success
+ */
+sigil_err_t stream_parse_decode_parms(sigil_t *sgl, stream_t *stream);
+
+/** @brief Starts decoding the stream, the current position in the PDF needs to
+ *         be right after the stream dictionary (before the "stream" keyword)
+ *
+ * @param sgl context
+ * @param stream the stream with the filter and parameters set
+ * @param length value of /Length - number of encoded bytes
+ * @return ERR_NONE if success
+ */
+sigil_err_t stream_open(sigil_t *sgl, stream_t *stream, size_t length);
+
+/** @brief Reads *size* decoded bytes from the stream. May move the position
+ *         in PDF.
+ *
+ * @param sgl context
+ * @param stream the stream opened by stream_open
+ * @param result output buffer
+ * @param size number of bytes to read
+ * @param res_size output - number of bytes read, less than *size* only at the
+ *                 end of stream
+ * @return ERR_NONE if success, ERR_NO_DATA at the end of stream
+ */
+sigil_err_t stream_read(sigil_t *sgl, stream_t *stream, char *result,
+                        size_t size, size_t *res_size);
+
+/** @brief Clean-up of the stream decoder, the structure itself is not freed
+ *
+ * @param stream the stream
+ */
+void stream_free(stream_t *stream);
+
+/** @brief Tests for the stream module
+ *
+ * @param verbosity output level - 0 means nothing, 1 prints module names with
+ *                  the overall module result, and 2 prints also each test inside
+ *                  of the module
+ * @return 0 if success, 1 if failed
+ */
+int sigil_stream_self_test(int verbosity);
+
+#endif /* PDF_SIGIL_STREAM_H */
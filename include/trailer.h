@@ -15,6 +15,16 @@
  */
 sigil_err_t process_trailer(sigil_t *sgl);
 
+/** @brief Process one entry of the trailer dictionary (or the dictionary of
+ *         the cross-reference stream, which serves as the trailer), the
+ *         position in the PDF needs to be right after the key
+ *
+ * @param sgl context
+ * @param dict_key the key of the entry
+ * @return ERR_NONE if success
+ */
+sigil_err_t process_trailer_entry(sigil_t *sgl, dict_key_t dict_key);
+
 /** @brief Tests for trailer module
  *
  * @param verbosity output level - 0 means nothing, 1 prints module names with
@@ -7,7 +7,7 @@
 
 #include <openssl/evp.h> // EVP_MAX_MD_SIZE
 #include <openssl/x509.h>
-#include <stdint.h> // uint32_t
+#include <stdint.h> // uint8_t, uint32_t
 #include <stdio.h>
 
 
@@ -67,38 +67,215 @@ typedef struct {
     size_t capacity;
 } ref_array_t;
 
-/** @brief Type for one entry from a cross-reference section and pointer to the
- *         next one (linked list)
+/** @brief Type for an object which doesn't fit into the flat table - with
+ *         more than one generation in the cross-reference sections, or with
+ *         the object number far beyond the others or /Size; also the record
+ *         of an entry decoded from a cross-reference stream
  *
  */
-typedef struct xref_entry_t {
-    size_t byte_offset;
-    size_t generation_num;
-    struct xref_entry_t *next;
-} xref_entry_t;
+typedef struct {
+    size_t   object_num;
+    size_t   byte_offset;
+    uint32_t generation_num;
+    uint32_t section;
+    uint8_t  type;
+} xref_overflow_t;
 
-/** @brief Type for storing the entries from a cross-reference section
+/** @brief Type for a subsection of the cross-reference table that is not parsed
+ *         in advance, its fixed 20-byte entries are decoded on lookup
  *
  */
 typedef struct {
-    xref_entry_t **entry;
-    size_t         capacity;
-    size_t         size_from_trailer;
-    size_t         prev_section;
+    size_t   position; // position of the first entry
+    size_t   first_object;
+    size_t   count;
+    uint32_t section;
+} xref_subsection_t;
+
+/** @brief Type for a cross-reference stream whose dictionary has been read,
+ *         with everything needed for decoding its data later
+ *
+ */
+typedef struct {
+    size_t   position;    // position right after the stream dictionary
+    size_t   length;
+    int      filter;      // STREAM_FILTER_*
+    size_t   predictor;
+    size_t   columns;
+    size_t   width[3];    // widths of the fields of each entry
+    size_t  *index;       // pairs of the first object and number of entries
+    size_t   index_count;
+    uint32_t section;
+} xref_stream_t;
+
+/** @brief Type for storing the entries from all the cross-reference sections,
+ *         indexed by the object number (struct of arrays). Each entry keeps
+ *         the index of its section (0 is the newest one), so the entries
+ *         parsed in advance and the lazily decoded subsections can be
+ *         combined with the newest one winning
+ *
+ */
+typedef struct {
+    size_t            *byte_offset;
+    uint32_t          *generation_num;
+    uint32_t          *section;
+    uint8_t           *type; // XREF_ENTRY_*
+    size_t             capacity;
+    size_t             dense_count; // entries in the flat table
+    xref_overflow_t   *overflow;
+    size_t             overflow_count;
+    size_t             overflow_capacity;
+    xref_subsection_t *subsection;
+    size_t             subsection_count;
+    size_t             subsection_capacity;
+    size_t             section_count;
+    size_t             sections_left; // limit of sections still to be loaded
+    xref_stream_t     *stream; // streams waiting for process_xref_streams
+    size_t             stream_count;
+    size_t             stream_capacity;
+    size_t             size_from_trailer;
+    size_t             prev_section; // next older section to load, 0 if none
 } xref_t;
 
-/** @brief Type for storing the PDF data. Allowing both - the file pointer
- *         and the buffer
+/** @brief Memory allocator used by the library, set by sigil_set_allocator.
+ *         All three callbacks are mandatory and need to be thread-safe, as
+ *         the library may allocate from several threads at once
+ *
+ */
+typedef struct {
+    /** user data passed as the first argument of all the callbacks */
+    void  *ctx;
+    /** allocates *size* bytes, returns NULL on failure */
+    void *(*malloc)(void *ctx, size_t size);
+    /** resizes the allocation (or allocates if *ptr* is NULL), returns NULL
+     *  on failure and keeps the original allocation */
+    void *(*realloc)(void *ctx, void *ptr, size_t size);
+    /** releases the allocation, *ptr* may be NULL */
+    void  (*free)(void *ctx, void *ptr);
+} sigil_allocator_t;
+
+/** @brief Interface of a source of the PDF data. The read_at and get_size
+ *         callbacks are mandatory, borrow and close are optional (NULL)
+ *
+ */
+typedef struct {
+    /** user data passed as the first argument of all the callbacks */
+    void        *ctx;
+    /** reads up to *size* bytes from the *offset* into *result*, *res_size*
+     *  is set to the number of bytes read (0 at the end of data) */
+    sigil_err_t (*read_at)(void *ctx, size_t offset, char *result, size_t size,
+                           size_t *res_size);
+    /** sets *size* to the total number of bytes of the PDF data */
+    sigil_err_t (*get_size)(void *ctx, size_t *size);
+    /** returns a pointer to *size* bytes from the *offset*, valid until the
+     *  close is called, or NULL if these data are not available in memory */
+    const char *(*borrow)(void *ctx, size_t offset, size_t size);
+    /** releases the source, called during sigil_free */
+    void        (*close)(void *ctx);
+} sigil_reader_t;
+
+/** @brief Type for storing the PDF data. The data are accessed either directly
+ *         in the buffer (own copy, read-only memory mapping of the file, or
+ *         memory provided by the user), or through the reader with the window
+ *         caching the last block read
  *
  */
 typedef struct {
-    FILE    *file;
-    char    *buffer;
-    size_t   buf_pos;
-    size_t   size;
-    uint32_t deallocation_info;
+    FILE          *file;
+    const char    *buffer;
+    sigil_reader_t reader;
+    int            fd; // descriptor behind the reader, -1 if unknown
+    char          *window;
+    size_t         window_start;
+    size_t         window_size;
+    size_t         buf_pos; // current position, used also with the reader
+    size_t         size;
+    uint32_t       deallocation_info;
 } pdf_data_t;
 
+/** @brief Type for a decoded object stream with the positions of the objects
+ *         compressed inside
+ *
+ */
+typedef struct {
+    size_t  object_num; // object number of the object stream
+    char   *data;       // decoded stream data
+    size_t  size;
+    size_t *object;     // object numbers of the compressed objects
+    size_t *offset;     // positions of the compressed objects in the data
+    size_t  count;
+    size_t  last_use;
+} objstm_t;
+
+/** @brief Cache of the decoded object streams, the least recently used one
+ *         is replaced when full. While a compressed object is being parsed,
+ *         the decoded data take the place of the PDF data in the context, so
+ *         the same parsers work on both
+ *
+ */
+typedef struct {
+    objstm_t  *entry;              // OBJSTM_CACHE_SIZE entries, once needed
+    size_t     clock;
+    int        active;             // decoded data in place of the PDF data
+    pdf_data_t saved_pdf_data;
+    size_t     saved_offset_pdf_start;
+} objstm_cache_t;
+
+/** @brief Block of the arena, the allocations are served from it one after
+ *         another
+ *
+ */
+typedef struct arena_block_t {
+    struct arena_block_t *next;
+    size_t                size;     // usable bytes after the header
+    size_t                used;
+} arena_block_t;
+
+/** @brief Header in front of the arena allocation flagged as sensitive
+ *
+ */
+typedef struct arena_sensitive_t {
+    struct arena_sensitive_t *next;
+    size_t                    size;
+} arena_sensitive_t;
+
+/** @brief Region allocator for the data parsed from PDF, all of them are
+ *         released at once. Only the allocations flagged as sensitive are
+ *         zeroized on release.
+ *
+ */
+typedef struct {
+    arena_block_t     *block;      // the current block first
+    arena_sensitive_t *sensitive;  // to be zeroized on release
+    void              *last;       // the most recent allocation, may grow
+    arena_block_t     *last_block; // block of the most recent allocation
+    arena_block_t     *spare;      // blocks kept by arena_reset for reuse
+} arena_t;
+
+/** @brief State of one signature in the document - the signature field, its
+ *         dictionary with the extracted parts, and the results
+ *
+ */
+typedef struct {
+    int                subfilter_type;
+    int                hash_fn;
+    reference_t        ref_sig_dict;
+    reference_t        ref_sig_field;
+    size_t             offset_sig_dict; // direct dictionary in the field
+    // message digest
+    X509_ALGOR        *digest_algorithm;
+    ASN1_OCTET_STRING *digest_computed;
+    ASN1_OCTET_STRING *digest_original;
+    // extracted parts, in the arena of the context
+    range_t           *byte_range;
+    cert_t            *certificates;
+    contents_t        *contents;
+    // results of verification process
+    int                result_cert_verification;
+    int                result_digest_comparison;
+    sigil_err_t        err; // what stopped the verification of this signature
+} signature_t;
+
 /** @brief Sigil context for saving all the configuration, partial results during
  *         verification process, and the final result
  *
@@ -110,33 +287,28 @@ typedef struct {
     int                pdf_x; // version from PDF header - <x>.<y>
     int                pdf_y;
     size_t             sig_flags;
-    int                subfilter_type;
     int                xref_type;
-    int                hash_fn;
+    int                xref_reconstructed; // table rebuilt by scanning the file
     // indirect reference to pdf parts
     reference_t        ref_acroform;
     reference_t        ref_catalog_dict;
-    reference_t        ref_sig_dict;
-    reference_t        ref_sig_field;
     // offset to pdf parts
     size_t             offset_acroform;
     size_t             offset_pdf_start;
-    size_t             offset_sig_dict;
     size_t             offset_startxref;
-    // message digest
-    X509_ALGOR        *digest_algorithm;
-    ASN1_OCTET_STRING *digest_computed;
-    ASN1_OCTET_STRING *digest_original;
+    size_t            *offset_eof; // all the "%%EOF" near the end of file
+    size_t             eof_count;
     // extracted parts
     ref_array_t        fields;
-    range_t           *byte_range;
-    cert_t            *certificates;
-    contents_t        *contents;
+    signature_t       *signature; // signed signature fields, in the arena
+    size_t             signature_count;
+    size_t             signature_capacity;
+    ASN1_OCTET_STRING *file_digest; // SHA-256 of the whole file
     xref_t            *xref;
+    objstm_cache_t     objstm;
+    arena_t            arena;      // fields and signatures with their parts
     X509_STORE        *trusted_store;
-    // results of verification process
-    int                result_cert_verification;
-    int                result_digest_comparison;
+    size_t             verify_threads; // set by sigil_set_verify_threads
 } sigil_t;
 
 #endif /* PDF_SIGIL_TYPES_H */
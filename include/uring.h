@@ -0,0 +1,80 @@
+/** @file
+ *
+ */
+
+#ifndef PDF_SIGIL_URING_H
+#define PDF_SIGIL_URING_H
+
+#include <stdint.h> // uint64_t
+#include "types.h"
+
+/** @brief Minimal io_uring instance used for reading ahead, without any
+ *         dependency on liburing
+ *
+ */
+typedef struct {
+    int       fd;
+    unsigned *sq_head;
+    unsigned *sq_tail;
+    unsigned *sq_mask;
+    unsigned *sq_array;
+    unsigned *cq_head;
+    unsigned *cq_tail;
+    unsigned *cq_mask;
+    void     *sqes;
+    void     *cqes;
+    void     *sq_ring;
+    void     *cq_ring;
+    size_t    sq_ring_size;
+    size_t    cq_ring_size;
+    size_t    sqes_size;
+    unsigned  to_submit;
+} uring_t;
+
+/** @brief Sets up the io_uring instance. Fails with ERR_NOT_IMPLEMENTED if the
+ *         io_uring is not supported by the platform, kernel or the sandbox
+ *
+ * @param ring output - the instance to be initialized
+ * @param entries number of entries in the submission queue
+ * @return ERR_NONE if success
+ */
+sigil_err_t uring_init(uring_t *ring, unsigned entries);
+
+/** @brief Queues a read request, it is submitted by the next uring_wait
+ *
+ * @param ring the instance
+ * @param fd file descriptor to read from
+ * @param buffer output buffer
+ * @param size number of bytes to read
+ * @param offset position in the file
+ * @param user_data value returned with the completion of this request
+ * @return ERR_NONE if success
+ */
+sigil_err_t uring_queue_read(uring_t *ring, int fd, char *buffer, size_t size,
+                             size_t offset, uint64_t user_data);
+
+/** @brief Submits all the queued requests and waits for one completion
+ *
+ * @param ring the instance
+ * @param user_data output - user_data of the completed request
+ * @param result output - number of bytes read or negative errno value
+ * @return ERR_NONE if success
+ */
+sigil_err_t uring_wait(uring_t *ring, uint64_t *user_data, int *result);
+
+/** @brief Clean-up of the io_uring instance
+ *
+ * @param ring the instance
+ */
+void uring_free(uring_t *ring);
+
+/** @brief Tests for the uring module
+ *
+ * @param verbosity output level - 0 means nothing, 1 prints module names with
+ *                  the overall module result, and 2 prints also each test inside
+ *                  of the module
+ * @return 0 if success, 1 if failed
+ */
+int sigil_uring_self_test(int verbosity);
+
+#endif /* PDF_SIGIL_URING_H */
@@ -13,12 +13,49 @@
  */
 xref_t *xref_init(void);
 
+/** @brief Removes all the entries, keeping the allocated capacities for
+ *         the next document
+ *
+ * @param xref the structure to be reset
+ */
+void xref_reset(xref_t *xref);
+
 /** @brief Clean-up of the provided xref structure
  *
  * @param xref the structure to be freed
  */
 void xref_free(xref_t *xref);
 
+/** @brief Looks up the entry of the object in the cross-reference table of
+ *         the context, decoding the entries of lazily recorded subsections
+ *         if needed. Older sections (through /Prev) are loaded only if the
+ *         object is not found in the ones loaded so far. Does not move
+ *         the position in PDF.
+ *
+ * @param sgl context
+ * @param ref indirect reference to the object
+ * @param type output - XREF_ENTRY_IN_USE or XREF_ENTRY_COMPRESSED
+ * @param field_1 output - byte offset of the object, or the object number of
+ *                the object stream containing the compressed object
+ * @param field_2 output - generation number of the object, or the index of
+ *                the compressed object within the object stream
+ * @return ERR_NONE if success, ERR_NO_DATA if the object is not in the table
+ */
+sigil_err_t xref_get_entry(sigil_t *sgl, const reference_t *ref, uint8_t *type,
+                           size_t *field_1, size_t *field_2);
+
+/** @brief Looks up the byte offset of the object in the cross-reference table
+ *         of the context, decoding the entries of lazily recorded subsections
+ *         if needed. Does not move the position in PDF.
+ *
+ * @param sgl context
+ * @param ref indirect reference to the object
+ * @param result output - byte offset of the object
+ * @return ERR_NONE if success, ERR_NO_DATA if the object is not in the table,
+ *         ERR_NOT_IMPLEMENTED if the object is compressed in an object stream
+ */
+sigil_err_t xref_get_offset(sigil_t *sgl, const reference_t *ref, size_t *result);
+
 /** @brief Read the offset of the last cross-reference section
  *
  * @param sgl context
@@ -27,13 +64,59 @@ void xref_free(xref_t *xref);
 sigil_err_t read_startxref(sigil_t *sgl);
 
 /** @brief Does processing of the cross-reference section - determines type and
- *         reads the entries
+ *         reads the entries. Only the dictionary of a cross-reference stream
+ *         is read, its entries are added by process_xref_streams.
  *
  * @param sgl context
  * @return ERR_NONE if success
  */
 sigil_err_t process_xref(sigil_t *sgl);
 
+/** @brief Reads the dictionary of the cross-reference stream of the hybrid-
+ *         reference file (/XRefStm in the trailer). Its entries are added to
+ *         the section of the table by process_xref_streams, the entries of
+ *         the table take precedence. Does not move the position in PDF.
+ *
+ * @param sgl context
+ * @param position position of the cross-reference stream
+ * @return ERR_NONE if success
+ */
+sigil_err_t process_xref_stm(sigil_t *sgl, size_t position);
+
+/** @brief Loads up to *count* next older cross-reference sections, starting
+ *         from the xref->prev_section (the newest one is set by the caller),
+ *         including their trailers
+ *
+ * @param sgl context
+ * @param count maximum number of sections to load
+ * @return ERR_NONE if success, ERR_NO_DATA if there are no more sections
+ */
+sigil_err_t xref_load_sections(sigil_t *sgl, size_t count);
+
+/** @brief Decodes the data of all the cross-reference streams found so far by
+ *         process_xref, each into a separate table. These are decoded in
+ *         parallel (up to XREF_THREADS_MAX threads) if the PDF data are in
+ *         memory, and merged into the table of the context with the newest
+ *         entry winning.
+ *
+ * @param sgl context
+ * @return ERR_NONE if success
+ */
+sigil_err_t process_xref_streams(sigil_t *sgl);
+
+/** @brief Rebuilds the cross-reference table of a damaged file by a single
+ *         pass through the PDF data, looking for the object headers
+ *         "<object number> <generation number> obj". The last occurrence of
+ *         an object wins. The objects compressed in the object streams found
+ *         are added as well, and the catalog is taken from the newest
+ *         catalog or cross-reference stream found. Sets
+ *         sgl->xref_reconstructed, so it is done only once per verification.
+ *
+ * @param sgl context
+ * @return ERR_NONE if success, ERR_PDF_CONTENT if no catalog was found
+ */
+sigil_err_t xref_reconstruct(sigil_t *sgl);
+
 /** @brief For debugging purposes - print all the data from the provided
  *         cross-reference table
  *
@@ -0,0 +1,376 @@
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include "arena.h"
+#include "auxiliary.h"
+#include "config.h"
+#include "constants.h"
+#include "mem.h"
+#include "types.h"
+
+#define ARENA_ALIGNMENT   _Alignof(max_align_t)
+#define ARENA_ALIGN(size) (((size) + ARENA_ALIGNMENT - 1) & \
+                           ~(size_t)(ARENA_ALIGNMENT - 1))
+
+// the headers keep the memory after them aligned
+#define BLOCK_HEADER_SIZE     ARENA_ALIGN(sizeof(arena_block_t))
+#define SENSITIVE_HEADER_SIZE ARENA_ALIGN(sizeof(arena_sensitive_t))
+
+static char *block_data(arena_block_t *block)
+{
+    return (char *)block + BLOCK_HEADER_SIZE;
+}
+
+void arena_init(arena_t *arena)
+{
+    if (arena == NULL)
+        return;
+
+    arena->block = NULL;
+    arena->sensitive = NULL;
+    arena->last = NULL;
+    arena->last_block = NULL;
+    arena->spare = NULL;
+}
+
+/** @brief Serves *size* bytes from the current block, or from a new one if
+ *         there is not enough space left
+ *
+ */
+static void *arena_bump(arena_t *arena, size_t size)
+{
+    arena_block_t *block = arena->block,
+                  **spare;
+    size_t block_size;
+    void *result;
+
+    if (size > SIZE_MAX / 2)
+        return NULL;
+    size = ARENA_ALIGN(size);
+
+    if (block == NULL || block->size - block->used < size) {
+        // block kept by arena_reset, if large enough
+        for (spare = &(arena->spare); *spare != NULL; spare = &((*spare)->next)) {
+            if ((*spare)->size >= size)
+                break;
+        }
+
+        if (*spare != NULL) {
+            block = *spare;
+            *spare = block->next;
+        } else {
+            block_size = MAX(size, ARENA_BLOCK_SIZE);
+
+            // zeroed, the memory of the block is never served twice
+            block = mem_calloc(1, BLOCK_HEADER_SIZE + block_size);
+            if (block == NULL)
+                return NULL;
+
+            block->size = block_size;
+        }
+
+        // a block filled by this allocation goes behind the current one,
+        // which keeps serving the following allocations
+        if (arena->block != NULL &&
+            block->size - size < arena->block->size - arena->block->used)
+        {
+            block->next = arena->block->next;
+            arena->block->next = block;
+        } else {
+            block->next = arena->block;
+            arena->block = block;
+        }
+    }
+
+    result = block_data(block) + block->used;
+    block->used += size;
+
+    arena->last = result;
+    arena->last_block = block;
+
+    return result;
+}
+
+void *arena_alloc(arena_t *arena, size_t size, int sensitive)
+{
+    arena_sensitive_t *header;
+
+    if (arena == NULL || size <= 0)
+        return NULL;
+
+    if (!sensitive)
+        return arena_bump(arena, size);
+
+    if (size > SIZE_MAX / 2)
+        return NULL;
+
+    header = arena_bump(arena, SENSITIVE_HEADER_SIZE + size);
+    if (header == NULL)
+        return NULL;
+
+    header->size = size;
+    header->next = arena->sensitive;
+    arena->sensitive = header;
+
+    return (char *)header + SENSITIVE_HEADER_SIZE;
+}
+
+void *arena_realloc(arena_t *arena, void *ptr, size_t old_size, size_t size,
+                    int sensitive)
+{
+    arena_block_t *block;
+    char *start;
+    size_t total;
+    void *result;
+
+    if (arena == NULL)
+        return NULL;
+
+    if (ptr == NULL)
+        return arena_alloc(arena, size, sensitive);
+
+    if (size <= old_size)
+        return ptr;
+
+    if (size > SIZE_MAX / 2)
+        return NULL;
+
+    start = sensitive ? (char *)ptr - SENSITIVE_HEADER_SIZE : ptr;
+    total = ARENA_ALIGN((sensitive ? SENSITIVE_HEADER_SIZE : 0) + size);
+    block = arena->last_block;
+
+    // the most recent allocation is just extended, the bytes after it
+    // were never served
+    if (start == arena->last && block != NULL &&
+        total <= block->size - (size_t)(start - block_data(block)))
+    {
+        block->used = (size_t)(start - block_data(block)) + total;
+        if (sensitive)
+            ((arena_sensitive_t *)start)->size = size;
+
+        return ptr;
+    }
+
+    result = arena_alloc(arena, size, sensitive);
+    if (result == NULL)
+        return NULL;
+
+    memcpy(result, ptr, old_size);
+
+    return result;
+}
+
+static void zeroize_sensitive(arena_t *arena)
+{
+    for (arena_sensitive_t *s = arena->sensitive; s != NULL; s = s->next) {
+        sigil_zeroize((char *)s + SENSITIVE_HEADER_SIZE, s->size);
+    }
+
+    arena->sensitive = NULL;
+}
+
+void arena_reset(arena_t *arena)
+{
+    arena_block_t *block,
+                  *next;
+
+    if (arena == NULL)
+        return;
+
+    zeroize_sensitive(arena);
+
+    // only the used part needs to be zeroed again
+    block = arena->block;
+    while (block != NULL) {
+        next = block->next;
+
+        memset(block_data(block), 0, block->used);
+        block->used = 0;
+        block->next = arena->spare;
+        arena->spare = block;
+
+        block = next;
+    }
+
+    arena->block = NULL;
+    arena->last = NULL;
+    arena->last_block = NULL;
+}
+
+void arena_release(arena_t *arena)
+{
+    arena_block_t *block,
+                  *next;
+
+    if (arena == NULL)
+        return;
+
+    zeroize_sensitive(arena);
+
+    for (int i = 0; i < 2; i++) {
+        block = (i == 0) ? arena->block : arena->spare;
+        while (block != NULL) {
+            next = block->next;
+            mem_free(block);
+            block = next;
+        }
+    }
+
+    arena_init(arena);
+}
+
+int sigil_arena_self_test(int verbosity)
+{
+    arena_t arena;
+
+    arena_init(&arena);
+
+    print_module_name("arena", verbosity);
+
+    // TEST: fn arena_alloc
+    print_test_item("fn arena_alloc", verbosity);
+
+    {
+        arena_block_t *block;
+        char *a,
+             *b,
+             *c,
+             *large;
+
+        a = arena_alloc(&arena, 3, 0);
+        b = arena_alloc(&arena, 5, 1);
+        if (a == NULL || b == NULL || a == b ||
+            (size_t)a % ARENA_ALIGNMENT != 0 ||
+            (size_t)b % ARENA_ALIGNMENT != 0 ||
+            a[0] != 0 || a[2] != 0 || b[0] != 0 || b[4] != 0 ||
+            arena.sensitive == NULL || arena.sensitive->size != 5)
+        {
+            goto failed;
+        }
+
+        // block of its own, the current block stays in use
+        block = arena.block;
+        large = arena_alloc(&arena, ARENA_BLOCK_SIZE * 2, 0);
+        if (large == NULL || arena.block != block ||
+            arena.block->next == NULL || arena.block->next->next != NULL ||
+            arena.block->next->size != ARENA_BLOCK_SIZE * 2 ||
+            large[ARENA_BLOCK_SIZE * 2 - 1] != 0)
+        {
+            goto failed;
+        }
+
+        c = arena_alloc(&arena, 7, 0);
+        if (c == NULL || arena.block != block ||
+            c < block_data(block) ||
+            c >= block_data(block) + block->size)
+        {
+            goto failed;
+        }
+
+        if (arena_alloc(&arena, 0, 0) != NULL)
+            goto failed;
+
+        arena_release(&arena);
+        if (arena.block != NULL || arena.sensitive != NULL)
+            goto failed;
+    }
+
+    print_test_result(1, verbosity);
+
+    // TEST: fn arena_realloc
+    print_test_item("fn arena_realloc", verbosity);
+
+    {
+        char *a,
+             *b,
+             *c;
+
+        a = arena_alloc(&arena, 8, 1);
+        if (a == NULL)
+            goto failed;
+        memcpy(a, "1234567", 8);
+
+        // the most recent allocation grows in place
+        b = arena_realloc(&arena, a, 8, 64, 1);
+        if (b != a || arena.sensitive->size != 64 || b[63] != 0)
+            goto failed;
+
+        // otherwise copied
+        c = arena_alloc(&arena, 8, 0);
+        b = arena_realloc(&arena, a, 64, 128, 1);
+        if (c == NULL || b == NULL || b == a || strcmp(b, "1234567") != 0 ||
+            b[127] != 0 || arena.sensitive->size != 128 ||
+            arena.sensitive->next == NULL)
+        {
+            goto failed;
+        }
+
+        // over the size of the block
+        a = arena_realloc(&arena, b, 128, ARENA_BLOCK_SIZE * 4, 1);
+        if (a == NULL || strcmp(a, "1234567") != 0)
+            goto failed;
+
+        if (arena_realloc(&arena, NULL, 0, 16, 0) == NULL)
+            goto failed;
+
+        arena_release(&arena);
+    }
+
+    print_test_result(1, verbosity);
+
+    // TEST: fn arena_reset
+    print_test_item("fn arena_reset", verbosity);
+
+    {
+        arena_block_t *block;
+        char *a,
+             *b;
+
+        a = arena_alloc(&arena, 16, 1);
+        if (a == NULL)
+            goto failed;
+        memset(a, 'x', 16);
+        block = arena.block;
+
+        arena_reset(&arena);
+        if (arena.block != NULL || arena.sensitive != NULL ||
+            arena.spare != block)
+        {
+            goto failed;
+        }
+
+        // the same block again, zeroed
+        b = arena_alloc(&arena, 32, 0);
+        if (b == NULL || arena.block != block || arena.spare != NULL ||
+            b[0] != 0 || b[31] != 0)
+        {
+            goto failed;
+        }
+
+        // spare block too small for the allocation
+        arena_reset(&arena);
+        if (arena_alloc(&arena, ARENA_BLOCK_SIZE * 2, 0) == NULL ||
+            arena.block == block || arena.spare != block)
+        {
+            goto failed;
+        }
+
+        arena_release(&arena);
+        if (arena.block != NULL || arena.spare != NULL)
+            goto failed;
+    }
+
+    print_test_result(1, verbosity);
+
+    // all tests done
+    print_module_result(1, verbosity);
+    return 0;
+
+failed:
+    arena_release(&arena);
+
+    print_test_result(0, verbosity);
+    print_module_result(0, verbosity);
+
+    return 1;
+}
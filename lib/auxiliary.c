@@ -2,13 +2,61 @@
 #include <stdlib.h>
 #include <string.h>
 #include <types.h>
+#include "arena.h"
 #include "auxiliary.h"
 #include "config.h"
 #include "constants.h"
+#include "mem.h"
+#include "objstm.h"
 #include "sigil.h"
 #include "types.h"
-
-#define DICT_KEY_MAX   20
+#include "uring.h"
+#include "xref.h"
+
+#if defined(__AVX2__)
+    #include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+    #include <emmintrin.h>
+#endif
+
+// longest name among the known dictionary keys
+#define DICT_KEY_MAX   11
+
+#define CHAR_CLASS_WHITESPACE   0x01
+#define CHAR_CLASS_DIGIT        0x02
+#define CHAR_CLASS_DELIMITER    0x04
+
+/** @brief Classes of all the characters according to PDF standard
+ *
+ */
+static const unsigned char char_class[256] = {
+    [0x00] = CHAR_CLASS_WHITESPACE, // null
+    [0x09] = CHAR_CLASS_WHITESPACE, // horizontal tab
+    [0x0a] = CHAR_CLASS_WHITESPACE, // line feed
+    [0x0c] = CHAR_CLASS_WHITESPACE, // form feed
+    [0x0d] = CHAR_CLASS_WHITESPACE, // carriage return
+    [0x20] = CHAR_CLASS_WHITESPACE, // space
+    ['0']  = CHAR_CLASS_DIGIT,
+    ['1']  = CHAR_CLASS_DIGIT,
+    ['2']  = CHAR_CLASS_DIGIT,
+    ['3']  = CHAR_CLASS_DIGIT,
+    ['4']  = CHAR_CLASS_DIGIT,
+    ['5']  = CHAR_CLASS_DIGIT,
+    ['6']  = CHAR_CLASS_DIGIT,
+    ['7']  = CHAR_CLASS_DIGIT,
+    ['8']  = CHAR_CLASS_DIGIT,
+    ['9']  = CHAR_CLASS_DIGIT,
+    ['(']  = CHAR_CLASS_DELIMITER,
+    [')']  = CHAR_CLASS_DELIMITER,
+    ['<']  = CHAR_CLASS_DELIMITER,
+    ['>']  = CHAR_CLASS_DELIMITER,
+    ['[']  = CHAR_CLASS_DELIMITER,
+    [']']  = CHAR_CLASS_DELIMITER,
+    ['{']  = CHAR_CLASS_DELIMITER,
+    ['}']  = CHAR_CLASS_DELIMITER,
+    ['/']  = CHAR_CLASS_DELIMITER,
+    ['%']  = CHAR_CLASS_DELIMITER,
+};
 
 
 void sigil_zeroize(void *a, size_t bytes)
@@ -25,57 +73,283 @@ void sigil_zeroize(void *a, size_t bytes)
 
 int is_digit(const char c)
 {
-    return (c >= '0' && c <= '9');
+    return (char_class[(unsigned char)c] & CHAR_CLASS_DIGIT) != 0;
 }
 
 int is_whitespace(const char c)
 {
-    return (c == 0x00 || // null
-            c == 0x09 || // horizontal tab
-            c == 0x0a || // line feed
-            c == 0x0c || // form feed
-            c == 0x0d || // carriage return
-            c == 0x20);  // space
+    return (char_class[(unsigned char)c] & CHAR_CLASS_WHITESPACE) != 0;
+}
+
+int is_delimiter(const char c)
+{
+    return (char_class[(unsigned char)c] & CHAR_CLASS_DELIMITER) != 0;
+}
+
+#if defined(__AVX2__) || defined(__SSE2__) || defined(_M_X64)
+/** @brief Index of the lowest bit set in the non-zero mask
+ *
+ */
+static size_t first_bit(unsigned int mask)
+{
+    #ifdef _MSC_VER
+        unsigned long index;
+        _BitScanForward(&index, mask);
+        return index;
+    #else
+        return (size_t)__builtin_ctz(mask);
+    #endif
+}
+#endif
+
+size_t find_non_whitespace(const char *data, size_t size)
+{
+    size_t i = 0;
+
+    #if defined(__AVX2__)
+        const __m256i nul = _mm256_setzero_si256(),
+                      ht  = _mm256_set1_epi8(0x09),
+                      lf  = _mm256_set1_epi8(0x0a),
+                      ff  = _mm256_set1_epi8(0x0c),
+                      cr  = _mm256_set1_epi8(0x0d),
+                      sp  = _mm256_set1_epi8(0x20);
+
+        for (; i + 32 <= size; i += 32) {
+            __m256i v = _mm256_loadu_si256((const __m256i *)(data + i));
+            __m256i ws = _mm256_or_si256(
+                _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, nul),
+                                                _mm256_cmpeq_epi8(v, ht)),
+                                _mm256_or_si256(_mm256_cmpeq_epi8(v, lf),
+                                                _mm256_cmpeq_epi8(v, ff))),
+                _mm256_or_si256(_mm256_cmpeq_epi8(v, cr),
+                                _mm256_cmpeq_epi8(v, sp)));
+            unsigned int mask = ~(unsigned int)_mm256_movemask_epi8(ws);
+
+            if (mask != 0)
+                return i + first_bit(mask);
+        }
+    #elif defined(__SSE2__) || defined(_M_X64)
+        const __m128i nul = _mm_setzero_si128(),
+                      ht  = _mm_set1_epi8(0x09),
+                      lf  = _mm_set1_epi8(0x0a),
+                      ff  = _mm_set1_epi8(0x0c),
+                      cr  = _mm_set1_epi8(0x0d),
+                      sp  = _mm_set1_epi8(0x20);
+
+        for (; i + 16 <= size; i += 16) {
+            __m128i v = _mm_loadu_si128((const __m128i *)(data + i));
+            __m128i ws = _mm_or_si128(
+                _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, nul),
+                                          _mm_cmpeq_epi8(v, ht)),
+                             _mm_or_si128(_mm_cmpeq_epi8(v, lf),
+                                          _mm_cmpeq_epi8(v, ff))),
+                _mm_or_si128(_mm_cmpeq_epi8(v, cr),
+                             _mm_cmpeq_epi8(v, sp)));
+            unsigned int mask = ~(unsigned int)_mm_movemask_epi8(ws) & 0xffff;
+
+            if (mask != 0)
+                return i + first_bit(mask);
+        }
+    #endif
+
+    for (; i < size; i++) {
+        if (!(char_class[(unsigned char)data[i]] & CHAR_CLASS_WHITESPACE))
+            return i;
+    }
+
+    return size;
+}
+
+size_t find_delimiter(const char *data, size_t size)
+{
+    size_t i = 0;
+
+    #if defined(__AVX2__)
+        const __m256i lt = _mm256_set1_epi8('<'),
+                      gt = _mm256_set1_epi8('>'),
+                      lb = _mm256_set1_epi8('['),
+                      rb = _mm256_set1_epi8(']'),
+                      sl = _mm256_set1_epi8('/'),
+                      lp = _mm256_set1_epi8('('),
+                      pc = _mm256_set1_epi8('%');
+
+        for (; i + 32 <= size; i += 32) {
+            __m256i v = _mm256_loadu_si256((const __m256i *)(data + i));
+            __m256i dl = _mm256_or_si256(
+                _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, lt),
+                                                _mm256_cmpeq_epi8(v, gt)),
+                                _mm256_or_si256(_mm256_cmpeq_epi8(v, lb),
+                                                _mm256_cmpeq_epi8(v, rb))),
+                _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, sl),
+                                                _mm256_cmpeq_epi8(v, lp)),
+                                _mm256_cmpeq_epi8(v, pc)));
+            unsigned int mask = (unsigned int)_mm256_movemask_epi8(dl);
+
+            if (mask != 0)
+                return i + first_bit(mask);
+        }
+    #elif defined(__SSE2__) || defined(_M_X64)
+        const __m128i lt = _mm_set1_epi8('<'),
+                      gt = _mm_set1_epi8('>'),
+                      lb = _mm_set1_epi8('['),
+                      rb = _mm_set1_epi8(']'),
+                      sl = _mm_set1_epi8('/'),
+                      lp = _mm_set1_epi8('('),
+                      pc = _mm_set1_epi8('%');
+
+        for (; i + 16 <= size; i += 16) {
+            __m128i v = _mm_loadu_si128((const __m128i *)(data + i));
+            __m128i dl = _mm_or_si128(
+                _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, lt),
+                                          _mm_cmpeq_epi8(v, gt)),
+                             _mm_or_si128(_mm_cmpeq_epi8(v, lb),
+                                          _mm_cmpeq_epi8(v, rb))),
+                _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, sl),
+                                          _mm_cmpeq_epi8(v, lp)),
+                             _mm_cmpeq_epi8(v, pc)));
+            unsigned int mask = (unsigned int)_mm_movemask_epi8(dl);
+
+            if (mask != 0)
+                return i + first_bit(mask);
+        }
+    #endif
+
+    for (; i < size; i++) {
+        switch (data[i]) {
+            case '<':
+            case '>':
+            case '[':
+            case ']':
+            case '/':
+            case '(':
+            case '%':
+                return i;
+            default:
+                break;
+        }
+    }
+
+    return size;
+}
+
+/** @brief Reads the block containing the *position* into the window
+ *
+ * @param pdf_data the PDF data with a reader
+ * @param position position that needs to be available in the window
+ * @return ERR_NONE if success
+ */
+static sigil_err_t fill_window(pdf_data_t *pdf_data, size_t position)
+{
+    sigil_err_t err;
+    size_t processed;
+
+    if (pdf_data->window == NULL) {
+        pdf_data->window = mem_alloc(sizeof(*pdf_data->window) * READ_WINDOW_SIZE);
+        if (pdf_data->window == NULL)
+            return ERR_ALLOCATION;
+    }
+
+    pdf_data->window_start = position - position % READ_WINDOW_SIZE;
+    pdf_data->window_size = 0;
+
+    while (pdf_data->window_size < READ_WINDOW_SIZE) {
+        err = pdf_data->reader.read_at(pdf_data->reader.ctx,
+                                       pdf_data->window_start + pdf_data->window_size,
+                                       pdf_data->window + pdf_data->window_size,
+                                       READ_WINDOW_SIZE - pdf_data->window_size,
+                                       &processed);
+        if (err != ERR_NONE) {
+            pdf_data->window_size = 0;
+            return err;
+        }
+        if (processed <= 0)
+            break;
+        pdf_data->window_size += processed;
+    }
+
+    if (position >= pdf_data->window_start + pdf_data->window_size)
+        return ERR_NO_DATA;
+
+    return ERR_NONE;
 }
 
 sigil_err_t pdf_read(sigil_t *sgl, size_t size, char *result, size_t *res_size)
 {
+    sigil_err_t err;
+    pdf_data_t *pdf_data;
     size_t read_size;
-    size_t processed,
+    size_t position,
+           processed,
            total_processed;
 
     if (sgl == NULL || size == 0 || result == NULL || res_size == NULL)
         return ERR_PARAMETER;
 
-    if (sgl->pdf_data.buffer != NULL) {
-        read_size = MIN(size, sgl->pdf_data.size - sgl->pdf_data.buf_pos);
+    pdf_data = &(sgl->pdf_data);
+
+    if (pdf_data->buffer != NULL) {
+        read_size = MIN(size, pdf_data->size - pdf_data->buf_pos);
         if (read_size <= 0)
             return ERR_NO_DATA;
 
-        if (memcpy(result, &(sgl->pdf_data.buffer[sgl->pdf_data.buf_pos]),
+        if (memcpy(result, &(pdf_data->buffer[pdf_data->buf_pos]),
             read_size) != result)
         {
             return ERR_IO;
         }
         result[read_size] = '\0';
-        sgl->pdf_data.buf_pos += read_size;
+        pdf_data->buf_pos += read_size;
 
         *res_size = read_size;
 
         return ERR_NONE;
     }
 
-    if (sgl->pdf_data.file != NULL) {
+    if (pdf_data->reader.read_at != NULL) {
         total_processed = 0;
 
         while (total_processed < size) {
-            processed = fread(result + total_processed, sizeof(char), size,
-                              sgl->pdf_data.file);
+            position = pdf_data->buf_pos + total_processed;
+            if (position >= pdf_data->size)
+                break;
+
+            if (position < pdf_data->window_start ||
+                position >= pdf_data->window_start + pdf_data->window_size)
+            {
+                if (size - total_processed >= READ_WINDOW_SIZE) {
+                    // big reads are not worth caching
+                    err = pdf_data->reader.read_at(pdf_data->reader.ctx, position,
+                                                   result + total_processed,
+                                                   size - total_processed,
+                                                   &processed);
+                    if (err != ERR_NONE)
+                        return err;
+                    if (processed <= 0)
+                        break;
+                    total_processed += processed;
+                    continue;
+                }
+
+                err = fill_window(pdf_data, position);
+                if (err == ERR_NO_DATA)
+                    break;
+                if (err != ERR_NONE)
+                    return err;
+            }
+
+            processed = MIN(size - total_processed,
+                            pdf_data->window_start + pdf_data->window_size - position);
+            memcpy(result + total_processed,
+                   pdf_data->window + (position - pdf_data->window_start),
+                   processed);
             total_processed += processed;
-            if (processed <= 0 || total_processed * sizeof(char) > size)
-                return ERR_IO;
         }
+
+        if (total_processed <= 0)
+            return ERR_NO_DATA;
+
         result[total_processed] = '\0';
+        pdf_data->buf_pos += total_processed;
 
         *res_size = total_processed;
 
@@ -85,85 +359,508 @@ sigil_err_t pdf_read(sigil_t *sgl, size_t size, char *result, size_t *res_size)
     return ERR_NO_DATA;
 }
 
-sigil_err_t pdf_get_char(sigil_t *sgl, char *result)
+sigil_err_t pdf_borrow(sigil_t *sgl, size_t position, size_t length,
+                       const char **data)
 {
-    if (sgl == NULL || result == NULL)
+    pdf_data_t *pdf_data;
+
+    if (sgl == NULL || data == NULL)
         return ERR_PARAMETER;
 
-    if (sgl->pdf_data.buffer != NULL) {
-        if (sgl->pdf_data.buf_pos >= sgl->pdf_data.size)
-            return ERR_NO_DATA;
+    pdf_data = &(sgl->pdf_data);
+    position += sgl->offset_pdf_start;
 
-        *result = sgl->pdf_data.buffer[(sgl->pdf_data.buf_pos)++];
+    if (position > pdf_data->size || length > pdf_data->size - position)
+        return ERR_NO_DATA;
+
+    if (pdf_data->buffer != NULL) {
+        *data = pdf_data->buffer + position;
         return ERR_NONE;
     }
 
-    if (sgl->pdf_data.file != NULL) {
-        *result = (char)getc(sgl->pdf_data.file);
-        if (*result == EOF)
+    if (pdf_data->reader.borrow != NULL) {
+        *data = pdf_data->reader.borrow(pdf_data->reader.ctx, position, length);
+        if (*data != NULL)
+            return ERR_NONE;
+    }
+
+    return ERR_NO_DATA;
+}
+
+sigil_err_t pdf_view(sigil_t *sgl, size_t position, size_t length,
+                     const char **data, char **copy)
+{
+    sigil_err_t err;
+    size_t read_size;
+
+    if (sgl == NULL || length <= 0 || data == NULL || copy == NULL)
+        return ERR_PARAMETER;
+
+    *copy = NULL;
+
+    if (pdf_borrow(sgl, position, length, data) == ERR_NONE)
+        return ERR_NONE;
+
+    *copy = mem_alloc(sizeof(**copy) * (length + 1));
+    if (*copy == NULL)
+        return ERR_ALLOCATION;
+    sigil_zeroize(*copy, sizeof(**copy) * (length + 1));
+
+    err = pdf_move_pos_abs(sgl, position);
+    if (err != ERR_NONE)
+        goto failed;
+
+    err = pdf_read(sgl, length, *copy, &read_size);
+    if (err != ERR_NONE)
+        goto failed;
+
+    if (read_size != length) {
+        err = ERR_NO_DATA;
+        goto failed;
+    }
+
+    *data = *copy;
+
+    return ERR_NONE;
+
+failed:
+    mem_free(*copy);
+    *copy = NULL;
+
+    return err;
+}
+
+size_t find_str(const char *data, size_t size, const char *str, size_t str_size)
+{
+    const char *found;
+    size_t i = 0;
+    unsigned int mask;
+
+    if (str_size <= 0 || str_size > size)
+        return size;
+
+    // candidates matching both the first and the last character of the str
+    #if defined(__AVX2__)
+        const __m256i first = _mm256_set1_epi8(str[0]),
+                      last  = _mm256_set1_epi8(str[str_size - 1]);
+
+        for (; i + str_size - 1 + 32 <= size; i += 32) {
+            __m256i f = _mm256_loadu_si256((const __m256i *)(data + i)),
+                    l = _mm256_loadu_si256((const __m256i *)(data + i + str_size - 1));
+            mask = (unsigned int)_mm256_movemask_epi8(
+                _mm256_and_si256(_mm256_cmpeq_epi8(f, first),
+                                 _mm256_cmpeq_epi8(l, last)));
+
+            for (; mask != 0; mask &= mask - 1) {
+                if (memcmp(data + i + first_bit(mask), str, str_size) == 0)
+                    return i + first_bit(mask);
+            }
+        }
+    #elif defined(__SSE2__) || defined(_M_X64)
+        const __m128i first = _mm_set1_epi8(str[0]),
+                      last  = _mm_set1_epi8(str[str_size - 1]);
+
+        for (; i + str_size - 1 + 16 <= size; i += 16) {
+            __m128i f = _mm_loadu_si128((const __m128i *)(data + i)),
+                    l = _mm_loadu_si128((const __m128i *)(data + i + str_size - 1));
+            mask = (unsigned int)_mm_movemask_epi8(
+                _mm_and_si128(_mm_cmpeq_epi8(f, first),
+                              _mm_cmpeq_epi8(l, last)));
+
+            for (; mask != 0; mask &= mask - 1) {
+                if (memcmp(data + i + first_bit(mask), str, str_size) == 0)
+                    return i + first_bit(mask);
+            }
+        }
+    #endif
+    (void)mask;
+
+    while (i <= size - str_size) {
+        found = memchr(data + i, str[0], size - str_size + 1 - i);
+        if (found == NULL)
+            break;
+
+        i = (size_t)(found - data);
+        if (memcmp(found, str, str_size) == 0)
+            return i;
+        i++;
+    }
+
+    return size;
+}
+
+size_t find_str_reverse(const char *data, size_t size, const char *str,
+                        size_t str_size)
+{
+    size_t i;
+
+    if (str_size <= 0 || str_size > size)
+        return size;
+
+    for (i = size - str_size + 1; i-- > 0; ) {
+        if (data[i] == str[0] && memcmp(data + i, str, str_size) == 0)
+            return i;
+    }
+
+    return size;
+}
+
+/** @brief Reads the whole block through the reader
+ *
+ * @param pdf_data the PDF data with a reader
+ * @param position position of the block
+ * @param result output buffer
+ * @param size number of bytes
+ * @return ERR_NONE if success
+ */
+static sigil_err_t read_block(pdf_data_t *pdf_data, size_t position,
+                              char *result, size_t size)
+{
+    sigil_err_t err;
+    size_t processed,
+           total_processed = 0;
+
+    while (total_processed < size) {
+        err = pdf_data->reader.read_at(pdf_data->reader.ctx,
+                                       position + total_processed,
+                                       result + total_processed,
+                                       size - total_processed, &processed);
+        if (err != ERR_NONE)
+            return err;
+        if (processed <= 0)
             return ERR_NO_DATA;
+        total_processed += processed;
+    }
+
+    return ERR_NONE;
+}
+
+/** @brief Waits for the reads still in flight, so that the buffers are not
+ *         written by the kernel any more
+ *
+ * @param ring io_uring instance
+ * @param in_flight number of reads submitted or queued, but not completed
+ * @return ERR_NONE if success
+ */
+static sigil_err_t drain_uring(uring_t *ring, size_t in_flight)
+{
+    sigil_err_t err;
+    uint64_t user_data;
+    int result;
+
+    for (; in_flight > 0; in_flight--) {
+        err = uring_wait(ring, &user_data, &result);
+        if (err != ERR_NONE)
+            return err;
+    }
+
+    return ERR_NONE;
+}
+
+/** @brief Reads the blocks of the range through io_uring, keeping up to
+ *         READ_AHEAD_DEPTH of them in flight. Returns with all of them
+ *         completed, also on failure.
+ *
+ * @param pdf_data the PDF data with a file descriptor
+ * @param ring initialized io_uring instance
+ * @param blocks READ_AHEAD_DEPTH buffers of READ_AHEAD_SIZE bytes
+ * @param position starting position of the range
+ * @param length number of bytes
+ * @param consume callback receiving the data
+ * @param arg first argument of the callback
+ * @param drained output - 0 if some of the reads could not be waited for
+ * @return ERR_NONE if success
+ */
+static sigil_err_t read_ahead_uring(pdf_data_t *pdf_data, uring_t *ring,
+                                    char *blocks, size_t position, size_t length,
+                                    consume_fn_t consume, void *arg,
+                                    int *drained)
+{
+    sigil_err_t err;
+    size_t block_cnt,
+           next_submit = 0,
+           next_consume = 0,
+           in_flight = 0,
+           block_size;
+    int ready[READ_AHEAD_DEPTH];
+    uint64_t user_data;
+    int result;
+
+    *drained = 1;
+    block_cnt = (length + READ_AHEAD_SIZE - 1) / READ_AHEAD_SIZE;
+
+    while (next_consume < block_cnt) {
+        // keep the queue full
+        while (next_submit < block_cnt &&
+               next_submit - next_consume < READ_AHEAD_DEPTH)
+        {
+            block_size = MIN(READ_AHEAD_SIZE,
+                             length - next_submit * READ_AHEAD_SIZE);
+
+            err = uring_queue_read(ring, pdf_data->fd,
+                                   blocks + (next_submit % READ_AHEAD_DEPTH) * READ_AHEAD_SIZE,
+                                   block_size,
+                                   position + next_submit * READ_AHEAD_SIZE,
+                                   next_submit);
+            if (err != ERR_NONE)
+                goto failed;
+
+            in_flight++;
+            ready[next_submit % READ_AHEAD_DEPTH] = 0;
+            next_submit++;
+        }
+
+        // pass the blocks in order as soon as they are available
+        if (ready[next_consume % READ_AHEAD_DEPTH]) {
+            block_size = MIN(READ_AHEAD_SIZE,
+                             length - next_consume * READ_AHEAD_SIZE);
+
+            err = consume(arg,
+                          blocks + (next_consume % READ_AHEAD_DEPTH) * READ_AHEAD_SIZE,
+                          block_size);
+            if (err != ERR_NONE)
+                goto failed;
+
+            next_consume++;
+            continue;
+        }
+
+        err = uring_wait(ring, &user_data, &result);
+        if (err != ERR_NONE) {
+            *drained = 0;
+            return err;
+        }
+
+        in_flight--;
+        block_size = MIN(READ_AHEAD_SIZE, length - user_data * READ_AHEAD_SIZE);
+
+        // failed or short read (e.g. the operation not supported by an old
+        // kernel), read the rest synchronously
+        if (result < 0 || (size_t)result < block_size) {
+            result = MAX(result, 0);
+            err = read_block(pdf_data,
+                             position + user_data * READ_AHEAD_SIZE + result,
+                             blocks + (user_data % READ_AHEAD_DEPTH) * READ_AHEAD_SIZE + result,
+                             block_size - result);
+            if (err != ERR_NONE)
+                goto failed;
+        }
+
+        ready[user_data % READ_AHEAD_DEPTH] = 1;
+    }
+
+    return ERR_NONE;
+
+failed:
+    if (drain_uring(ring, in_flight) != ERR_NONE)
+        *drained = 0;
+
+    return err;
+}
+
+void read_ahead_init(read_ahead_t *ahead)
+{
+    if (ahead == NULL)
+        return;
+
+    ahead->blocks = NULL;
+    ahead->ring.fd = -1;
+    ahead->ring_state = 0;
+}
+
+void read_ahead_free(read_ahead_t *ahead)
+{
+    if (ahead == NULL)
+        return;
+
+    if (ahead->ring_state > 0)
+        uring_free(&(ahead->ring));
+
+    mem_free(ahead->blocks);
+    read_ahead_init(ahead);
+}
+
+sigil_err_t pdf_read_ahead(sigil_t *sgl, read_ahead_t *ahead, size_t position,
+                           size_t length, consume_fn_t consume, void *arg)
+{
+    sigil_err_t err;
+    pdf_data_t *pdf_data;
+    size_t block_size;
+    int drained;
+
+    if (sgl == NULL || ahead == NULL || consume == NULL)
+        return ERR_PARAMETER;
+
+    pdf_data = &(sgl->pdf_data);
+
+    if (pdf_data->reader.read_at == NULL)
+        return ERR_NO_DATA;
+
+    position += sgl->offset_pdf_start;
+
+    if (position > pdf_data->size || length > pdf_data->size - position)
+        return ERR_NO_DATA;
+
+    if (length == 0)
         return ERR_NONE;
+
+    if (ahead->blocks == NULL) {
+        ahead->blocks = mem_alloc(sizeof(*ahead->blocks) * READ_AHEAD_SIZE *
+                                  READ_AHEAD_DEPTH);
+        if (ahead->blocks == NULL)
+            return ERR_ALLOCATION;
     }
 
-    return ERR_NO_DATA;
+    if (pdf_data->fd >= 0 && length > READ_AHEAD_SIZE && ahead->ring_state == 0) {
+        if (uring_init(&(ahead->ring), READ_AHEAD_DEPTH) == ERR_NONE) {
+            ahead->ring_state = 1;
+        } else {
+            ahead->ring_state = -1;
+        }
+    }
+
+    if (pdf_data->fd >= 0 && length > READ_AHEAD_SIZE && ahead->ring_state > 0) {
+        err = read_ahead_uring(pdf_data, &(ahead->ring), ahead->blocks, position,
+                               length, consume, arg, &drained);
+
+        // the kernel may still write into the blocks, keep them allocated
+        // and never use them again
+        if (!drained) {
+            ahead->blocks = NULL;
+            uring_free(&(ahead->ring));
+            ahead->ring_state = -1;
+        }
+
+        return err;
+    }
+
+    // synchronous fallback
+    while (length > 0) {
+        block_size = MIN(READ_AHEAD_SIZE, length);
+
+        err = read_block(pdf_data, position, ahead->blocks, block_size);
+        if (err != ERR_NONE)
+            return err;
+
+        err = consume(arg, ahead->blocks, block_size);
+        if (err != ERR_NONE)
+            return err;
+
+        position += block_size;
+        length -= block_size;
+    }
+
+    return ERR_NONE;
+}
+
+sigil_err_t pdf_get_char(sigil_t *sgl, char *result)
+{
+    sigil_err_t err;
+
+    err = pdf_peek_char(sgl, result);
+    if (err != ERR_NONE)
+        return err;
+
+    (sgl->pdf_data.buf_pos)++;
+
+    return ERR_NONE;
 }
 
 sigil_err_t pdf_peek_char(sigil_t *sgl, char *result)
 {
     sigil_err_t err;
+    pdf_data_t *pdf_data;
 
     if (sgl == NULL || result == NULL)
         return ERR_PARAMETER;
 
-    err = pdf_get_char(sgl, result);
-    if (err != ERR_NONE)
-        return err;
+    pdf_data = &(sgl->pdf_data);
 
-    if (sgl->pdf_data.buffer != NULL) {
-        if (--(sgl->pdf_data.buf_pos) < 0)
-            return ERR_IO;
+    if (pdf_data->buf_pos >= pdf_data->size)
+        return ERR_NO_DATA;
+
+    if (pdf_data->buffer != NULL) {
+        *result = pdf_data->buffer[pdf_data->buf_pos];
         return ERR_NONE;
     }
 
-    if (sgl->pdf_data.file != NULL) {
-        if (ungetc(*result, sgl->pdf_data.file) != *result)
-            return ERR_IO;
+    if (pdf_data->reader.read_at != NULL) {
+        if (pdf_data->buf_pos < pdf_data->window_start ||
+            pdf_data->buf_pos >= pdf_data->window_start + pdf_data->window_size)
+        {
+            err = fill_window(pdf_data, pdf_data->buf_pos);
+            if (err != ERR_NONE)
+                return err;
+        }
+
+        *result = pdf_data->window[pdf_data->buf_pos - pdf_data->window_start];
         return ERR_NONE;
     }
 
     return ERR_NO_DATA;
 }
 
-sigil_err_t pdf_move_pos_rel(sigil_t *sgl, ssize_t shift_bytes)
+/** @brief Provides the data available in memory from the current position
+ *         onwards (till the end of buffer or the read window), without moving
+ *         the position in PDF
+ *
+ * @param sgl context
+ * @param span output - pointer to the data at the current position
+ * @param span_size output - number of bytes available, at least 1
+ * @return ERR_NONE if success, ERR_NO_DATA at the end of data
+ */
+static sigil_err_t pdf_peek_span(sigil_t *sgl, const char **span, size_t *span_size)
 {
-    ssize_t final_position;
+    sigil_err_t err;
+    pdf_data_t *pdf_data = &(sgl->pdf_data);
 
-    if (sgl == NULL)
-        return ERR_PARAMETER;
+    if (pdf_data->buf_pos >= pdf_data->size)
+        return ERR_NO_DATA;
 
-    if (shift_bytes == 0)
+    if (pdf_data->buffer != NULL) {
+        *span = pdf_data->buffer + pdf_data->buf_pos;
+        *span_size = pdf_data->size - pdf_data->buf_pos;
         return ERR_NONE;
+    }
 
-    if (sgl->pdf_data.buffer != NULL) {
-        final_position = sgl->pdf_data.buf_pos + shift_bytes;
-        if (final_position < sgl->offset_pdf_start) {
-            final_position = sgl->offset_pdf_start;
-        } else if ((size_t)final_position > sgl->pdf_data.size - 1) {
-            final_position = sgl->pdf_data.size - 1;
+    if (pdf_data->reader.read_at != NULL) {
+        if (pdf_data->buf_pos < pdf_data->window_start ||
+            pdf_data->buf_pos >= pdf_data->window_start + pdf_data->window_size)
+        {
+            err = fill_window(pdf_data, pdf_data->buf_pos);
+            if (err != ERR_NONE)
+                return err;
         }
 
-        sgl->pdf_data.buf_pos = (size_t)final_position;
-
+        *span = pdf_data->window + (pdf_data->buf_pos - pdf_data->window_start);
+        *span_size = pdf_data->window_start + pdf_data->window_size
+                     - pdf_data->buf_pos;
         return ERR_NONE;
     }
 
-    if (sgl->pdf_data.file != NULL) {
-        if (fseek(sgl->pdf_data.file, shift_bytes, SEEK_CUR) != 0)
-            return ERR_IO;
+    return ERR_NO_DATA;
+}
+
+sigil_err_t pdf_move_pos_rel(sigil_t *sgl, ssize_t shift_bytes)
+{
+    ssize_t final_position;
+
+    if (sgl == NULL)
+        return ERR_PARAMETER;
+
+    if (shift_bytes == 0)
         return ERR_NONE;
+
+    final_position = sgl->pdf_data.buf_pos + shift_bytes;
+    if (final_position < sgl->offset_pdf_start) {
+        final_position = sgl->offset_pdf_start;
+    } else if ((size_t)final_position > sgl->pdf_data.size) {
+        final_position = sgl->pdf_data.size;
     }
 
-    return ERR_NO_DATA;
+    sgl->pdf_data.buf_pos = (size_t)final_position;
+
+    return ERR_NONE;
 }
 
 // shifts position to absolute position in file
@@ -174,34 +871,63 @@ sigil_err_t pdf_move_pos_abs(sigil_t *sgl, size_t position)
     if (sgl == NULL)
         return ERR_PARAMETER;
 
+    if (sgl->pdf_data.size <= 0)
+        return ERR_NO_DATA;
+
     final_position = position + sgl->offset_pdf_start;
 
-    if (sgl->pdf_data.buffer != NULL) {
-        if (final_position > sgl->pdf_data.size - 1)
-            return ERR_IO;
+    if (final_position > sgl->pdf_data.size - 1)
+        return ERR_IO;
 
-        sgl->pdf_data.buf_pos = final_position;
+    sgl->pdf_data.buf_pos = final_position;
 
-        return ERR_NONE;
-    }
+    return ERR_NONE;
+}
 
-    if (sgl->pdf_data.file != NULL) {
-        if (fseek(sgl->pdf_data.file, final_position, SEEK_SET) != 0)
-            return ERR_IO;
+/** @brief Moves the position to the object by its entry in the cross-reference
+ *         table, checking the object header
+ *
+ * @param sgl context
+ * @param ref indirect reference to the object
+ * @return ERR_NONE if success, ERR_NO_DATA if the object is not in the table,
+ *         ERR_PDF_CONTENT if the header at the offset from the table doesn't
+ *         match
+ */
+static sigil_err_t goto_obj_entry(sigil_t *sgl, reference_t *ref)
+{
+    sigil_err_t err;
+    uint8_t type;
+    size_t offset,
+           tmp;
 
-        return ERR_NONE;
+    // the object positions in the table are all relative to the PDF data
+    objstm_leave(sgl);
+
+    err = xref_get_entry(sgl, ref, &type, &offset, &tmp);
+    if (err != ERR_NONE)
+        return err;
+
+    // compressed object has no "obj" header, tmp is the index in the stream
+    if (type == XREF_ENTRY_COMPRESSED)
+        return objstm_goto_obj(sgl, offset, tmp, ref);
+
+    // also the offset out of the file is a mismatch, not a missing object
+    if (pdf_move_pos_abs(sgl, offset) != ERR_NONE ||
+        parse_number(sgl, &tmp) != ERR_NONE || tmp != ref->object_num ||
+        parse_number(sgl, &tmp) != ERR_NONE || tmp != ref->generation_num ||
+        skip_word(sgl, "obj") != ERR_NONE)
+    {
+        return ERR_PDF_CONTENT;
     }
 
-    return ERR_NO_DATA;
+    return ERR_NONE;
 }
 
 sigil_err_t pdf_goto_obj(sigil_t *sgl, reference_t *ref)
 {
     sigil_err_t err;
-    size_t offset,
-           tmp;
 
-    if (sgl == NULL || ref == NULL)
+    if (sgl == NULL || ref == NULL || sgl->xref == NULL)
         return ERR_PARAMETER;
 
     if (ref->object_num <= 0 &&
@@ -210,96 +936,208 @@ sigil_err_t pdf_goto_obj(sigil_t *sgl, reference_t *ref)
         return ERR_NO_DATA;
     }
 
-    err = reference_to_offset(sgl, ref, &offset);
-    if (err != ERR_NONE)
-        return err;
+    err = goto_obj_entry(sgl, ref);
 
-    err = pdf_move_pos_abs(sgl, offset);
-    if (err != ERR_NONE)
-        return err;
+    // the table doesn't match the file, it is reconstructed (only once) - not
+    // for a reference to an object missing in the table
+    if ((err == ERR_PDF_CONTENT || err == ERR_IO) && !sgl->xref_reconstructed)
+    {
+        err = xref_reconstruct(sgl);
+        if (err != ERR_NONE)
+            return err;
 
-    err = parse_number(sgl, &tmp);
-    if (err != ERR_NONE)
-        return err;
-    if (tmp != ref->object_num)
-        return ERR_PDF_CONTENT;
+        err = goto_obj_entry(sgl, ref);
+    }
 
-    err = parse_number(sgl, &tmp);
-    if (err != ERR_NONE)
-        return err;
-    if (tmp != ref->generation_num)
-        return ERR_PDF_CONTENT;
+    return err;
+}
 
-    err = skip_word(sgl, "obj");
-    if (err != ERR_NONE)
-        return err;
+sigil_err_t get_curr_position(sigil_t *sgl, size_t *result)
+{
+    if (sgl == NULL || result == NULL)
+        return ERR_PARAMETER;
+
+    if (sgl->offset_pdf_start > sgl->pdf_data.buf_pos)
+        return ERR_IO;
+
+    *result = sgl->pdf_data.buf_pos - sgl->offset_pdf_start;
 
     return ERR_NONE;
 }
 
-sigil_err_t get_curr_position(sigil_t *sgl, size_t *result)
+sigil_err_t skip_leading_whitespaces(sigil_t *sgl)
 {
-    long file_position;
+    sigil_err_t err;
+    const char *span;
+    size_t span_size,
+           skipped;
 
-    if (sgl == NULL || result == NULL)
+    if (sgl == NULL)
         return ERR_PARAMETER;
 
-    if (sgl->pdf_data.buffer != NULL) {
-        if (sgl->offset_pdf_start > sgl->pdf_data.buf_pos)
-            return ERR_IO;
-
-        *result = sgl->pdf_data.buf_pos - sgl->offset_pdf_start;
+    while ((err = pdf_peek_span(sgl, &span, &span_size)) == ERR_NONE) {
+        skipped = find_non_whitespace(span, span_size);
+        sgl->pdf_data.buf_pos += skipped;
 
-        return ERR_NONE;
+        if (skipped < span_size)
+            return ERR_NONE;
     }
 
-    if (sgl->pdf_data.file != NULL) {
+    return err;
+}
 
-        file_position = ftell(sgl->pdf_data.file);
-        if (file_position < 0 || sgl->offset_pdf_start > file_position)
-            return ERR_IO;
+/** @brief Move position in the PDF forward to the next delimiter (one of
+ *         "<>[]/(%"), but not after it
+ *
+ * @param sgl context
+ * @param result output - the delimiter found
+ * @return ERR_NONE if success
+ */
+static sigil_err_t skip_to_delimiter(sigil_t *sgl, char *result)
+{
+    sigil_err_t err;
+    const char *span;
+    size_t span_size,
+           skipped;
 
-        *result = file_position - sgl->offset_pdf_start;
+    while ((err = pdf_peek_span(sgl, &span, &span_size)) == ERR_NONE) {
+        skipped = find_delimiter(span, span_size);
+        sgl->pdf_data.buf_pos += skipped;
 
-        return ERR_NONE;
+        if (skipped < span_size) {
+            *result = span[skipped];
+            return ERR_NONE;
+        }
     }
 
-    return ERR_NO_DATA;
+    return err;
 }
 
-sigil_err_t skip_leading_whitespaces(sigil_t *sgl)
+/** @brief Move position in the PDF after the first occurence of the character
+ *
+ * @param sgl context
+ * @param c the character to look for
+ * @return ERR_NONE if success
+ */
+static sigil_err_t skip_after_char(sigil_t *sgl, char c)
 {
     sigil_err_t err;
-    char c;
-
-    while((err = pdf_peek_char(sgl, &c)) == ERR_NONE) {
-        if (!is_whitespace(c))
+    const char *span,
+               *found;
+    size_t span_size;
+
+    while ((err = pdf_peek_span(sgl, &span, &span_size)) == ERR_NONE) {
+        found = memchr(span, c, span_size);
+        if (found != NULL) {
+            sgl->pdf_data.buf_pos += (size_t)(found - span) + 1;
             return ERR_NONE;
+        }
 
-        err = pdf_move_pos_rel(sgl, 1);
-        if (err != ERR_NONE)
+        sgl->pdf_data.buf_pos += span_size;
+    }
+
+    return err;
+}
+
+/** @brief Move position in the PDF after the literal string, the initial
+ *         position needs to be after the leading '(' character. Handles
+ *         the balanced parentheses and escaped characters inside
+ *
+ * @param sgl context
+ * @return ERR_NONE if success
+ */
+static sigil_err_t skip_literal_string(sigil_t *sgl)
+{
+    sigil_err_t err;
+    const char *span;
+    size_t span_size;
+    size_t depth = 1;
+    int escaped = 0;
+
+    while ((err = pdf_peek_span(sgl, &span, &span_size)) == ERR_NONE) {
+        for (size_t i = 0; i < span_size; i++) {
+            if (escaped) {
+                escaped = 0;
+                continue;
+            }
+
+            switch (span[i]) {
+                case '\\':
+                    escaped = 1;
+                    break;
+                case '(':
+                    depth++;
+                    break;
+                case ')':
+                    if (--depth == 0) {
+                        sgl->pdf_data.buf_pos += i + 1;
+                        return ERR_NONE;
+                    }
+                    break;
+                default:
+                    break;
+            }
+        }
+
+        sgl->pdf_data.buf_pos += span_size;
+    }
+
+    return err;
+}
+
+/** @brief Move position in the PDF after the string or comment which starts
+ *         with the already consumed delimiter
+ *
+ * @param sgl context
+ * @param c the delimiter, '(' or '%'
+ * @return ERR_NONE if success
+ */
+static sigil_err_t skip_string_or_comment(sigil_t *sgl, char c)
+{
+    sigil_err_t err;
+    char next;
+
+    switch (c) {
+        case '(':
+            return skip_literal_string(sgl);
+        case '%':
+            // comment ends with the end of line (CR, LF or both)
+            while ((err = pdf_peek_char(sgl, &next)) == ERR_NONE) {
+                if (next == 0x0a || next == 0x0d)
+                    return ERR_NONE;
+                sgl->pdf_data.buf_pos++;
+            }
             return err;
+        default:
+            return ERR_NONE;
     }
-
-    return err;
 }
 
 sigil_err_t skip_array(sigil_t *sgl)
 {
     sigil_err_t err;
+    size_t depth = 1;
     char c;
 
-    while((err = pdf_get_char(sgl, &c)) == ERR_NONE) {
+    if (sgl == NULL)
+        return ERR_PARAMETER;
+
+    while ((err = skip_to_delimiter(sgl, &c)) == ERR_NONE) {
+        sgl->pdf_data.buf_pos++;
+
         switch (c) {
             case '[':
-                err = skip_array(sgl);
-                if (err != ERR_NONE)
-                    return err;
+                depth++;
                 break;
             case ']':
-                return ERR_NONE;
-            case EOF:
-                return ERR_PDF_CONTENT;
+                if (--depth == 0)
+                    return ERR_NONE;
+                break;
+            case '(':
+            case '%':
+                if ((err = skip_string_or_comment(sgl, c)) != ERR_NONE)
+                    return err;
+                break;
             default:
                 break;
         }
@@ -311,30 +1149,40 @@ sigil_err_t skip_array(sigil_t *sgl)
 sigil_err_t skip_dictionary(sigil_t *sgl)
 {
     sigil_err_t err;
+    size_t depth = 1;
     char c;
 
-    err = skip_leading_whitespaces(sgl);
-    if (err != ERR_NONE)
-        return err;
+    if (sgl == NULL)
+        return ERR_PARAMETER;
+
+    while ((err = skip_to_delimiter(sgl, &c)) == ERR_NONE) {
+        sgl->pdf_data.buf_pos++;
 
-    while ((err = pdf_get_char(sgl, &c)) == ERR_NONE) {
         switch (c) {
             case '>':
-                if ((err = pdf_get_char(sgl, &c)) != ERR_NONE)
+                if ((err = pdf_peek_char(sgl, &c)) != ERR_NONE)
                     return err;
-                if (c == '>')
+                if (c != '>')
+                    break;
+                sgl->pdf_data.buf_pos++;
+                if (--depth == 0)
                     return ERR_NONE;
                 break;
             case '<':
-                if ((err = pdf_get_char(sgl, &c)) != ERR_NONE)
+                if ((err = pdf_peek_char(sgl, &c)) != ERR_NONE)
                     return err;
-                if (c != '<')
-                    break;
-                if ((err = skip_dictionary(sgl)) != ERR_NONE)
+                if (c == '<') {
+                    sgl->pdf_data.buf_pos++;
+                    depth++;
+                } else if ((err = skip_after_char(sgl, '>')) != ERR_NONE) {
+                    return err; // hexadecimal string
+                }
+                break;
+            case '(':
+            case '%':
+                if ((err = skip_string_or_comment(sgl, c)) != ERR_NONE)
                     return err;
                 break;
-            case EOF:
-                return ERR_PDF_CONTENT;
             default:
                 break;
         }
@@ -347,50 +1195,61 @@ sigil_err_t skip_dict_unknown_value(sigil_t *sgl)
 {
     sigil_err_t err;
     char c;
-    int first_non_whitespace = 1;
 
-    while ((err = pdf_peek_char(sgl, &c)) == ERR_NONE) {
-        if (first_non_whitespace && !is_whitespace(c)) {
-            first_non_whitespace = 0;
+    if (sgl == NULL)
+        return ERR_PARAMETER;
+
+    if ((err = skip_leading_whitespaces(sgl)) != ERR_NONE)
+        return err;
 
-            switch (c) {
-                case '/':
-                    if ((err = pdf_move_pos_rel(sgl, 1)) != ERR_NONE)
-                        return err;
-                    break;
-                case '[':
-                    if ((err = pdf_move_pos_rel(sgl, 1)) != ERR_NONE)
-                        return err;
-                    if ((err = skip_array(sgl)) != ERR_NONE)
-                        return err;
-                    return ERR_NONE;
-                case '<':
-                    if ((err = pdf_move_pos_rel(sgl, 1)) != ERR_NONE)
-                        return err;
-                    if ((err = pdf_peek_char(sgl, &c)) != ERR_NONE)
-                        return err;
-                    if (c != '<')
-                        break;
-                    if ((err = skip_dictionary(sgl)) != ERR_NONE)
-                        return err;
-                    return ERR_NONE;
-                default:
-                    break;
-            }
+    if ((err = pdf_peek_char(sgl, &c)) != ERR_NONE)
+        return err;
 
-            continue;
-        }
+    // the first token of the value
+    switch (c) {
+        case '/': // name
+            sgl->pdf_data.buf_pos++;
+            break;
+        case '[':
+            sgl->pdf_data.buf_pos++;
+            return skip_array(sgl);
+        case '<':
+            sgl->pdf_data.buf_pos++;
+            if ((err = pdf_peek_char(sgl, &c)) != ERR_NONE)
+                return err;
+            if (c == '<') {
+                sgl->pdf_data.buf_pos++;
+                return skip_dictionary(sgl);
+            }
+            // hexadecimal string
+            if ((err = skip_after_char(sgl, '>')) != ERR_NONE)
+                return err;
+            break;
+        case '(':
+            sgl->pdf_data.buf_pos++;
+            if ((err = skip_literal_string(sgl)) != ERR_NONE)
+                return err;
+            break;
+        default:
+            break;
+    }
 
+    // the rest of the value (numbers, references, keywords) up to the key
+    // of the next entry or the end of dictionary
+    while ((err = skip_to_delimiter(sgl, &c)) == ERR_NONE) {
         switch (c) {
             case '/': // key of next entry
             case '>': // end of dictionary
                 return ERR_NONE;
-            case EOF:
-                return ERR_PDF_CONTENT;
-            default:
-                if ((err = pdf_move_pos_rel(sgl, 1)) != ERR_NONE)
+            case '(':
+            case '%':
+                sgl->pdf_data.buf_pos++;
+                if ((err = skip_string_or_comment(sgl, c)) != ERR_NONE)
                     return err;
                 break;
+            default:
+                sgl->pdf_data.buf_pos++;
+                break;
         }
     }
 
@@ -431,8 +1290,10 @@ sigil_err_t skip_word(sigil_t *sgl, const char *word)
 sigil_err_t parse_number(sigil_t *sgl, size_t *number)
 {
     sigil_err_t err;
-    char c;
-    int digits = 0;
+    const char *span;
+    size_t span_size,
+           i,
+           digits = 0;
 
     if (sgl == NULL || number == NULL)
         return ERR_PARAMETER;
@@ -444,21 +1305,21 @@ sigil_err_t parse_number(sigil_t *sgl, size_t *number)
         return err;
 
     // number
-    while ((err = pdf_peek_char(sgl, &c)) == ERR_NONE) {
-        if (!is_digit(c)) {
+    while ((err = pdf_peek_span(sgl, &span, &span_size)) == ERR_NONE) {
+        for (i = 0; i < span_size && is_digit(span[i]); i++) {
+            *number = 10 * (*number) + span[i] - '0';
+        }
+
+        sgl->pdf_data.buf_pos += i;
+        digits += i;
+
+        if (i < span_size) {
             if (digits > 0) {
                 return ERR_NONE;
             } else {
                 return ERR_PDF_CONTENT;
             }
         }
-
-        *number = 10 * (*number) + c - '0';
-
-        if ((err = pdf_move_pos_rel(sgl, 1)) != ERR_NONE)
-            return err;
-
-        digits++;
     }
 
     return err;
@@ -483,19 +1344,164 @@ sigil_err_t parse_indirect_reference(sigil_t *sgl, reference_t *ref)
     return ERR_NONE;
 }
 
+// name matches the known key, *length* needs to be equal to sizeof(key) - 1
+#define NAME_IS(name, key) (memcmp((name), (key), sizeof(key) - 1) == 0)
+
+dict_key_t lookup_dict_key(const char *name, size_t length)
+{
+    if (name == NULL || length <= 0 || length > DICT_KEY_MAX)
+        return DICT_KEY_UNKNOWN;
+
+    switch (length) {
+        case 1:
+            switch (name[0]) {
+                case 'N':
+                    return DICT_KEY_N;
+                case 'V':
+                    return DICT_KEY_V;
+                case 'W':
+                    return DICT_KEY_W;
+            }
+            break;
+        case 2:
+            if (NAME_IS(name, "FT"))
+                return DICT_KEY_FT;
+            break;
+        case 4:
+            switch (name[0]) {
+                case 'C':
+                    if (NAME_IS(name, "Cert"))
+                        return DICT_KEY_Cert;
+                    break;
+                case 'P':
+                    if (NAME_IS(name, "Prev"))
+                        return DICT_KEY_Prev;
+                    break;
+                case 'R':
+                    if (NAME_IS(name, "Root"))
+                        return DICT_KEY_Root;
+                    break;
+                case 'S':
+                    if (NAME_IS(name, "Size"))
+                        return DICT_KEY_Size;
+                    break;
+                case 'T':
+                    if (NAME_IS(name, "Type"))
+                        return DICT_KEY_Type;
+                    break;
+            }
+            break;
+        case 5:
+            switch (name[0]) {
+                case 'F':
+                    if (NAME_IS(name, "First"))
+                        return DICT_KEY_First;
+                    break;
+                case 'I':
+                    if (NAME_IS(name, "Index"))
+                        return DICT_KEY_Index;
+                    break;
+            }
+            break;
+        case 6:
+            switch (name[0]) {
+                case 'F':
+                    if (NAME_IS(name, "Fields"))
+                        return DICT_KEY_Fields;
+                    if (NAME_IS(name, "Filter"))
+                        return DICT_KEY_Filter;
+                    break;
+                case 'L':
+                    if (NAME_IS(name, "Length"))
+                        return DICT_KEY_Length;
+                    break;
+            }
+            break;
+        case 7:
+            switch (name[0]) {
+                case 'C':
+                    if (NAME_IS(name, "Columns"))
+                        return DICT_KEY_Columns;
+                    break;
+                case 'X':
+                    if (NAME_IS(name, "XRefStm"))
+                        return DICT_KEY_XRefStm;
+                    break;
+            }
+            break;
+        case 8:
+            switch (name[0]) {
+                case 'A':
+                    if (NAME_IS(name, "AcroForm"))
+                        return DICT_KEY_AcroForm;
+                    break;
+                case 'C':
+                    if (NAME_IS(name, "Contents"))
+                        return DICT_KEY_Contents;
+                    break;
+                case 'S':
+                    if (NAME_IS(name, "SigFlags"))
+                        return DICT_KEY_SigFlags;
+                    break;
+            }
+            break;
+        case 9:
+            switch (name[0]) {
+                case 'B':
+                    if (NAME_IS(name, "ByteRange"))
+                        return DICT_KEY_ByteRange;
+                    break;
+                case 'P':
+                    if (NAME_IS(name, "Predictor"))
+                        return DICT_KEY_Predictor;
+                    break;
+                case 'S':
+                    if (NAME_IS(name, "SubFilter"))
+                        return DICT_KEY_SubFilter;
+                    break;
+            }
+            break;
+        case 11:
+            if (NAME_IS(name, "DecodeParms"))
+                return DICT_KEY_DecodeParms;
+            break;
+    }
+
+    return DICT_KEY_UNKNOWN;
+}
+
+/** @brief Index of the first character which terminates the name - whitespace
+ *         or delimiter
+ *
+ */
+static size_t find_name_end(const char *data, size_t size)
+{
+    size_t i;
+
+    for (i = 0; i < size; i++) {
+        if (char_class[(unsigned char)data[i]] &
+            (CHAR_CLASS_WHITESPACE | CHAR_CLASS_DELIMITER))
+        {
+            break;
+        }
+    }
+
+    return i;
+}
+
 // parse the key of the pair key - value in the dictionary
 sigil_err_t parse_dict_key(sigil_t *sgl, dict_key_t *dict_key)
 {
     sigil_err_t err;
-    int count = 0;
-    char tmp[DICT_KEY_MAX],
-         c;
+    const char *span;
+    size_t span_size,
+           name_size,
+           length = 0;
+    char tmp[DICT_KEY_MAX];
 
     if (sgl == NULL || dict_key == NULL)
         return ERR_PARAMETER;
 
-    sigil_zeroize(tmp, DICT_KEY_MAX * sizeof(*tmp));
-
     if (skip_word(sgl, ">>") == ERR_NONE)
         return ERR_END_OF_DICT;
 
@@ -503,55 +1509,35 @@ sigil_err_t parse_dict_key(sigil_t *sgl, dict_key_t *dict_key)
     if (err != ERR_NONE)
         return err;
 
-    while ((err = pdf_peek_char(sgl, &c)) == ERR_NONE) {
-        if (is_whitespace(c)) {
-            if (count <= 0)
-                return ERR_PDF_CONTENT;
-            break;
-        } else {
-            if (count >= DICT_KEY_MAX - 1)
+    while ((err = pdf_peek_span(sgl, &span, &span_size)) == ERR_NONE) {
+        name_size = find_name_end(span, span_size);
+        sgl->pdf_data.buf_pos += name_size;
+
+        // whole name available at once, no need to copy it
+        if (length == 0 && name_size < span_size) {
+            if (name_size <= 0)
                 return ERR_PDF_CONTENT;
-            tmp[count++] = c;
+
+            *dict_key = lookup_dict_key(span, name_size);
+            return ERR_NONE;
         }
 
-        if ((err = pdf_move_pos_rel(sgl, 1)) != ERR_NONE)
-            return err;
-    }
+        // name split by the end of the read window, longer names are unknown
+        if (length + name_size <= DICT_KEY_MAX)
+            memcpy(tmp + length, span, name_size);
+        length += name_size;
 
-    tmp[count] = '\0';
+        if (name_size < span_size)
+            break;
+    }
 
     if (err != ERR_NONE)
         return err;
 
-    if (strncmp(tmp, "Size", 4) == 0) {
-        *dict_key = DICT_KEY_Size;
-    } else if (strncmp(tmp, "Prev", 4) == 0) {
-        *dict_key = DICT_KEY_Prev;
-    } else if (strncmp(tmp, "Root", 4) == 0) {
-        *dict_key = DICT_KEY_Root;
-    } else if (strncmp(tmp, "AcroForm", 8) == 0) {
-        *dict_key = DICT_KEY_AcroForm;
-    } else if (strncmp(tmp, "Fields", 6) == 0) {
-        *dict_key = DICT_KEY_Fields;
-    } else if (strncmp(tmp, "SigFlags", 8) == 0) {
-        *dict_key = DICT_KEY_SigFlags;
-    } else if (strncmp(tmp, "FT", 2) == 0) {
-        *dict_key = DICT_KEY_FT;
-    } else if (strncmp(tmp, "V", 1) == 0) {
-        *dict_key = DICT_KEY_V;
-    } else if (strncmp(tmp, "SubFilter", 9) == 0) {
-        *dict_key = DICT_KEY_SubFilter;
-    } else if (strncmp(tmp, "Cert", 4) == 0) {
-        *dict_key = DICT_KEY_Cert;
-    } else if (strncmp(tmp, "Contents", 8) == 0) {
-        *dict_key = DICT_KEY_Contents;
-    } else if (strncmp(tmp, "ByteRange", 9) == 0) {
-        *dict_key = DICT_KEY_ByteRange;
-    } else {
-        *dict_key = DICT_KEY_UNKNOWN;
-    }
+    if (length <= 0)
+        return ERR_PDF_CONTENT;
 
-    sigil_zeroize(tmp, DICT_KEY_MAX * sizeof(*tmp));
+    *dict_key = lookup_dict_key(tmp, length);
 
     return ERR_NONE;
 }
@@ -572,11 +1558,12 @@ sigil_err_t parse_ref_array(sigil_t *sgl, ref_array_t *ref_array)
     if (skip_word(sgl, "]") == ERR_NONE) // empty array
         return ERR_NONE;
 
+    // zeroed memory from the arena of the context, released with it
     if (ref_array->capacity <= 0) {
-        ref_array->entry = malloc(sizeof(*ref_array->entry) * REF_ARRAY_PREALLOCATION);
+        ref_array->entry = arena_alloc(&(sgl->arena),
+            sizeof(*ref_array->entry) * REF_ARRAY_PREALLOCATION, 0);
         if (ref_array->entry == NULL)
             return ERR_ALLOCATION;
-        sigil_zeroize(ref_array->entry, sizeof(*ref_array->entry) * REF_ARRAY_PREALLOCATION);
         ref_array->capacity = REF_ARRAY_PREALLOCATION;
     }
 
@@ -584,20 +1571,19 @@ sigil_err_t parse_ref_array(sigil_t *sgl, ref_array_t *ref_array)
 
     while ((err = parse_indirect_reference(sgl,&reference)) == ERR_NONE) {
         if (position >= ref_array->capacity) {
-            ref_array->entry = realloc(ref_array->entry,
-                sizeof(*ref_array->entry) * ref_array->capacity * 2);
+            ref_array->entry = arena_realloc(&(sgl->arena), ref_array->entry,
+                sizeof(*ref_array->entry) * ref_array->capacity,
+                sizeof(*ref_array->entry) * ref_array->capacity * 2, 0);
 
             if (ref_array->entry == NULL)
                 return ERR_ALLOCATION;
 
-            sigil_zeroize(ref_array->entry + ref_array->capacity,
-                sizeof(*ref_array->entry) * ref_array->capacity);
-
             ref_array->capacity *= 2;
         }
 
         if (ref_array->entry[position] == NULL) {
-            ref_array->entry[position] = malloc(sizeof(reference_t));
+            ref_array->entry[position] = arena_alloc(&(sgl->arena),
+                                                     sizeof(reference_t), 0);
             if (ref_array->entry[position] == NULL)
                 return ERR_ALLOCATION;
         }
@@ -616,26 +1602,10 @@ sigil_err_t parse_ref_array(sigil_t *sgl, ref_array_t *ref_array)
 
 sigil_err_t reference_to_offset(sigil_t *sgl, const reference_t *ref, size_t *result)
 {
-    xref_entry_t *xref_entry;
-
     if (sgl == NULL || ref == NULL || sgl->xref == NULL || result == NULL)
         return ERR_PARAMETER;
 
-    if (sgl->xref->capacity <= ref->object_num)
-        return ERR_NO_DATA;
-
-    xref_entry = sgl->xref->entry[ref->object_num];
-
-    while (xref_entry != NULL) {
-        if (xref_entry->generation_num == ref->generation_num) {
-            *result = xref_entry->byte_offset;
-            return ERR_NONE;
-        }
-
-        xref_entry = xref_entry->next;
-    }
-
-    return ERR_NO_DATA;
+    return xref_get_offset(sgl, ref, result);
 }
 
 void print_module_name(const char *module_name, int verbosity)
@@ -714,6 +1684,33 @@ sigil_t *test_prepare_sgl_path(const char *path)
     return sgl;
 }
 
+static sigil_err_t test_reader_read_at(void *ctx, size_t offset, char *result,
+                                       size_t size, size_t *res_size)
+{
+    const char *data = ctx;
+    size_t length = strlen(data);
+
+    *res_size = (offset < length) ? MIN(size, length - offset) : 0;
+    memcpy(result, data + offset, *res_size);
+
+    return ERR_NONE;
+}
+
+static sigil_err_t test_reader_get_size(void *ctx, size_t *size)
+{
+    *size = strlen(ctx);
+
+    return ERR_NONE;
+}
+
+void test_string_reader(sigil_reader_t *reader, char *data)
+{
+    sigil_zeroize(reader, sizeof(*reader));
+    reader->ctx = data;
+    reader->read_at = test_reader_read_at;
+    reader->get_size = test_reader_get_size;
+}
+
 int sigil_auxiliary_self_test(int verbosity)
 {
     sigil_t *sgl = NULL;
@@ -782,6 +1779,96 @@ int sigil_auxiliary_self_test(int verbosity)
 
     print_test_result(1, verbosity);
 
+    // TEST: fn is_delimiter
+    print_test_item("fn is_delimiter", verbosity);
+
+    if (!is_delimiter('(') || !is_delimiter(')') || is_delimiter('a' ) ||
+        !is_delimiter('<') || !is_delimiter('>') || is_delimiter(0x20) ||
+        !is_delimiter('[') || !is_delimiter(']') || is_delimiter('0' ) ||
+        !is_delimiter('{') || !is_delimiter('}') || is_delimiter('#' ) ||
+        !is_delimiter('/') || !is_delimiter('%') || is_delimiter('\xff'))
+    {
+        goto failed;
+    }
+
+    print_test_result(1, verbosity);
+
+    // TEST: fn find_non_whitespace, find_delimiter
+    print_test_item("fn find_non_whitespace", verbosity);
+
+    {
+        char data[100];
+
+        for (size_t i = 0; i < sizeof(data); i++) {
+            data[i] = "\x00\x09\x0a\x0c\x0d\x20"[i % 6];
+        }
+
+        for (size_t i = 0; i < sizeof(data); i++) {
+            data[i] = 'x';
+
+            if (find_non_whitespace(data, sizeof(data)) != i ||
+                find_non_whitespace(data, i) != i)
+            {
+                goto failed;
+            }
+
+            data[i] = 0x20;
+        }
+
+        for (size_t i = 0; i < sizeof(data); i++) {
+            data[i] = "a1 )}R#"[i % 7];
+        }
+
+        if (find_delimiter(data, sizeof(data)) != sizeof(data))
+            goto failed;
+
+        for (size_t i = 0; i < sizeof(data); i++) {
+            char prev = data[i];
+            data[i] = "<>[]/(%"[i % 7];
+
+            if (find_delimiter(data, sizeof(data)) != i)
+                goto failed;
+
+            data[i] = prev;
+        }
+    }
+
+    print_test_result(1, verbosity);
+
+    // TEST: fn find_str, find_str_reverse
+    print_test_item("fn find_str", verbosity);
+
+    {
+        const char *data = "xrefxre startxref 12 startxref 3 startxre";
+        size_t size = strlen(data);
+
+        if (find_str(data, size, "startxref", 9) != 8 ||
+            find_str_reverse(data, size, "startxref", 9) != 21 ||
+            find_str(data, size, "xref", 4) != 0 ||
+            find_str_reverse(data, size, "xref", 4) != 26 ||
+            find_str(data, size, "trailer", 7) != size ||
+            find_str_reverse(data, size, "trailer", 7) != size ||
+            find_str(data, 3, "xref", 4) != 3)
+        {
+            goto failed;
+        }
+
+        // long enough for the vectorized search, with false candidates
+        char long_data[100];
+        for (size_t i = 0; i + 3 <= sizeof(long_data); i++) {
+            memset(long_data, 'o', sizeof(long_data));
+            for (size_t j = 2; j < sizeof(long_data); j += 3) {
+                long_data[j] = 'j';
+            }
+            memcpy(long_data + i, "obj", 3);
+
+            if (find_str(long_data, sizeof(long_data), "obj", 3) != i)
+                goto failed;
+        }
+    }
+
+    print_test_result(1, verbosity);
+
     // TEST: fn pdf_read
     print_test_item("fn pdf_read", verbosity);
 
@@ -807,6 +1894,30 @@ int sigil_auxiliary_self_test(int verbosity)
 
     print_test_result(1, verbosity);
 
+    // TEST: fn pdf_borrow
+    print_test_item("fn pdf_borrow", verbosity);
+
+    {
+        const char *data;
+
+        char *sstream = "abbbcx";
+        if ((sgl = test_prepare_sgl_buffer(sstream, strlen(sstream) + 1)) == NULL)
+            goto failed;
+
+        if (pdf_borrow(sgl, 1, 4, &data) != ERR_NONE || data != sstream + 1)
+            goto failed;
+
+        if (pdf_borrow(sgl, 5, 3, &data) != ERR_NO_DATA)
+            goto failed;
+
+        if ((pdf_get_char(sgl, &c)) != ERR_NONE || c != 'a')
+            goto failed;
+
+        sigil_free(&sgl);
+    }
+
+    print_test_result(1, verbosity);
+
     // TEST: fn skip_leading_whitespaces
     print_test_item("fn skip_leading_whitespaces", verbosity);
 
@@ -859,6 +1970,27 @@ int sigil_auxiliary_self_test(int verbosity)
 
     print_test_result(1, verbosity);
 
+    // TEST: fn skip_array
+    print_test_item("fn skip_array", verbosity);
+
+    {
+        char *sstream = "1 [2 [/Name]] (str]ing (nested\\)) ) <AB> "  \
+                        "% comment ]\n"                               \
+                        "<</Key [3]>>]x";
+        if ((sgl = test_prepare_sgl_buffer(sstream, strlen(sstream) + 1)) == NULL)
+            goto failed;
+
+        if (skip_array(sgl) != ERR_NONE)
+            goto failed;
+
+        if ((pdf_get_char(sgl, &c)) != ERR_NONE || c != 'x')
+            goto failed;
+
+        sigil_free(&sgl);
+    }
+
+    print_test_result(1, verbosity);
+
     // TEST: fn skip_dict_unknown_value
     print_test_item("fn skip_dict_unknown_value", verbosity);
 
@@ -876,6 +2008,23 @@ int sigil_auxiliary_self_test(int verbosity)
             goto failed;
 
         sigil_free(&sgl);
+
+        sstream = " <A1B2> /Next (a>b) /Last 12 0 R>>";
+        if ((sgl = test_prepare_sgl_buffer(sstream, strlen(sstream) + 1)) == NULL)
+            goto failed;
+
+        if (skip_dict_unknown_value(sgl) != ERR_NONE ||
+            pdf_get_char(sgl, &c) != ERR_NONE || c != '/' ||
+            skip_word(sgl, "Next") != ERR_NONE ||
+            skip_dict_unknown_value(sgl) != ERR_NONE ||
+            skip_word(sgl, "/Last") != ERR_NONE ||
+            skip_dict_unknown_value(sgl) != ERR_NONE ||
+            skip_word(sgl, ">>") != ERR_NONE)
+        {
+            goto failed;
+        }
+
+        sigil_free(&sgl);
     }
 
     print_test_result(1, verbosity);
@@ -901,6 +2050,62 @@ int sigil_auxiliary_self_test(int verbosity)
 
     print_test_result(1, verbosity);
 
+    // TEST: fn lookup_dict_key, parse_dict_key
+    print_test_item("fn parse_dict_key", verbosity);
+
+    {
+        dict_key_t dict_key;
+
+        if (lookup_dict_key("ByteRange", 9) != DICT_KEY_ByteRange ||
+            lookup_dict_key("Cert", 4) != DICT_KEY_Cert ||
+            lookup_dict_key("Contents", 8) != DICT_KEY_Contents ||
+            lookup_dict_key("V", 1) != DICT_KEY_V ||
+            lookup_dict_key("W", 1) != DICT_KEY_W ||
+            lookup_dict_key("Filter", 6) != DICT_KEY_Filter ||
+            lookup_dict_key("DecodeParms", 11) != DICT_KEY_DecodeParms ||
+            lookup_dict_key("N", 1) != DICT_KEY_N ||
+            lookup_dict_key("First", 5) != DICT_KEY_First ||
+            lookup_dict_key("Type", 4) != DICT_KEY_Type ||
+            lookup_dict_key("XRefStm", 7) != DICT_KEY_XRefStm ||
+            lookup_dict_key("Index", 5) != DICT_KEY_Index ||
+            lookup_dict_key("Version", 7) != DICT_KEY_UNKNOWN ||
+            lookup_dict_key("FTx", 3) != DICT_KEY_UNKNOWN ||
+            lookup_dict_key("Siz", 3) != DICT_KEY_UNKNOWN ||
+            lookup_dict_key("SubFilterX", 10) != DICT_KEY_UNKNOWN)
+        {
+            goto failed;
+        }
+
+        char *sstream = "/ViewerPreferences 1 /V 2 /FT/Sig"  \
+                        "/ThisNameIsLongerThanAnyKnownKey 3 /Root 4 0 R >>";
+        if ((sgl = test_prepare_sgl_buffer(sstream, strlen(sstream) + 1)) == NULL)
+            goto failed;
+
+        if (parse_dict_key(sgl, &dict_key) != ERR_NONE ||
+            dict_key != DICT_KEY_UNKNOWN ||
+            skip_dict_unknown_value(sgl) != ERR_NONE ||
+            parse_dict_key(sgl, &dict_key) != ERR_NONE ||
+            dict_key != DICT_KEY_V ||
+            skip_dict_unknown_value(sgl) != ERR_NONE ||
+            parse_dict_key(sgl, &dict_key) != ERR_NONE ||
+            dict_key != DICT_KEY_FT ||
+            skip_dict_unknown_value(sgl) != ERR_NONE ||
+            parse_dict_key(sgl, &dict_key) != ERR_NONE ||
+            dict_key != DICT_KEY_UNKNOWN ||
+            skip_dict_unknown_value(sgl) != ERR_NONE ||
+            parse_dict_key(sgl, &dict_key) != ERR_NONE ||
+            dict_key != DICT_KEY_Root ||
+            skip_dict_unknown_value(sgl) != ERR_NONE ||
+            parse_dict_key(sgl, &dict_key) != ERR_END_OF_DICT)
+        {
+            goto failed;
+        }
+
+        sigil_free(&sgl);
+    }
+
+    print_test_result(1, verbosity);
+
     // TEST: UTF-8 filepath support
     print_test_item("UTF-8 filepath support", verbosity);
 
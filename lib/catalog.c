@@ -55,13 +55,11 @@ sigil_err_t process_catalog(sigil_t *sgl)
                         return err;
                 }
                 break;
-            case DICT_KEY_UNKNOWN:
+            default: // also the known keys not used in this dictionary
                 err = skip_dict_unknown_value(sgl);
                 if (err != ERR_NONE)
                     return err;
                 break;
-            default:
-                return ERR_PDF_CONTENT;
         }
     }
 
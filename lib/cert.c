@@ -1,6 +1,7 @@
 #include <stdlib.h>
 #include <types.h>
 #include <string.h>
+#include "arena.h"
 #include "auxiliary.h"
 #include "cert.h"
 #include "config.h"
@@ -27,21 +28,18 @@ static sigil_err_t parse_one_cert(sigil_t *sgl, cert_t **result)
     if ((err = skip_word(sgl, "<")) != ERR_NONE)
         return err;
 
-    *result = malloc(sizeof(**result));
+    // zeroed memory from the arena of the context, released with it
+    *result = arena_alloc(&(sgl->arena), sizeof(**result), 0);
     if (*result == NULL)
         return ERR_ALLOCATION;
 
-    sigil_zeroize(*result, sizeof(**result));
-
     data = &((*result)->cert_hex);
 
-    *data = malloc(sizeof(*(*result)->cert_hex)
-                                 * CERT_HEX_PREALLOCATION);
+    *data = arena_alloc(&(sgl->arena), sizeof(*(*result)->cert_hex)
+                                       * CERT_HEX_PREALLOCATION, 1);
     if (*data == NULL)
         return ERR_ALLOCATION;
 
-    sigil_zeroize(*data, sizeof(**data) * CERT_HEX_PREALLOCATION);
-
     (*result)->capacity = CERT_HEX_PREALLOCATION;
 
     position = 0;
@@ -52,13 +50,12 @@ static sigil_err_t parse_one_cert(sigil_t *sgl, cert_t **result)
 
         // not enough space, allocate double
         if (position >= (*result)->capacity) {
-            *data = realloc(*data, sizeof(**data) * (*result)->capacity * 2);
+            *data = arena_realloc(&(sgl->arena), *data,
+                                  sizeof(**data) * (*result)->capacity,
+                                  sizeof(**data) * (*result)->capacity * 2, 1);
             if (*data == NULL)
                 return ERR_ALLOCATION;
 
-            sigil_zeroize(*data + (*result)->capacity,
-                          sizeof(**data) * (*result)->capacity);
-
             (*result)->capacity *= 2;
         }
 
@@ -73,14 +70,14 @@ static sigil_err_t parse_one_cert(sigil_t *sgl, cert_t **result)
     }
 }
 
-sigil_err_t parse_certs(sigil_t *sgl)
+sigil_err_t parse_certs(sigil_t *sgl, signature_t *sig)
 {
     sigil_err_t err;
     int additional_certs;
     cert_t **next_cert;
     char c;
 
-    if (sgl == NULL)
+    if (sgl == NULL || sig == NULL)
         return ERR_PARAMETER;
 
     additional_certs = 0;
@@ -98,14 +95,14 @@ sigil_err_t parse_certs(sigil_t *sgl)
         return err;
 
     // read signing certificate
-    err = parse_one_cert(sgl, &(sgl->certificates));
+    err = parse_one_cert(sgl, &(sig->certificates));
     if (err != ERR_NONE)
         return err;
 
     if (!additional_certs)
         return ERR_NONE;
 
-    next_cert = &(sgl->certificates);
+    next_cert = &(sig->certificates);
 
     // read other following certs for verifying authenticity of the signing one
     while (1) {
@@ -132,22 +129,13 @@ sigil_err_t parse_certs(sigil_t *sgl)
 
 void cert_free(cert_t *cert)
 {
-    if (cert == NULL)
-        return;
-
-    cert_free(cert->next);
-
-    if (cert->cert_hex != NULL) {
-        sigil_zeroize(cert->cert_hex,
-                      sizeof(*cert->cert_hex) * strlen(cert->cert_hex));
-        free(cert->cert_hex);
+    // the structures themselves are released with the arena
+    for (; cert != NULL; cert = cert->next) {
+        if (cert->x509 != NULL) {
+            X509_free(cert->x509);
+            cert->x509 = NULL;
+        }
     }
-
-    if (cert->x509 != NULL)
-        X509_free(cert->x509);
-
-    sigil_zeroize(cert, sizeof(*cert));
-    free(cert);
 }
 
 int sigil_cert_self_test(int verbosity)
@@ -29,6 +29,17 @@ int sigil_config_self_test(int verbosity)
 
     print_test_result(1, verbosity);
 
+    // TEST: XREF_MAX_OBJECT_NUM
+    print_test_item("XREF_MAX_OBJECT_NUM", verbosity);
+
+    if (XREF_MAX_OBJECT_NUM < XREF_PREALLOCATION ||
+        XREF_MAX_OBJECT_NUM > UINT32_MAX)
+    {
+        goto failed;
+    }
+
+    print_test_result(1, verbosity);
+
     // TEST: REF_ARRAY_PREALLOCATION
     print_test_item("REF_ARRAY_PREALLOCATION", verbosity);
 
@@ -53,6 +64,30 @@ int sigil_config_self_test(int verbosity)
 
     print_test_result(1, verbosity);
 
+    // TEST: SIGNATURE_PREALLOCATION
+    print_test_item("SIGNATURE_PREALLOCATION", verbosity);
+
+    if (SIGNATURE_PREALLOCATION < 1)
+        goto failed;
+
+    print_test_result(1, verbosity);
+
+    // TEST: VERIFY_THREADS_MAX
+    print_test_item("VERIFY_THREADS_MAX", verbosity);
+
+    if (VERIFY_THREADS_MAX < 1)
+        goto failed;
+
+    print_test_result(1, verbosity);
+
+    // TEST: ARENA_BLOCK_SIZE
+    print_test_item("ARENA_BLOCK_SIZE", verbosity);
+
+    if (ARENA_BLOCK_SIZE < 64)
+        goto failed;
+
+    print_test_result(1, verbosity);
+
     // TEST: THRESHOLD_FILE_BUFFERING
     print_test_item("THRESHOLD_FILE_BUFFERING", verbosity);
 
@@ -61,18 +96,74 @@ int sigil_config_self_test(int verbosity)
 
     print_test_result(1, verbosity);
 
-    // TEST: MAX_FILE_UPDATES
-    print_test_item("MAX_FILE_UPDATES", verbosity);
+    // TEST: READ_WINDOW_SIZE
+    print_test_item("READ_WINDOW_SIZE", verbosity);
 
-    if (MAX_FILE_UPDATES < 1)
+    if (READ_WINDOW_SIZE < 1)
         goto failed;
 
     print_test_result(1, verbosity);
 
-    // TEST: HASH_UPDATE_SIZE
-    print_test_item("HASH_UPDATE_SIZE", verbosity);
+    // TEST: READ_AHEAD_SIZE
+    print_test_item("READ_AHEAD_SIZE", verbosity);
 
-    if (HASH_UPDATE_SIZE < 1)
+    if (READ_AHEAD_SIZE < 1)
+        goto failed;
+
+    print_test_result(1, verbosity);
+
+    // TEST: READ_AHEAD_DEPTH
+    print_test_item("READ_AHEAD_DEPTH", verbosity);
+
+    if (READ_AHEAD_DEPTH < 1)
+        goto failed;
+
+    print_test_result(1, verbosity);
+
+    // TEST: DIGEST_BLOCK_SIZE
+    print_test_item("DIGEST_BLOCK_SIZE", verbosity);
+
+    if (DIGEST_BLOCK_SIZE < 1)
+        goto failed;
+
+    print_test_result(1, verbosity);
+
+    // TEST: STREAM_CHUNK_SIZE
+    print_test_item("STREAM_CHUNK_SIZE", verbosity);
+
+    if (STREAM_CHUNK_SIZE < 1 || STREAM_CHUNK_SIZE > UINT32_MAX)
+        goto failed;
+
+    print_test_result(1, verbosity);
+
+    // TEST: OBJSTM_CACHE_SIZE
+    print_test_item("OBJSTM_CACHE_SIZE", verbosity);
+
+    if (OBJSTM_CACHE_SIZE < 1)
+        goto failed;
+
+    print_test_result(1, verbosity);
+
+    // TEST: XREF_THREADS_MAX
+    print_test_item("XREF_THREADS_MAX", verbosity);
+
+    if (XREF_THREADS_MAX < 1)
+        goto failed;
+
+    print_test_result(1, verbosity);
+
+    // TEST: XREF_RECONSTRUCT_WINDOW
+    print_test_item("XREF_RECONSTRUCT_WINDOW", verbosity);
+
+    if (XREF_RECONSTRUCT_WINDOW < 16)
+        goto failed;
+
+    print_test_result(1, verbosity);
+
+    // TEST: MAX_FILE_UPDATES
+    print_test_item("MAX_FILE_UPDATES", verbosity);
+
+    if (MAX_FILE_UPDATES < 1)
         goto failed;
 
     print_test_result(1, verbosity);
@@ -1,6 +1,7 @@
 #include <stdlib.h>
 #include <types.h>
 #include <string.h>
+#include "arena.h"
 #include "auxiliary.h"
 #include "config.h"
 #include "constants.h"
@@ -9,40 +10,37 @@
 #include "sigil.h"
 
 
-sigil_err_t parse_contents(sigil_t *sgl)
+sigil_err_t parse_contents(sigil_t *sgl, signature_t *sig)
 {
     sigil_err_t err;
     char **data;
     char c;
     size_t position;
 
-    if (sgl == NULL)
+    if (sgl == NULL || sig == NULL)
         return ERR_PARAMETER;
 
     if ((err = skip_leading_whitespaces(sgl)) != ERR_NONE)
         return err;
 
-    if (sgl->contents != NULL)
-        contents_free(sgl);
+    if (sig->contents != NULL)
+        contents_free(sig);
 
     if ((err = skip_word(sgl, "<")) != ERR_NONE)
         return err;
 
-    sgl->contents = malloc(sizeof(*(sgl->contents)));
-    if (sgl->contents == NULL)
+    // zeroed memory from the arena of the context, released with it
+    sig->contents = arena_alloc(&(sgl->arena), sizeof(*(sig->contents)), 0);
+    if (sig->contents == NULL)
         return ERR_ALLOCATION;
 
-    sigil_zeroize(sgl->contents, sizeof(*(sgl->contents)));
+    data = &(sig->contents->contents_hex);
 
-    data = &(sgl->contents->contents_hex);
-
-    *data = malloc(sizeof(**data) * CONTENTS_PREALLOCATION);
+    *data = arena_alloc(&(sgl->arena), sizeof(**data) * CONTENTS_PREALLOCATION, 1);
     if (*data == NULL)
         return ERR_ALLOCATION;
 
-    sigil_zeroize(*data, sizeof(**data) * CONTENTS_PREALLOCATION);
-
-    sgl->contents->size = CONTENTS_PREALLOCATION;
+    sig->contents->size = CONTENTS_PREALLOCATION;
 
     position = 0;
 
@@ -51,15 +49,14 @@ sigil_err_t parse_contents(sigil_t *sgl)
             return err;
 
         // not enough space, allocate double
-        if (position >= sgl->contents->size) {
-            *data = realloc(*data, sizeof(**data) * sgl->contents->size * 2);
+        if (position >= sig->contents->size) {
+            *data = arena_realloc(&(sgl->arena), *data,
+                                  sizeof(**data) * sig->contents->size,
+                                  sizeof(**data) * sig->contents->size * 2, 1);
             if (*data == NULL)
                 return ERR_ALLOCATION;
 
-            sigil_zeroize(*data + sgl->contents->size,
-                          sizeof(**data) * sgl->contents->size);
-
-            sgl->contents->size *= 2;
+            sig->contents->size *= 2;
         }
 
         if (c == '>') {
@@ -73,20 +70,13 @@ sigil_err_t parse_contents(sigil_t *sgl)
     }
 }
 
-void contents_free(sigil_t *sgl)
+void contents_free(signature_t *sig)
 {
-    if (sgl == NULL || sgl->contents == NULL)
+    if (sig == NULL)
         return;
 
-    if (sgl->contents->contents_hex != NULL) {
-        sigil_zeroize(sgl->contents->contents_hex,
-                      sizeof(*sgl->contents->contents_hex) * sgl->contents->size);
-        free(sgl->contents->contents_hex);
-    }
-
-    sigil_zeroize(sgl->contents, sizeof(*sgl->contents));
-    free(sgl->contents);
-    sgl->contents = NULL;
+    // released (and zeroized) with the arena
+    sig->contents = NULL;
 }
 
 int sigil_contents_self_test(int verbosity)
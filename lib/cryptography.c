@@ -2,12 +2,16 @@
 #include <openssl/evp.h>
 #include <openssl/x509.h>
 #include <types.h>
+#include <stdint.h>
+#include <stdlib.h>
 #include <string.h>
 #include <sigil.h>
 #include "auxiliary.h"
 #include "config.h"
 #include "constants.h"
 #include "cryptography.h"
+#include "mem.h"
+#include "pool.h"
 #include "types.h"
 
 
@@ -62,122 +66,568 @@ static sigil_err_t hex_to_dec(const char *in, size_t in_len, unsigned char *out,
     return ERR_NONE;
 }
 
-sigil_err_t compute_digest_pkcs1(sigil_t *sgl)
+/** @brief Adds the data to the message digest context, used also as a
+ *         callback of pdf_read_ahead
+ *
+ * @param ctx EVP_MD_CTX message digest context
+ * @param data input data
+ * @param size number of bytes
+ * @return ERR_NONE if success
+ */
+static sigil_err_t digest_update(void *ctx, const char *data, size_t size)
 {
-    sigil_err_t err;
-    char *update_data = NULL;
-    EVP_MD_CTX *ctx = NULL;
-    const EVP_MD *evp_md;
-    const ASN1_OBJECT *md_obj = NULL;
-    range_t *range;
-    size_t bytes_left;
-    size_t current_length;
-    size_t read_size;
-    unsigned char tmp_hash[EVP_MAX_MD_SIZE];
-    unsigned int tmp_hash_len;
-
-    if (sgl == NULL || sgl->byte_range == NULL)
-        return ERR_PARAMETER;
+    if (EVP_DigestUpdate(ctx, data, size) != 1)
+        return ERR_OPENSSL;
 
-    update_data = malloc(sizeof(*update_data) * (HASH_UPDATE_SIZE + 1));
-    if (update_data == NULL) {
-        err = ERR_ALLOCATION;
-        goto end;
-    }
+    return ERR_NONE;
+}
 
-    sigil_zeroize(update_data, sizeof(*update_data) * (HASH_UPDATE_SIZE + 1));
+/** @brief Position of a job in the stream of its hashed data, the jobs with
+ *         the same function at the same position share the message digest
+ *         context
+ *
+ */
+typedef struct {
+    digest_job_t  *job;
+    const range_t *range; // the current range, NULL when all of them hashed
+    size_t         done;  // bytes of the current range already hashed
+} digest_cursor_t;
 
-    // initialize digest context
-    if ((ctx = EVP_MD_CTX_create()) == NULL)
-        return ERR_ALLOCATION;
+/** @brief Message digest context with the jobs at the same position
+ *
+ */
+typedef struct {
+    EVP_MD_CTX      *ctx;
+    digest_cursor_t *cursor; // slice of the cursors, only for this lane
+    size_t           count;
+} digest_lane_t;
 
-    X509_ALGOR_get0(&md_obj, NULL, NULL, sgl->digest_algorithm);
-    evp_md = EVP_get_digestbyobj(md_obj);
-    if (evp_md == NULL) {
-        err = ERR_OPENSSL;
-        goto end;
-    }
+/** @brief Data of the document hashed by one of the lanes, run by the pool
+ *
+ */
+typedef struct {
+    sigil_t    *sgl;
+    EVP_MD_CTX *ctx;
+    size_t      start;
+    size_t      length;
+} digest_segment_t;
+
+/** @brief Gets the message digest function from the algorithm loaded from the
+ *         signature, only the allowed ones
+ *
+ * @param sig signature
+ * @param evp_md output - the message digest function
+ * @return ERR_NONE if success, ERR_DIGEST_TYPE for the other functions
+ */
+static sigil_err_t get_digest_fn(signature_t *sig, const EVP_MD **evp_md)
+{
+    const ASN1_OBJECT *md_obj = NULL;
+
+    X509_ALGOR_get0(&md_obj, NULL, NULL, sig->digest_algorithm);
+    *evp_md = EVP_get_digestbyobj(md_obj);
+    if (*evp_md == NULL)
+        return ERR_OPENSSL;
 
     // only allowed algorithms
-    switch (EVP_MD_type(evp_md)) {
+    switch (EVP_MD_type(*evp_md)) {
         case NID_sha1:
-            sgl->hash_fn = HASH_FN_sha1;
+            sig->hash_fn = HASH_FN_sha1;
             break;
         case NID_sha256:
-            sgl->hash_fn = HASH_FN_sha256;
+            sig->hash_fn = HASH_FN_sha256;
             break;
         case NID_sha384:
-            sgl->hash_fn = HASH_FN_sha384;
+            sig->hash_fn = HASH_FN_sha384;
             break;
         case NID_sha512:
-            sgl->hash_fn = HASH_FN_sha512;
+            sig->hash_fn = HASH_FN_sha512;
             break;
         case NID_ripemd160:
-            sgl->hash_fn = HASH_FN_ripemd160;
+            sig->hash_fn = HASH_FN_ripemd160;
             break;
         default:
-            err = ERR_DIGEST_TYPE;
+            return ERR_DIGEST_TYPE;
+    }
+
+    return ERR_NONE;
+}
+
+static size_t cursor_position(const digest_cursor_t *cursor)
+{
+    return cursor->job->base + cursor->range->start + cursor->done;
+}
+
+static int cursor_md_cmp(const void *a, const void *b)
+{
+    const digest_cursor_t *first  = a,
+                          *second = b;
+    int first_type  = EVP_MD_type(first->job->evp_md),
+        second_type = EVP_MD_type(second->job->evp_md);
+
+    return (first_type > second_type) - (first_type < second_type);
+}
+
+// the finished cursors first, the rest by the position
+static int cursor_cmp(const void *a, const void *b)
+{
+    const digest_cursor_t *first  = a,
+                          *second = b;
+
+    if (first->range == NULL || second->range == NULL)
+        return (first->range != NULL) - (second->range != NULL);
+
+    return (cursor_position(first) > cursor_position(second)) -
+           (cursor_position(first) < cursor_position(second));
+}
+
+static size_t lane_position(const digest_lane_t *lane)
+{
+    return cursor_position(&(lane->cursor[0]));
+}
+
+// the data all the jobs of the lane hash next, without a gap
+static size_t lane_run(const digest_lane_t *lane)
+{
+    size_t run = SIZE_MAX;
+
+    for (size_t i = 0; i < lane->count; i++) {
+        run = MIN(run, lane->cursor[i].range->length - lane->cursor[i].done);
+    }
+
+    return run;
+}
+
+/** @brief Saves the computed message digest to the job
+ *
+ * @param ctx message digest context with all the data of the job
+ * @param job the job
+ * @param keep_ctx whether the context needs to stay usable for the others
+ * @return ERR_NONE if success
+ */
+static sigil_err_t digest_final(EVP_MD_CTX *ctx, digest_job_t *job, int keep_ctx)
+{
+    sigil_err_t err;
+    EVP_MD_CTX *final_ctx = ctx;
+
+    if (keep_ctx) {
+        final_ctx = EVP_MD_CTX_create();
+        if (final_ctx == NULL)
+            return ERR_ALLOCATION;
+
+        if (EVP_MD_CTX_copy_ex(final_ctx, ctx) != 1) {
+            err = ERR_OPENSSL;
             goto end;
+        }
     }
 
-    if (EVP_DigestInit_ex(ctx, evp_md, NULL) != 1) {
+    // process last pieces of data from context
+    if (EVP_DigestFinal_ex(final_ctx, job->digest, &(job->digest_len)) != 1) {
         err = ERR_OPENSSL;
         goto end;
     }
 
-    range = sgl->byte_range;
+    err = ERR_NONE;
+
+end:
+    if (keep_ctx)
+        EVP_MD_CTX_destroy(final_ctx);
 
-    while (range != NULL) {
-        err = pdf_move_pos_abs(sgl, range->start);
+    return err;
+}
+
+/** @brief Finishes the jobs of the lane with all the ranges hashed, and moves
+ *         the ones continuing elsewhere to new lanes with a copy of the context
+ *
+ * @param lane the lane, empty if all its jobs finished
+ * @param lanes all the lanes, the new ones appended
+ * @param lane_count number of the lanes
+ * @return ERR_NONE if success
+ */
+static sigil_err_t settle_lane(digest_lane_t *lane, digest_lane_t *lanes,
+                               size_t *lane_count)
+{
+    sigil_err_t err;
+    digest_lane_t *branch;
+    size_t n;
+
+    for (size_t i = 0; i < lane->count; i++) {
+        digest_cursor_t *cursor = &(lane->cursor[i]);
+
+        while (cursor->range != NULL && cursor->done >= cursor->range->length) {
+            cursor->range = cursor->range->next;
+            cursor->done = 0;
+        }
+    }
+
+    qsort(lane->cursor, lane->count, sizeof(*lane->cursor), cursor_cmp);
+
+    while (lane->count > 0 && lane->cursor->range == NULL) {
+        err = digest_final(lane->ctx, lane->cursor->job, lane->count > 1);
         if (err != ERR_NONE)
             return err;
 
-        bytes_left = range->length;
+        lane->cursor++;
+        lane->count--;
+    }
 
-        while (bytes_left > 0) {
-            current_length = MIN(HASH_UPDATE_SIZE, bytes_left);
+    if (lane->count <= 0)
+        return ERR_NONE;
 
-            err = pdf_read(sgl, current_length, update_data, &read_size);
-            if (err != ERR_NONE)
-                return err;
-            if (current_length != read_size)
-                return ERR_IO;
+    // the jobs continuing elsewhere get a copy of the context
+    while (lane_position(lane) != cursor_position(&(lane->cursor[lane->count - 1]))) {
+        n = 1;
+        while (cursor_position(&(lane->cursor[lane->count - n - 1])) ==
+               cursor_position(&(lane->cursor[lane->count - 1])))
+        {
+            n++;
+        }
 
-            if (EVP_DigestUpdate(ctx, update_data, current_length) != 1) {
-                err = ERR_OPENSSL;
-                goto end;
+        branch = &(lanes[*lane_count]);
+        if ((branch->ctx = EVP_MD_CTX_create()) == NULL)
+            return ERR_ALLOCATION;
+
+        (*lane_count)++;
+        branch->cursor = lane->cursor + lane->count - n;
+        branch->count = n;
+        lane->count -= n;
+
+        if (EVP_MD_CTX_copy_ex(branch->ctx, lane->ctx) != 1)
+            return ERR_OPENSSL;
+    }
+
+    return ERR_NONE;
+}
+
+static sigil_err_t run_segment(pool_t *pool, void *arg)
+{
+    digest_segment_t *segment = arg;
+    const char *data;
+
+    (void)pool;
+
+    // only used with the data in memory
+    if (pdf_borrow(segment->sgl, segment->start, segment->length, &data) != ERR_NONE)
+        return ERR_NO_DATA;
+
+    return digest_update(segment->ctx, data, segment->length);
+}
+
+/** @brief Contexts receiving each block of the data read
+ *
+ */
+typedef struct {
+    EVP_MD_CTX **ctx;
+    size_t       count;
+} digest_fan_t;
+
+// each block goes to all the contexts while it is still in the cache
+static sigil_err_t digest_fan_out(void *arg, const char *data, size_t size)
+{
+    const digest_fan_t *fan = arg;
+    size_t block;
+
+    for (size_t pos = 0; pos < size; pos += block) {
+        block = MIN(size - pos, DIGEST_BLOCK_SIZE);
+
+        for (size_t i = 0; i < fan->count; i++) {
+            if (EVP_DigestUpdate(fan->ctx[i], data + pos, block) != 1)
+                return ERR_OPENSSL;
+        }
+    }
+
+    return ERR_NONE;
+}
+
+/** @brief Hashes the same data of the document by all the contexts
+ *
+ * @param sgl context
+ * @param pool the pool hashing for each context on its own, if it has threads
+ * @param ahead read-ahead state for the data not available in memory
+ * @param fan the contexts
+ * @param start position of the data
+ * @param length number of bytes
+ * @return ERR_NONE if success
+ */
+static sigil_err_t digest_segment(sigil_t *sgl, pool_t *pool,
+                                  read_ahead_t *ahead, digest_fan_t *fan,
+                                  size_t start, size_t length)
+{
+    sigil_err_t err,
+                err_wait;
+    digest_segment_t *segment;
+    const char *data;
+
+    if (pdf_borrow(sgl, start, length, &data) != ERR_NONE)
+        return pdf_read_ahead(sgl, ahead, start, length, digest_fan_out, fan);
+
+    if (pool->threads <= 0 || fan->count <= 1)
+        return digest_fan_out(fan, data, length);
+
+    segment = mem_alloc(sizeof(*segment) * fan->count);
+    if (segment == NULL)
+        return ERR_ALLOCATION;
+
+    err = ERR_NONE;
+    for (size_t i = 0; i < fan->count && err == ERR_NONE; i++) {
+        segment[i].sgl = sgl;
+        segment[i].ctx = fan->ctx[i];
+        segment[i].start = start;
+        segment[i].length = length;
+        err = pool_submit(pool, run_segment, &(segment[i]));
+    }
+
+    // the tasks submitted so far use the array
+    err_wait = pool_wait(pool);
+    mem_free(segment);
+    if (err == ERR_NONE)
+        err = err_wait;
+
+    return err;
+}
+
+sigil_err_t digest_jobs(sigil_t *sgl, pool_t *pool, digest_job_t *job, size_t count)
+{
+    sigil_err_t err;
+    digest_cursor_t *cursor = NULL;
+    digest_lane_t *lanes = NULL;
+    digest_fan_t fan;
+    read_ahead_t ahead;
+    size_t lane_count = 0,
+           offset_pdf_start,
+           active,
+           start,
+           end,
+           n;
+
+    if (sgl == NULL || pool == NULL || (job == NULL && count > 0))
+        return ERR_PARAMETER;
+
+    if (count <= 0)
+        return ERR_NONE;
+
+    // the positions of the jobs are in the whole file
+    offset_pdf_start = sgl->offset_pdf_start;
+    sgl->offset_pdf_start = 0;
+
+    fan.ctx = NULL;
+    // set up once for all the segments read
+    read_ahead_init(&ahead);
+
+    cursor = mem_alloc(sizeof(*cursor) * count);
+    lanes = mem_alloc(sizeof(*lanes) * count);
+    fan.ctx = mem_alloc(sizeof(*fan.ctx) * count);
+    if (cursor == NULL || lanes == NULL || fan.ctx == NULL) {
+        err = ERR_ALLOCATION;
+        goto end;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        if (job[i].evp_md == NULL) {
+            err = ERR_PARAMETER;
+            goto end;
+        }
+
+        cursor[i].job = &(job[i]);
+        cursor[i].range = job[i].range;
+        cursor[i].done = 0;
+    }
+
+    qsort(cursor, count, sizeof(*cursor), cursor_md_cmp);
+
+    // one context for each function, shared till the ranges part
+    for (size_t i = 0; i < count; i += n) {
+        n = 1;
+        while (i + n < count && cursor_md_cmp(&(cursor[i]), &(cursor[i + n])) == 0)
+            n++;
+
+        lanes[lane_count].cursor = cursor + i;
+        lanes[lane_count].count = n;
+        if ((lanes[lane_count].ctx = EVP_MD_CTX_create()) == NULL) {
+            err = ERR_ALLOCATION;
+            goto end;
+        }
+        lane_count++;
+
+        if (EVP_DigestInit_ex(lanes[lane_count - 1].ctx, cursor[i].job->evp_md,
+                              NULL) != 1)
+        {
+            err = ERR_OPENSSL;
+            goto end;
+        }
+    }
+
+    for (size_t i = 0, initial = lane_count; i < initial; i++) {
+        err = settle_lane(&(lanes[i]), lanes, &lane_count);
+        if (err != ERR_NONE)
+            goto end;
+    }
+
+    // walk the file once, with the data shared by all the lanes around
+    while (1) {
+        // the finished lanes released
+        for (size_t i = 0; i < lane_count; ) {
+            if (lanes[i].count > 0) {
+                i++;
+                continue;
             }
 
-            bytes_left -= current_length;
+            EVP_MD_CTX_destroy(lanes[i].ctx);
+            lanes[i] = lanes[--lane_count];
+        }
+
+        if (lane_count <= 0)
+            break;
+
+        start = SIZE_MAX;
+        for (size_t i = 0; i < lane_count; i++) {
+            start = MIN(start, lane_position(&(lanes[i])));
+        }
+
+        // till the end of the shortest run, or where another lane joins in
+        end = SIZE_MAX;
+        fan.count = 0;
+        for (size_t i = 0; i < lane_count; i++) {
+            if (lane_position(&(lanes[i])) > start) {
+                end = MIN(end, lane_position(&(lanes[i])));
+            } else {
+                end = MIN(end, start + MIN(lane_run(&(lanes[i])), SIZE_MAX - start));
+                fan.ctx[fan.count++] = lanes[i].ctx;
+            }
+        }
+
+        // ranges reaching over the end of the address space
+        if (end <= start) {
+            err = ERR_PDF_CONTENT;
+            goto end;
         }
 
-        range = range->next;
+        err = digest_segment(sgl, pool, &ahead, &fan, start, end - start);
+        if (err != ERR_NONE)
+            goto end;
+
+        active = lane_count;
+        for (size_t i = 0; i < active; i++) {
+            if (lane_position(&(lanes[i])) != start)
+                continue;
+
+            for (size_t j = 0; j < lanes[i].count; j++) {
+                lanes[i].cursor[j].done += end - start;
+            }
+
+            err = settle_lane(&(lanes[i]), lanes, &lane_count);
+            if (err != ERR_NONE)
+                goto end;
+        }
     }
 
-    // process last pieces of data from context
-    if (EVP_DigestFinal_ex(ctx, tmp_hash, &tmp_hash_len) != 1) {
-        err = ERR_OPENSSL;
+    err = ERR_NONE;
+
+end:
+    for (size_t i = 0; i < lane_count; i++) {
+        if (lanes[i].ctx != NULL)
+            EVP_MD_CTX_destroy(lanes[i].ctx);
+    }
+
+    read_ahead_free(&ahead);
+    mem_free(fan.ctx);
+    mem_free(lanes);
+    mem_free(cursor);
+
+    sgl->offset_pdf_start = offset_pdf_start;
+
+    return err;
+}
+
+sigil_err_t compute_digest_pkcs1(sigil_t *sgl, pool_t *pool, signature_t **sig,
+                                 size_t count, ASN1_OCTET_STRING **file_digest)
+{
+    sigil_err_t err;
+    digest_job_t *job;
+    signature_t **owner; // signature of each job, NULL for the file digest
+    range_t file_range;
+    size_t job_count = 0;
+
+    if (sgl == NULL || pool == NULL || (sig == NULL && count > 0))
+        return ERR_PARAMETER;
+
+    if (count + (file_digest != NULL) <= 0)
+        return ERR_NONE;
+
+    job = mem_calloc(count + 1, sizeof(*job));
+    owner = mem_calloc(count + 1, sizeof(*owner));
+    if (job == NULL || owner == NULL) {
+        err = ERR_ALLOCATION;
         goto end;
     }
 
-    sgl->digest_computed = ASN1_OCTET_STRING_new();
-    if (ASN1_OCTET_STRING_set(sgl->digest_computed, tmp_hash, tmp_hash_len) == 0) {
-        err = ERR_OPENSSL;
+    for (size_t i = 0; i < count; i++) {
+        if (sig[i] == NULL) {
+            err = ERR_PARAMETER;
+            goto end;
+        }
+
+        // the failed signatures are left out, the others hashed anyway
+        if (sig[i]->err != ERR_NONE)
+            continue;
+
+        if (sig[i]->byte_range == NULL) {
+            sig[i]->err = ERR_PDF_CONTENT;
+            continue;
+        }
+
+        sig[i]->err = get_digest_fn(sig[i], &(job[job_count].evp_md));
+        if (sig[i]->err != ERR_NONE)
+            continue;
+
+        job[job_count].range = sig[i]->byte_range;
+        job[job_count].base = sgl->offset_pdf_start;
+        owner[job_count] = sig[i];
+        job_count++;
+    }
+
+    // also the data before the header, not covered by any byte range
+    if (file_digest != NULL) {
+        file_range.start = 0;
+        file_range.length = sgl->pdf_data.size;
+        file_range.next = NULL;
+
+        job[job_count].evp_md = EVP_sha256();
+        job[job_count].range = &file_range;
+        job[job_count].base = 0;
+        job_count++;
+    }
+
+    // each byte of the file read once for all of them
+    err = digest_jobs(sgl, pool, job, job_count);
+    if (err != ERR_NONE)
         goto end;
+
+    for (size_t i = 0; i < job_count; i++) {
+        ASN1_OCTET_STRING **digest = (owner[i] != NULL) ? &(owner[i]->digest_computed)
+                                                        : file_digest;
+
+        *digest = ASN1_OCTET_STRING_new();
+        if (*digest == NULL) {
+            err = ERR_ALLOCATION;
+            goto end;
+        }
+
+        if (ASN1_OCTET_STRING_set(*digest, job[i].digest, (int)job[i].digest_len) == 0) {
+            err = ERR_OPENSSL;
+            goto end;
+        }
     }
 
     err = ERR_NONE;
 
 end:
-    if (update_data != NULL)
-        free(update_data);
-    if (ctx != NULL)
-        EVP_MD_CTX_destroy(ctx);
+    mem_free(owner);
+    mem_free(job);
 
     return err;
 }
 
-sigil_err_t load_certificates(sigil_t *sgl)
+sigil_err_t load_certificates(signature_t *sig)
 {
     sigil_err_t err;
     cert_t *certificate;
@@ -186,10 +636,10 @@ sigil_err_t load_certificates(sigil_t *sgl)
     size_t cert_length;
     size_t tmp_cert_len;
 
-    if (sgl == NULL)
+    if (sig == NULL)
         return ERR_PARAMETER;
 
-    certificate = sgl->certificates;
+    certificate = sig->certificates;
 
     while (certificate != NULL) {
         if (certificate->x509 != NULL) {
@@ -199,7 +649,7 @@ sigil_err_t load_certificates(sigil_t *sgl)
 
         cert_length = strlen(certificate->cert_hex);
 
-        tmp_cert = malloc(sizeof(*(certificate->cert_hex)) * ((cert_length + 1) / 2 + 1));
+        tmp_cert = mem_alloc(sizeof(*(certificate->cert_hex)) * ((cert_length + 1) / 2 + 1));
         if (tmp_cert == NULL)
             return ERR_ALLOCATION;
 
@@ -214,11 +664,11 @@ sigil_err_t load_certificates(sigil_t *sgl)
 
         certificate->x509 = d2i_X509(NULL, &const_tmp, tmp_cert_len);
         if (certificate->x509 == NULL) {
-            free(tmp_cert);
+            mem_free(tmp_cert);
             return ERR_OPENSSL;
         }
 
-        free(tmp_cert);
+        mem_free(tmp_cert);
 
         certificate = certificate->next;
     }
@@ -226,7 +676,7 @@ sigil_err_t load_certificates(sigil_t *sgl)
     return ERR_NONE;
 }
 
-sigil_err_t load_digest(sigil_t *sgl)
+sigil_err_t load_digest(signature_t *sig)
 {
     sigil_err_t              err;
     char                    *contents;
@@ -240,18 +690,18 @@ sigil_err_t load_digest(sigil_t *sgl)
     unsigned char           *rsa_out_str = NULL;
     int                      rsa_out_len;
     const unsigned char     *const_rsa_out;
-    X509_SIG                *sig = NULL;
+    X509_SIG                *x509_sig = NULL;
     const X509_SIG          *const_sig = NULL;
     const X509_ALGOR        *tmp_alg = NULL;
     const ASN1_OCTET_STRING *tmp_hash = NULL;
 
-    if (sgl == NULL || sgl->contents == NULL || sgl->certificates == NULL)
+    if (sig == NULL || sig->contents == NULL || sig->certificates == NULL)
         return ERR_PARAMETER;
 
-    contents = sgl->contents->contents_hex;
+    contents = sig->contents->contents_hex;
     contents_len = strlen(contents);
 
-    tmp_contents = malloc(sizeof(*contents) * ((contents_len + 1) / 2 + 1));
+    tmp_contents = mem_alloc(sizeof(*contents) * ((contents_len + 1) / 2 + 1));
     if (tmp_contents == NULL) {
         err = ERR_ALLOCATION;
         goto end;
@@ -271,7 +721,7 @@ sigil_err_t load_digest(sigil_t *sgl)
         goto end;
     }
 
-    pub_key = X509_get_pubkey(sgl->certificates->x509);
+    pub_key = X509_get_pubkey(sig->certificates->x509);
     if (pub_key == NULL) {
         err = ERR_OPENSSL;
         goto end;
@@ -289,7 +739,7 @@ sigil_err_t load_digest(sigil_t *sgl)
         goto end;
     }
 
-    rsa_out_str = malloc(sizeof(*rsa_out_str) * rsa_out_len);
+    rsa_out_str = mem_alloc(sizeof(*rsa_out_str) * rsa_out_len);
     if (rsa_out_str == NULL) {
         err = ERR_OPENSSL;
         goto end;
@@ -305,24 +755,24 @@ sigil_err_t load_digest(sigil_t *sgl)
 
     const_rsa_out = rsa_out_str;
 
-    sig = d2i_X509_SIG(NULL, &const_rsa_out, rsa_out_len);
-    if (sig == NULL) {
+    x509_sig = d2i_X509_SIG(NULL, &const_rsa_out, rsa_out_len);
+    if (x509_sig == NULL) {
         err = ERR_OPENSSL;
         goto end;
     }
 
-    const_sig = sig;
+    const_sig = x509_sig;
 
     X509_SIG_get0(const_sig, &tmp_alg, &tmp_hash);
 
-    sgl->digest_algorithm = X509_ALGOR_dup((X509_ALGOR *)tmp_alg);
-    sgl->digest_original = ASN1_OCTET_STRING_dup(tmp_hash);
+    sig->digest_algorithm = X509_ALGOR_dup((X509_ALGOR *)tmp_alg);
+    sig->digest_original = ASN1_OCTET_STRING_dup(tmp_hash);
 
     err = ERR_NONE;
 
 end:
     if (tmp_contents != NULL)
-        free(tmp_contents);
+        mem_free(tmp_contents);
     if (oc_str != NULL)
         ASN1_OCTET_STRING_free(oc_str);
     if (pub_key != NULL)
@@ -330,9 +780,9 @@ end:
     if (rsa != NULL)
         RSA_free(rsa);
     if (rsa_out_str != NULL)
-        free(rsa_out_str);
-    if (sig != NULL)
-        X509_SIG_free(sig);
+        mem_free(rsa_out_str);
+    if (x509_sig != NULL)
+        X509_SIG_free(x509_sig);
 
     return err;
 }
@@ -356,18 +806,18 @@ end:
  * // at the end
  * X509_VERIFY_PARAM_free(param);
 */
-sigil_err_t verify_signing_certificate(sigil_t *sgl)
+sigil_err_t verify_signing_certificate(sigil_t *sgl, signature_t *sig)
 {
     X509_STORE_CTX *ctx;
     cert_t *additional_cert;
     STACK_OF(X509) *trusted_chain;
 
-    if (sgl == NULL || sgl->certificates == NULL)
+    if (sgl == NULL || sig == NULL || sig->certificates == NULL)
         return ERR_PARAMETER;
 
     trusted_chain = sk_X509_new_null();
 
-    additional_cert = sgl->certificates->next;
+    additional_cert = sig->certificates->next;
 
     while (additional_cert != NULL) {
         if (sk_X509_push(trusted_chain, additional_cert->x509) == 0) {
@@ -385,21 +835,21 @@ sigil_err_t verify_signing_certificate(sigil_t *sgl)
     }
 
     // initialize store context
-    if (X509_STORE_CTX_init(ctx, sgl->trusted_store, sgl->certificates->x509, trusted_chain) != 1) {
+    if (X509_STORE_CTX_init(ctx, sgl->trusted_store, sig->certificates->x509, trusted_chain) != 1) {
         sk_X509_free(trusted_chain);
         return ERR_OPENSSL;
     }
 
     // signing certificate to be verified
-    X509_STORE_CTX_set_cert(ctx, sgl->certificates->x509);
+    X509_STORE_CTX_set_cert(ctx, sig->certificates->x509);
 
     // verify
     if (X509_verify_cert(ctx) == 1) {
         // verification successful
-        sgl->result_cert_verification = CERT_STATUS_VERIFIED;
+        sig->result_cert_verification = CERT_STATUS_VERIFIED;
     } else {
         // verification not successful
-        sgl->result_cert_verification = CERT_STATUS_FAILED;
+        sig->result_cert_verification = CERT_STATUS_FAILED;
     }
 
     sk_X509_free(trusted_chain);
@@ -409,26 +859,27 @@ sigil_err_t verify_signing_certificate(sigil_t *sgl)
     return ERR_NONE;
 }
 
-sigil_err_t compare_digest(sigil_t *sgl)
+sigil_err_t compare_digest(signature_t *sig)
 {
-    if (sgl == NULL)
+    if (sig == NULL)
         return ERR_PARAMETER;
 
-    sgl->result_digest_comparison = HASH_CMP_RESULT_DIFFER;
+    sig->result_digest_comparison = HASH_CMP_RESULT_DIFFER;
 
-    if (sgl->digest_original == NULL || sgl->digest_computed == NULL)
+    if (sig->digest_original == NULL || sig->digest_computed == NULL)
         return ERR_PARAMETER;
 
-    if (ASN1_STRING_cmp(sgl->digest_original, sgl->digest_computed) == 0)
-        sgl->result_digest_comparison = HASH_CMP_RESULT_MATCH;
+    if (ASN1_STRING_cmp(sig->digest_original, sig->digest_computed) == 0)
+        sig->result_digest_comparison = HASH_CMP_RESULT_MATCH;
 
     return ERR_NONE;
 }
 
 int sigil_cryptography_self_test(int verbosity)
 {
-    sigil_t *sgl;
-    sigil_err_t err;
+    signature_t sig;
+
+    sigil_zeroize(&sig, sizeof(sig));
 
     print_module_name("cryptography", verbosity);
 
@@ -438,50 +889,306 @@ int sigil_cryptography_self_test(int verbosity)
     {
         const unsigned char *str_1 = (const unsigned char *)"123456789abcdef";
         const unsigned char *str_2 = (const unsigned char *)"fedcba987654321";
-        int result;
 
-        err = sigil_init(&sgl);
-        if (err != ERR_NONE || sgl == NULL)
+        sig.digest_original = ASN1_OCTET_STRING_new();
+        if (sig.digest_original == NULL)
+            goto failed;
+
+        sig.digest_computed = ASN1_OCTET_STRING_new();
+        if (sig.digest_computed == NULL)
             goto failed;
 
-        sgl->digest_original = ASN1_OCTET_STRING_new();
-        if (sgl->digest_original == NULL)
+        ASN1_OCTET_STRING_set(sig.digest_original, str_1, -1);
+        ASN1_OCTET_STRING_set(sig.digest_computed, str_1, -1);
+
+        if (compare_digest(&sig) != ERR_NONE)
             goto failed;
 
-        sgl->digest_computed = ASN1_OCTET_STRING_new();
-        if (sgl->digest_computed == NULL)
+        if (sig.result_digest_comparison != HASH_CMP_RESULT_MATCH)
             goto failed;
 
-        ASN1_OCTET_STRING_set(sgl->digest_original, str_1, -1);
-        ASN1_OCTET_STRING_set(sgl->digest_computed, str_1, -1);
+        ASN1_OCTET_STRING_free(sig.digest_computed);
 
-        if (compare_digest(sgl) != ERR_NONE)
+        sig.digest_computed = ASN1_OCTET_STRING_new();
+        if (sig.digest_computed == NULL)
             goto failed;
 
-        if (sigil_get_data_integrity_result(sgl, &result) != ERR_NONE)
+        ASN1_OCTET_STRING_set(sig.digest_computed, str_2, -1);
+
+        if (compare_digest(&sig) != ERR_NONE)
             goto failed;
 
-        if (result != HASH_CMP_RESULT_MATCH)
+        if (sig.result_digest_comparison != HASH_CMP_RESULT_DIFFER)
             goto failed;
 
-        ASN1_OCTET_STRING_free(sgl->digest_computed);
+        ASN1_OCTET_STRING_free(sig.digest_original);
+        ASN1_OCTET_STRING_free(sig.digest_computed);
+    }
 
-        sgl->digest_computed = ASN1_OCTET_STRING_new();
-        if (sgl->digest_computed == NULL)
-            goto failed;
+    print_test_result(1, verbosity);
 
-        ASN1_OCTET_STRING_set(sgl->digest_computed, str_2, -1);
+    // TEST: fn compute_digest_pkcs1 - nested byte ranges of incremental updates
+    print_test_item("fn compute_digest_pkcs1", verbosity);
 
-        if (compare_digest(sgl) != ERR_NONE)
+    {
+        // start, length of up to two ranges, and the function of each signature
+        const size_t ranges[][4] = {
+            {  0, 100, 150,  50 },
+            {  0, 300, 350, 100 },
+            {  0, 600, 650, 350 },
+            {  0, 300, 350, 100 },
+            {  0, 300, 350, 100 },
+            { 10,  50,   0,   0 }
+        };
+        const int sha1[] = { 0, 0, 0, 1, 0, 0 };
+        const size_t count = sizeof(sha1) / sizeof(*sha1);
+        signature_t sigs[sizeof(sha1) / sizeof(*sha1)];
+        signature_t *sig_ptr[sizeof(sha1) / sizeof(*sha1)];
+        range_t range[2 * sizeof(sha1) / sizeof(*sha1)];
+        char data[1000];
+        unsigned char expected[EVP_MAX_MD_SIZE];
+        unsigned int expected_len;
+        ASN1_OCTET_STRING *file_digest = NULL;
+        EVP_MD_CTX *ctx;
+        pool_t *pool;
+        sigil_t *sgl;
+        int ok = 1;
+
+        for (size_t i = 0; i < sizeof(data); i++) {
+            data[i] = (char)(i * 7 + i / 13);
+        }
+
+        sgl = test_prepare_sgl_buffer(data, sizeof(data));
+        if (sgl == NULL)
             goto failed;
 
-        if (sigil_get_data_integrity_result(sgl, &result) != ERR_NONE)
+        sigil_zeroize(sigs, sizeof(sigs));
+
+        for (size_t i = 0; i < count; i++) {
+            range[2 * i].start = ranges[i][0];
+            range[2 * i].length = ranges[i][1];
+            range[2 * i].next = NULL;
+            if (ranges[i][3] > 0) {
+                range[2 * i + 1].start = ranges[i][2];
+                range[2 * i + 1].length = ranges[i][3];
+                range[2 * i + 1].next = NULL;
+                range[2 * i].next = &(range[2 * i + 1]);
+            }
+
+            sigs[i].byte_range = &(range[2 * i]);
+            sigs[i].digest_algorithm = X509_ALGOR_new();
+            if (sigs[i].digest_algorithm != NULL) {
+                X509_ALGOR_set_md(sigs[i].digest_algorithm,
+                                  sha1[i] ? EVP_sha1() : EVP_sha256());
+            }
+            sig_ptr[i] = &(sigs[i]);
+        }
+
+        // on submit, and with the threads hashing the branches
+        for (size_t threads = 1; ok && threads <= 4; threads += 3) {
+            pool = pool_create(threads);
+            if (pool == NULL ||
+                compute_digest_pkcs1(sgl, pool, sig_ptr, count, &file_digest) != ERR_NONE)
+            {
+                ok = 0;
+            }
+            pool_free(pool);
+
+            // the whole file in the same pass
+            if (ok && (EVP_Digest(data, sizeof(data), expected, &expected_len,
+                                  EVP_sha256(), NULL) != 1 ||
+                       file_digest == NULL ||
+                       ASN1_STRING_length(file_digest) != (int)expected_len ||
+                       memcmp(ASN1_STRING_get0_data(file_digest), expected,
+                              expected_len) != 0))
+            {
+                ok = 0;
+            }
+
+            if (file_digest != NULL)
+                ASN1_OCTET_STRING_free(file_digest);
+            file_digest = NULL;
+
+            // the same as hashing each signature on its own
+            for (size_t i = 0; ok && i < count; i++) {
+                ctx = EVP_MD_CTX_create();
+                if (ctx == NULL ||
+                    EVP_DigestInit_ex(ctx, sha1[i] ? EVP_sha1() : EVP_sha256(), NULL) != 1)
+                {
+                    ok = 0;
+                }
+
+                for (range_t *r = sigs[i].byte_range; ok && r != NULL; r = r->next) {
+                    if (EVP_DigestUpdate(ctx, data + r->start, r->length) != 1)
+                        ok = 0;
+                }
+
+                if (ok && EVP_DigestFinal_ex(ctx, expected, &expected_len) != 1)
+                    ok = 0;
+
+                if (ctx != NULL)
+                    EVP_MD_CTX_destroy(ctx);
+
+                if (ok && (sigs[i].digest_computed == NULL ||
+                           ASN1_STRING_length(sigs[i].digest_computed) != (int)expected_len ||
+                           memcmp(ASN1_STRING_get0_data(sigs[i].digest_computed),
+                                  expected, expected_len) != 0 ||
+                           sigs[i].hash_fn != (sha1[i] ? HASH_FN_sha1 : HASH_FN_sha256)))
+                {
+                    ok = 0;
+                }
+            }
+
+            for (size_t i = 0; i < count; i++) {
+                if (sigs[i].digest_computed != NULL)
+                    ASN1_OCTET_STRING_free(sigs[i].digest_computed);
+                sigs[i].digest_computed = NULL;
+            }
+        }
+
+        // a signature with a function not allowed fails alone
+        if (ok && sigs[0].digest_algorithm != NULL) {
+            X509_ALGOR_set_md(sigs[0].digest_algorithm, EVP_md5());
+
+            pool = pool_create(1);
+            if (pool == NULL ||
+                compute_digest_pkcs1(sgl, pool, sig_ptr, count, NULL) != ERR_NONE ||
+                sigs[0].err != ERR_DIGEST_TYPE || sigs[0].digest_computed != NULL ||
+                sigs[1].err != ERR_NONE || sigs[1].digest_computed == NULL)
+            {
+                ok = 0;
+            }
+            pool_free(pool);
+        }
+
+        for (size_t i = 0; i < count; i++) {
+            if (sigs[i].digest_computed != NULL)
+                ASN1_OCTET_STRING_free(sigs[i].digest_computed);
+            if (sigs[i].digest_algorithm != NULL)
+                X509_ALGOR_free(sigs[i].digest_algorithm);
+        }
+
+        sigil_free(&sgl);
+
+        if (!ok)
             goto failed;
+    }
 
-        if (result != HASH_CMP_RESULT_DIFFER)
+    print_test_result(1, verbosity);
+
+    // TEST: fn digest_jobs - functions sharing one walk, ranges going back
+    print_test_item("fn digest_jobs", verbosity);
+
+    {
+        // base, then start and length of up to three ranges of each job
+        const size_t ranges[][7] = {
+            {  0, 600, 100,   0,  50,   0,   0 },
+            {  0,   0, 980,   0,   0,   0,   0 },
+            {  0,   0,  50, 200,   0, 300,  10 },
+            {  0,   0,   0,   0,   0,   0,   0 },
+            { 20,   0, 100,   0,   0,   0,   0 },
+            { 20, 600, 100,   0,  50,   0,   0 }
+        };
+        const EVP_MD *evp_md[6];
+        const size_t count = 6;
+        digest_job_t job[6];
+        range_t range[3 * 6];
+        range_t far_range;
+        char data[1000];
+        unsigned char expected[EVP_MAX_MD_SIZE];
+        unsigned int expected_len;
+        EVP_MD_CTX *ctx;
+        pool_t *pool;
+        sigil_t *sgl;
+        int ok = 1;
+
+        evp_md[0] = EVP_sha512();
+        evp_md[1] = EVP_sha1();
+        evp_md[2] = EVP_sha512();
+        evp_md[3] = EVP_sha256();
+        evp_md[4] = EVP_sha1();
+        evp_md[5] = EVP_sha512();
+
+        for (size_t i = 0; i < sizeof(data); i++) {
+            data[i] = (char)(i * 5 + i / 7);
+        }
+
+        sgl = test_prepare_sgl_buffer(data, sizeof(data));
+        if (sgl == NULL)
             goto failed;
 
+        sigil_zeroize(job, sizeof(job));
+
+        for (size_t i = 0; i < count; i++) {
+            job[i].evp_md = evp_md[i];
+            job[i].base = ranges[i][0];
+            job[i].range = NULL;
+
+            // the ranges linked from the last one, empty ones kept
+            for (size_t r = 3; r-- > 0; ) {
+                if (ranges[i][1 + 2 * r] == 0 && ranges[i][2 + 2 * r] == 0 &&
+                    job[i].range == NULL)
+                {
+                    continue;
+                }
+                range[3 * i + r].start = ranges[i][1 + 2 * r];
+                range[3 * i + r].length = ranges[i][2 + 2 * r];
+                range[3 * i + r].next = (range_t *)job[i].range;
+                job[i].range = &(range[3 * i + r]);
+            }
+        }
+
+        for (size_t threads = 1; ok && threads <= 4; threads += 3) {
+            pool = pool_create(threads);
+            if (pool == NULL || digest_jobs(sgl, pool, job, count) != ERR_NONE)
+                ok = 0;
+            pool_free(pool);
+
+            // the same as hashing each job on its own
+            for (size_t i = 0; ok && i < count; i++) {
+                ctx = EVP_MD_CTX_create();
+                if (ctx == NULL || EVP_DigestInit_ex(ctx, evp_md[i], NULL) != 1)
+                    ok = 0;
+
+                for (const range_t *r = job[i].range; ok && r != NULL; r = r->next) {
+                    if (EVP_DigestUpdate(ctx, data + job[i].base + r->start,
+                                         r->length) != 1)
+                    {
+                        ok = 0;
+                    }
+                }
+
+                if (ok && EVP_DigestFinal_ex(ctx, expected, &expected_len) != 1)
+                    ok = 0;
+
+                if (ctx != NULL)
+                    EVP_MD_CTX_destroy(ctx);
+
+                if (ok && (job[i].digest_len != expected_len ||
+                           memcmp(job[i].digest, expected, expected_len) != 0))
+                {
+                    ok = 0;
+                }
+
+                job[i].digest_len = 0;
+            }
+        }
+
+        // range out of the file
+        far_range.start = SIZE_MAX - 5;
+        far_range.length = 10;
+        far_range.next = NULL;
+        job[0].range = &far_range;
+
+        pool = pool_create(1);
+        if (ok && (pool == NULL || digest_jobs(sgl, pool, job, 1) == ERR_NONE))
+            ok = 0;
+        pool_free(pool);
+
         sigil_free(&sgl);
+
+        if (!ok)
+            goto failed;
     }
 
     print_test_result(1, verbosity);
@@ -491,8 +1198,10 @@ int sigil_cryptography_self_test(int verbosity)
     return 0;
 
 failed:
-    if (sgl != NULL)
-        sigil_free(&sgl);
+    if (sig.digest_original != NULL)
+        ASN1_OCTET_STRING_free(sig.digest_original);
+    if (sig.digest_computed != NULL)
+        ASN1_OCTET_STRING_free(sig.digest_computed);
 
     print_test_result(0, verbosity);
     print_module_result(0, verbosity);
@@ -1,63 +1,74 @@
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include "auxiliary.h"
 #include "config.h"
 #include "constants.h"
 #include "header.h"
+#include "mem.h"
 #include "sigil.h"
 
 sigil_err_t process_header(sigil_t *sgl)
 {
     sigil_err_t err;
-    size_t offset;
-    char tmp[6],
+    const char *head;
+    char *copy = NULL,
          c;
-    size_t read_size;
+    size_t head_size,
+           offset;
     size_t pdf_x, pdf_y;
 
     if (sgl == NULL)
         return ERR_PARAMETER;
 
-    for (offset = 0; offset < HEADER_SEARCH_OFFSET; offset++) {
-        err = pdf_move_pos_abs(sgl, offset);
-        if (err != ERR_NONE)
-            return err;
+    if (sgl->pdf_data.size <= 0)
+        return ERR_NO_DATA;
 
-        err = pdf_read(sgl, 5, tmp, &read_size);
-        if (err != ERR_NONE)
-            return err;
-        if (read_size != 5)
-            return ERR_PDF_CONTENT;
+    sgl->offset_pdf_start = 0;
 
-        if (strncmp(tmp, "\x25PDF-", 5) != 0)
-            continue;
+    // the header may start at any of the first HEADER_SEARCH_OFFSET bytes
+    head_size = MIN(HEADER_SEARCH_OFFSET + 4, sgl->pdf_data.size);
 
-        if ((err = parse_number(sgl, &pdf_x)) != ERR_NONE)
-            return err;
+    err = pdf_view(sgl, 0, head_size, &head, &copy);
+    if (err != ERR_NONE)
+        return err;
 
-        if ((err = pdf_get_char(sgl, &c)) != ERR_NONE)
-            return err;
-        if (c != '.')
-            return ERR_PDF_CONTENT;
+    offset = find_str(head, head_size, "\x25PDF-", 5);
 
-        if ((err = parse_number(sgl, &pdf_y)) != ERR_NONE)
-            return err;
+    if (copy != NULL) {
+        sigil_zeroize(copy, sizeof(*copy) * head_size);
+        mem_free(copy);
+    }
 
-        if ((pdf_x == 1 && pdf_y >= 0 && pdf_y <= 7) ||
-            (pdf_x == 2 && pdf_y == 0))
-        {
-            sgl->pdf_x = (short)pdf_x;
-            sgl->pdf_y = (short)pdf_y;
-        } else {
-            return ERR_PDF_CONTENT;
-        }
+    if (offset >= head_size)
+        return ERR_PDF_CONTENT;
+
+    if ((err = pdf_move_pos_abs(sgl, offset + 5)) != ERR_NONE)
+        return err;
 
-        sgl->offset_pdf_start = offset;
+    if ((err = parse_number(sgl, &pdf_x)) != ERR_NONE)
+        return err;
 
-        return ERR_NONE;
+    if ((err = pdf_get_char(sgl, &c)) != ERR_NONE)
+        return err;
+    if (c != '.')
+        return ERR_PDF_CONTENT;
+
+    if ((err = parse_number(sgl, &pdf_y)) != ERR_NONE)
+        return err;
+
+    if ((pdf_x == 1 && pdf_y >= 0 && pdf_y <= 7) ||
+        (pdf_x == 2 && pdf_y == 0))
+    {
+        sgl->pdf_x = (short)pdf_x;
+        sgl->pdf_y = (short)pdf_y;
+    } else {
+        return ERR_PDF_CONTENT;
     }
 
-    return ERR_PDF_CONTENT;
+    sgl->offset_pdf_start = offset;
+
+    return ERR_NONE;
 }
 
 int sigil_header_self_test(int verbosity)
@@ -112,6 +123,18 @@ int sigil_header_self_test(int verbosity)
             goto failed;
 
         sigil_free(&sgl);
+
+        // no header within the first HEADER_SEARCH_OFFSET bytes
+        char sstream_3[HEADER_SEARCH_OFFSET + 16];
+        memset(sstream_3, ' ', HEADER_SEARCH_OFFSET);
+        strcpy(sstream_3 + HEADER_SEARCH_OFFSET, "\x25PDF-1.3 x");
+        if ((sgl = test_prepare_sgl_buffer(sstream_3, strlen(sstream_3) + 1)) == NULL)
+            goto failed;
+
+        if (process_header(sgl) != ERR_PDF_CONTENT)
+            goto failed;
+
+        sigil_free(&sgl);
     }
 
     print_test_result(1, verbosity);
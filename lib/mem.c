@@ -0,0 +1,206 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "auxiliary.h"
+#include "constants.h"
+#include "mem.h"
+#include "types.h"
+
+static void *libc_malloc(void *ctx, size_t size)
+{
+    (void)ctx;
+    return malloc(size);
+}
+
+static void *libc_realloc(void *ctx, void *ptr, size_t size)
+{
+    (void)ctx;
+    return realloc(ptr, size);
+}
+
+static void libc_free(void *ctx, void *ptr)
+{
+    (void)ctx;
+    free(ptr);
+}
+
+static sigil_allocator_t current = {
+    NULL,
+    libc_malloc,
+    libc_realloc,
+    libc_free
+};
+
+sigil_err_t mem_set_allocator(const sigil_allocator_t *allocator)
+{
+    if (allocator == NULL) {
+        current.ctx     = NULL;
+        current.malloc  = libc_malloc;
+        current.realloc = libc_realloc;
+        current.free    = libc_free;
+        return ERR_NONE;
+    }
+
+    if (allocator->malloc == NULL || allocator->realloc == NULL ||
+        allocator->free == NULL)
+    {
+        return ERR_PARAMETER;
+    }
+
+    current = *allocator;
+
+    return ERR_NONE;
+}
+
+void *mem_alloc(size_t size)
+{
+    return current.malloc(current.ctx, size);
+}
+
+void *mem_calloc(size_t count, size_t size)
+{
+    void *ptr;
+
+    if (size != 0 && count > SIZE_MAX / size)
+        return NULL;
+
+    ptr = current.malloc(current.ctx, count * size);
+    if (ptr != NULL)
+        memset(ptr, 0, count * size);
+
+    return ptr;
+}
+
+void *mem_realloc(void *ptr, size_t size)
+{
+    return current.realloc(current.ctx, ptr, size);
+}
+
+void mem_free(void *ptr)
+{
+    if (ptr == NULL)
+        return;
+
+    current.free(current.ctx, ptr);
+}
+
+static void *test_malloc(void *ctx, size_t size)
+{
+    ((test_counter_t *)ctx)->allocated++;
+    return malloc(size);
+}
+
+static void *test_realloc(void *ctx, void *ptr, size_t size)
+{
+    if (ptr == NULL)
+        ((test_counter_t *)ctx)->allocated++;
+    return realloc(ptr, size);
+}
+
+static void test_free(void *ctx, void *ptr)
+{
+    ((test_counter_t *)ctx)->released++;
+    free(ptr);
+}
+
+void test_count_allocator(sigil_allocator_t *allocator, test_counter_t *counter)
+{
+    counter->allocated = 0;
+    counter->released = 0;
+
+    allocator->ctx     = counter;
+    allocator->malloc  = test_malloc;
+    allocator->realloc = test_realloc;
+    allocator->free    = test_free;
+}
+
+int sigil_mem_self_test(int verbosity)
+{
+    test_counter_t counter;
+    sigil_allocator_t allocator;
+
+    print_module_name("mem", verbosity);
+
+    test_count_allocator(&allocator, &counter);
+
+    // TEST: fn mem_set_allocator
+    print_test_item("fn mem_set_allocator", verbosity);
+
+    {
+        char *data;
+
+        if (mem_set_allocator(&allocator) != ERR_NONE)
+            goto failed;
+
+        data = mem_alloc(16);
+        if (data == NULL)
+            goto failed;
+
+        data = mem_realloc(data, 32);
+        if (data == NULL)
+            goto failed;
+
+        mem_free(data);
+        mem_free(NULL);
+
+        if (counter.allocated != 1 || counter.released != 1)
+            goto failed;
+
+        allocator.free = NULL;
+        if (mem_set_allocator(&allocator) != ERR_PARAMETER)
+            goto failed;
+        allocator.free = test_free;
+
+        // the previous one still in use after the failed call
+        mem_free(mem_alloc(1));
+        if (counter.allocated != 2 || counter.released != 2)
+            goto failed;
+
+        if (mem_set_allocator(NULL) != ERR_NONE)
+            goto failed;
+
+        mem_free(mem_alloc(1));
+        if (counter.allocated != 2 || counter.released != 2)
+            goto failed;
+    }
+
+    print_test_result(1, verbosity);
+
+    // TEST: fn mem_calloc
+    print_test_item("fn mem_calloc", verbosity);
+
+    {
+        unsigned char *data;
+
+        data = mem_calloc(7, 3);
+        if (data == NULL)
+            goto failed;
+
+        for (size_t i = 0; i < 21; i++) {
+            if (data[i] != 0) {
+                mem_free(data);
+                goto failed;
+            }
+        }
+
+        mem_free(data);
+
+        if (mem_calloc(SIZE_MAX / 2, 3) != NULL)
+            goto failed;
+    }
+
+    print_test_result(1, verbosity);
+
+    // all tests done
+    print_module_result(1, verbosity);
+
+    return 0;
+
+failed:
+    mem_set_allocator(NULL);
+
+    print_test_result(0, verbosity);
+    print_module_result(0, verbosity);
+
+    return 1;
+}
@@ -0,0 +1,575 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "auxiliary.h"
+#include "config.h"
+#include "constants.h"
+#include "mem.h"
+#include "objstm.h"
+#include "sigil.h"
+#include "stream.h"
+#include "types.h"
+#include "xref.h"
+
+/** @brief Frees the decoded data of the cache entry, the entry becomes unused
+ *
+ */
+static void objstm_clear(objstm_t *objstm)
+{
+    if (objstm->data != NULL) {
+        sigil_zeroize(objstm->data, sizeof(*objstm->data) * objstm->size);
+        mem_free(objstm->data);
+    }
+    if (objstm->object != NULL)
+        mem_free(objstm->object);
+    if (objstm->offset != NULL)
+        mem_free(objstm->offset);
+
+    sigil_zeroize(objstm, sizeof(*objstm));
+}
+
+/** @brief Puts the decoded data of the object stream in place of the PDF data,
+ *         the PDF data are kept aside until objstm_leave
+ *
+ */
+static void objstm_enter(sigil_t *sgl, const objstm_t *objstm)
+{
+    if (!sgl->objstm.active) {
+        sgl->objstm.saved_pdf_data = sgl->pdf_data;
+        sgl->objstm.saved_offset_pdf_start = sgl->offset_pdf_start;
+        sgl->objstm.active = 1;
+    }
+
+    sigil_zeroize(&(sgl->pdf_data), sizeof(sgl->pdf_data));
+    sgl->pdf_data.buffer = objstm->data;
+    sgl->pdf_data.size = objstm->size;
+    sgl->pdf_data.fd = -1;
+    sgl->offset_pdf_start = 0;
+}
+
+void objstm_leave(sigil_t *sgl)
+{
+    if (sgl == NULL || !sgl->objstm.active)
+        return;
+
+    sgl->pdf_data = sgl->objstm.saved_pdf_data;
+    sgl->offset_pdf_start = sgl->objstm.saved_offset_pdf_start;
+
+    sigil_zeroize(&(sgl->objstm.saved_pdf_data), sizeof(sgl->objstm.saved_pdf_data));
+    sgl->objstm.saved_offset_pdf_start = 0;
+    sgl->objstm.active = 0;
+}
+
+/** @brief Loads the value of /Length from the current position in the PDF,
+ *         which may be an indirect reference to an object outside of any
+ *         object stream
+ *
+ */
+static sigil_err_t parse_length(sigil_t *sgl, size_t *length)
+{
+    sigil_err_t err;
+    reference_t ref;
+    uint8_t type;
+    size_t position,
+           offset,
+           generation;
+
+    if ((err = get_curr_position(sgl, &position)) != ERR_NONE)
+        return err;
+
+    // direct number, unless followed by the generation number and "R"
+    if (parse_indirect_reference(sgl, &ref) != ERR_NONE) {
+        if ((err = pdf_move_pos_abs(sgl, position)) != ERR_NONE)
+            return err;
+
+        return parse_number(sgl, length);
+    }
+
+    if ((err = get_curr_position(sgl, &position)) != ERR_NONE)
+        return err;
+
+    // no nesting of the object streams
+    err = xref_get_entry(sgl, &ref, &type, &offset, &generation);
+    if (err != ERR_NONE)
+        return err;
+    if (type != XREF_ENTRY_IN_USE)
+        return ERR_PDF_CONTENT;
+
+    if ((err = pdf_goto_obj(sgl, &ref)) != ERR_NONE)
+        return err;
+
+    if ((err = parse_number(sgl, length)) != ERR_NONE)
+        return err;
+
+    return pdf_move_pos_abs(sgl, position);
+}
+
+/** @brief Reads the whole decoded data of the stream, the current position
+ *         in PDF needs to be right after the stream dictionary
+ *
+ */
+static sigil_err_t read_stream_data(sigil_t *sgl, stream_t *stream,
+                                    size_t length, objstm_t *objstm)
+{
+    sigil_err_t err;
+    size_t capacity = STREAM_CHUNK_SIZE,
+           read_size;
+    void *tmp;
+
+    err = stream_open(sgl, stream, length);
+    if (err != ERR_NONE)
+        return err;
+
+    objstm->data = mem_alloc(sizeof(*objstm->data) * capacity);
+    if (objstm->data == NULL)
+        return ERR_ALLOCATION;
+
+    while ((err = stream_read(sgl, stream, objstm->data + objstm->size,
+                              capacity - objstm->size, &read_size)) == ERR_NONE)
+    {
+        objstm->size += read_size;
+
+        if (objstm->size >= capacity) {
+            tmp = mem_realloc(objstm->data, sizeof(*objstm->data) * capacity * 2);
+            if (tmp == NULL)
+                return ERR_ALLOCATION;
+            objstm->data = tmp;
+            capacity *= 2;
+        }
+    }
+
+    if (err != ERR_NO_DATA)
+        return err;
+
+    return ERR_NONE;
+}
+
+/** @brief Decodes the object stream into the cache entry, including the table
+ *         of the object numbers and positions from its beginning
+ *
+ */
+static sigil_err_t objstm_load(sigil_t *sgl, size_t stream_num, objstm_t *objstm)
+{
+    sigil_err_t err;
+    stream_t stream;
+    reference_t ref;
+    dict_key_t dict_key;
+    uint8_t type;
+    size_t count = 0,
+           first = 0,
+           length = 0,
+           offset,
+           generation;
+
+    ref.object_num = stream_num;
+    ref.generation_num = 0;
+
+    // object streams can't be compressed in another object stream
+    err = xref_get_entry(sgl, &ref, &type, &offset, &generation);
+    if (err != ERR_NONE)
+        return err;
+    if (type != XREF_ENTRY_IN_USE)
+        return ERR_PDF_CONTENT;
+
+    stream_init(&stream);
+
+    if ((err = pdf_goto_obj(sgl, &ref)) != ERR_NONE ||
+        (err = skip_word(sgl, "<<")) != ERR_NONE)
+    {
+        goto end;
+    }
+
+    while ((err = parse_dict_key(sgl, &dict_key)) == ERR_NONE) {
+        switch (dict_key) {
+            case DICT_KEY_N:
+                err = parse_number(sgl, &count);
+                break;
+            case DICT_KEY_First:
+                err = parse_number(sgl, &first);
+                break;
+            case DICT_KEY_Length:
+                err = parse_length(sgl, &length);
+                break;
+            case DICT_KEY_Filter:
+                err = stream_parse_filter(sgl, &stream);
+                break;
+            case DICT_KEY_DecodeParms:
+                err = stream_parse_decode_parms(sgl, &stream);
+                break;
+            default: // also the known keys not used in this dictionary
+                err = skip_dict_unknown_value(sgl);
+                break;
+        }
+
+        if (err != ERR_NONE)
+            goto end;
+    }
+
+    if (err != ERR_END_OF_DICT)
+        goto end;
+
+    objstm->object_num = stream_num;
+
+    err = read_stream_data(sgl, &stream, length, objstm);
+    if (err != ERR_NONE)
+        goto end;
+
+    // each pair of numbers takes at least 4 bytes before the first object
+    if (count <= 0 || first >= objstm->size || count > first / 4 + 1) {
+        err = ERR_PDF_CONTENT;
+        goto end;
+    }
+
+    objstm->object = mem_alloc(sizeof(*objstm->object) * count);
+    objstm->offset = mem_alloc(sizeof(*objstm->offset) * count);
+    if (objstm->object == NULL || objstm->offset == NULL) {
+        err = ERR_ALLOCATION;
+        goto end;
+    }
+    objstm->count = count;
+
+    // the pairs of object number and offset are parsed from the decoded data
+    objstm_enter(sgl, objstm);
+
+    for (size_t i = 0; i < count; i++) {
+        if ((err = parse_number(sgl, &(objstm->object[i]))) != ERR_NONE ||
+            (err = parse_number(sgl, &offset)) != ERR_NONE)
+        {
+            break;
+        }
+
+        if (offset >= objstm->size - first) {
+            err = ERR_PDF_CONTENT;
+            break;
+        }
+        objstm->offset[i] = first + offset;
+    }
+
+    objstm_leave(sgl);
+
+end:
+    stream_free(&stream);
+
+    return err;
+}
+
+sigil_err_t objstm_goto_obj(sigil_t *sgl, size_t stream_num, size_t index,
+                            const reference_t *ref)
+{
+    sigil_err_t err;
+    objstm_cache_t *cache;
+    objstm_t *objstm = NULL;
+
+    if (sgl == NULL || ref == NULL)
+        return ERR_PARAMETER;
+
+    objstm_leave(sgl);
+
+    cache = &(sgl->objstm);
+
+    if (cache->entry == NULL) {
+        cache->entry = mem_alloc(sizeof(*cache->entry) * OBJSTM_CACHE_SIZE);
+        if (cache->entry == NULL)
+            return ERR_ALLOCATION;
+        sigil_zeroize(cache->entry, sizeof(*cache->entry) * OBJSTM_CACHE_SIZE);
+    }
+
+    for (size_t i = 0; i < OBJSTM_CACHE_SIZE; i++) {
+        if (cache->entry[i].data != NULL &&
+            cache->entry[i].object_num == stream_num)
+        {
+            objstm = &(cache->entry[i]);
+            break;
+        }
+    }
+
+    if (objstm == NULL) {
+        // unused entry, or the least recently used one
+        objstm = &(cache->entry[0]);
+        for (size_t i = 1; i < OBJSTM_CACHE_SIZE && objstm->data != NULL; i++) {
+            if (cache->entry[i].data == NULL ||
+                cache->entry[i].last_use < objstm->last_use)
+            {
+                objstm = &(cache->entry[i]);
+            }
+        }
+
+        objstm_clear(objstm);
+
+        err = objstm_load(sgl, stream_num, objstm);
+        if (err != ERR_NONE) {
+            objstm_clear(objstm);
+            return err;
+        }
+    }
+
+    objstm->last_use = ++(cache->clock);
+
+    if (index >= objstm->count || objstm->object[index] != ref->object_num)
+        return ERR_PDF_CONTENT;
+
+    objstm_enter(sgl, objstm);
+
+    return pdf_move_pos_abs(sgl, objstm->offset[index]);
+}
+
+sigil_err_t objstm_list_objects(sigil_t *sgl, size_t stream_num,
+                                size_t **object, size_t *count)
+{
+    sigil_err_t err;
+    objstm_t objstm;
+
+    if (sgl == NULL || object == NULL || count == NULL)
+        return ERR_PARAMETER;
+
+    // decoded aside from the cache, the cache entries may be in use
+    sigil_zeroize(&objstm, sizeof(objstm));
+
+    err = objstm_load(sgl, stream_num, &objstm);
+    if (err == ERR_NONE) {
+        *object = objstm.object;
+        *count = objstm.count;
+        objstm.object = NULL;
+    }
+
+    objstm_clear(&objstm);
+
+    return err;
+}
+
+void objstm_free(sigil_t *sgl)
+{
+    if (sgl == NULL)
+        return;
+
+    objstm_leave(sgl);
+
+    if (sgl->objstm.entry != NULL) {
+        for (size_t i = 0; i < OBJSTM_CACHE_SIZE; i++) {
+            objstm_clear(&(sgl->objstm.entry[i]));
+        }
+
+        mem_free(sgl->objstm.entry);
+        sgl->objstm.entry = NULL;
+    }
+
+    sgl->objstm.clock = 0;
+}
+
+/** @brief Whether the object stream is decoded in the cache
+ *
+ */
+static int test_is_cached(sigil_t *sgl, size_t stream_num)
+{
+    if (sgl->objstm.entry == NULL)
+        return 0;
+
+    for (size_t i = 0; i < OBJSTM_CACHE_SIZE; i++) {
+        if (sgl->objstm.entry[i].data != NULL &&
+            sgl->objstm.entry[i].object_num == stream_num)
+        {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+int sigil_objstm_self_test(int verbosity)
+{
+    sigil_t *sgl = NULL;
+
+    print_module_name("objstm", verbosity);
+
+    // TEST: fn objstm_goto_obj
+    print_test_item("fn objstm_goto_obj", verbosity);
+
+    {
+        reference_t ref;
+        size_t size;
+
+        sgl = test_prepare_sgl_path("test/object_stream.pdf");
+        if (sgl == NULL)
+            goto failed;
+
+        size = sgl->pdf_data.size;
+
+        if (read_startxref(sgl) != ERR_NONE ||
+            pdf_move_pos_abs(sgl, sgl->offset_startxref) != ERR_NONE ||
+            (sgl->xref = xref_init()) == NULL ||
+            process_xref(sgl) != ERR_NONE ||
+            process_xref_streams(sgl) != ERR_NONE)
+        {
+            goto failed;
+        }
+
+        // catalog, AcroForm and signature field from the same object stream
+        ref.generation_num = 0;
+        ref.object_num = 12;
+        if (pdf_goto_obj(sgl, &ref) != ERR_NONE ||
+            !sgl->objstm.active ||
+            skip_word(sgl, "<</Type /Catalog") != ERR_NONE)
+        {
+            goto failed;
+        }
+
+        ref.object_num = 21;
+        if (pdf_goto_obj(sgl, &ref) != ERR_NONE ||
+            skip_word(sgl, "<</Fields [14 0 R]") != ERR_NONE)
+        {
+            goto failed;
+        }
+
+        ref.object_num = 14;
+        if (pdf_goto_obj(sgl, &ref) != ERR_NONE ||
+            skip_word(sgl, "<</FT /Sig") != ERR_NONE)
+        {
+            goto failed;
+        }
+
+        // decoded only once
+        if (!test_is_cached(sgl, 19) ||
+            sgl->objstm.entry[0].object_num != 19 ||
+            sgl->objstm.entry[1].data != NULL ||
+            sgl->objstm.clock != 3)
+        {
+            goto failed;
+        }
+
+        // object not at the index
+        ref.object_num = 21;
+        if (objstm_goto_obj(sgl, 19, 0, &ref) != ERR_PDF_CONTENT)
+            goto failed;
+
+        objstm_leave(sgl);
+        if (sgl->objstm.active || sgl->pdf_data.size != size)
+            goto failed;
+
+        sigil_free(&sgl);
+    }
+
+    print_test_result(1, verbosity);
+
+    // TEST: replacing the least recently used object stream
+    print_test_item("LRU replacement", verbosity);
+
+    {
+        char pdf[4096];
+        size_t pos,
+               xref_pos,
+               offset[OBJSTM_CACHE_SIZE + 1],
+               count = OBJSTM_CACHE_SIZE + 1;
+        reference_t ref;
+
+        // object streams 1 to count, each with one object numbered from 100
+        pos = (size_t)sprintf(pdf, "%%PDF-1.5\n");
+        for (size_t i = 0; i < count; i++) {
+            offset[i] = pos;
+            pos += (size_t)sprintf(pdf + pos,
+                "%zu 0 obj\n<</Type /ObjStm /N 1 /First 6 /Length 10>>\n"
+                "stream\n%zu 0 <<>>\nendstream\nendobj\n", i + 1, 100 + i);
+        }
+
+        // uncompressed cross-reference stream, W [1 2 1]
+        xref_pos = pos;
+        pos += (size_t)sprintf(pdf + pos,
+            "%zu 0 obj\n<</Type /XRef /Size %zu /W [1 2 1] /Index [1 %zu 100 %zu]"
+            " /Length %zu>>\nstream\n", count + 1, 100 + count, count, count,
+            8 * count);
+        for (size_t i = 0; i < count; i++) {
+            pdf[pos++] = 1;
+            pdf[pos++] = (char)(offset[i] >> 8);
+            pdf[pos++] = (char)(offset[i] & 0xff);
+            pdf[pos++] = 0;
+        }
+        for (size_t i = 0; i < count; i++) {
+            pdf[pos++] = 2;
+            pdf[pos++] = (char)((i + 1) >> 8);
+            pdf[pos++] = (char)((i + 1) & 0xff);
+            pdf[pos++] = 0;
+        }
+        pos += (size_t)sprintf(pdf + pos,
+            "\nendstream\nendobj\nstartxref\n%zu\n%%%%EOF\n", xref_pos);
+
+        if ((sgl = test_prepare_sgl_buffer(pdf, pos)) == NULL)
+            goto failed;
+
+        if (read_startxref(sgl) != ERR_NONE ||
+            pdf_move_pos_abs(sgl, sgl->offset_startxref) != ERR_NONE ||
+            (sgl->xref = xref_init()) == NULL ||
+            process_xref(sgl) != ERR_NONE ||
+            process_xref_streams(sgl) != ERR_NONE)
+        {
+            goto failed;
+        }
+
+        ref.generation_num = 0;
+
+        // fill the cache, then use the first stream again
+        for (size_t i = 0; i < count - 1; i++) {
+            ref.object_num = 100 + i;
+            if (pdf_goto_obj(sgl, &ref) != ERR_NONE ||
+                skip_word(sgl, "<<>>") != ERR_NONE)
+            {
+                goto failed;
+            }
+        }
+
+        ref.object_num = 100;
+        if (pdf_goto_obj(sgl, &ref) != ERR_NONE)
+            goto failed;
+
+        ref.object_num = 100 + count - 1;
+        if (pdf_goto_obj(sgl, &ref) != ERR_NONE ||
+            skip_word(sgl, "<<>>") != ERR_NONE)
+        {
+            goto failed;
+        }
+
+        if (!test_is_cached(sgl, count) ||
+            (count > 2 && (!test_is_cached(sgl, 1) || test_is_cached(sgl, 2))))
+        {
+            goto failed;
+        }
+
+        sigil_free(&sgl);
+    }
+
+    print_test_result(1, verbosity);
+
+    // TEST: verification with the dictionaries in an object stream
+    print_test_item("VERIFY with object stream", verbosity);
+
+    {
+        int result;
+
+        sgl = test_prepare_sgl_path("test/object_stream.pdf");
+        if (sgl == NULL)
+            goto failed;
+
+        if (sigil_verify(sgl) != ERR_NONE ||
+            sgl->objstm.active ||
+            sigil_get_data_integrity_result(sgl, &result) != ERR_NONE ||
+            result != HASH_CMP_RESULT_MATCH)
+        {
+            goto failed;
+        }
+
+        sigil_free(&sgl);
+    }
+
+    print_test_result(1, verbosity);
+
+    // all tests done
+    print_module_result(1, verbosity);
+    return 0;
+
+failed:
+    if (sgl)
+        sigil_free(&sgl);
+
+    print_test_result(0, verbosity);
+    print_module_result(0, verbosity);
+
+    return 1;
+}
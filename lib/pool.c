@@ -0,0 +1,322 @@
+#include <stdlib.h>
+#include "auxiliary.h"
+#include "constants.h"
+#include "mem.h"
+#include "pool.h"
+#include "types.h"
+
+#ifndef _WIN32
+    #include <unistd.h>
+#endif
+
+static void record_error(pool_t *pool, sigil_err_t err)
+{
+    if (err != ERR_NONE && pool->err == ERR_NONE)
+        pool->err = err;
+}
+
+#ifndef _WIN32
+static void *pool_worker(void *arg)
+{
+    pool_t *pool = arg;
+    pool_task_t *task;
+    sigil_err_t err;
+
+    pthread_mutex_lock(&(pool->lock));
+
+    while (1) {
+        while (pool->head == NULL && !pool->shutdown)
+            pthread_cond_wait(&(pool->work), &(pool->lock));
+
+        if (pool->head == NULL)
+            break;
+
+        task = pool->head;
+        pool->head = task->next;
+        if (pool->head == NULL)
+            pool->tail = NULL;
+        pool->running++;
+
+        pthread_mutex_unlock(&(pool->lock));
+
+        err = task->run(pool, task->arg);
+        mem_free(task);
+
+        pthread_mutex_lock(&(pool->lock));
+
+        record_error(pool, err);
+        pool->running--;
+
+        if (pool->head == NULL && pool->running <= 0)
+            pthread_cond_broadcast(&(pool->idle));
+    }
+
+    pthread_mutex_unlock(&(pool->lock));
+
+    return NULL;
+}
+#endif
+
+size_t pool_thread_count(const sigil_t *sgl, size_t count, size_t max)
+{
+    size_t threads = MIN(count, max);
+
+    if (sgl == NULL || sgl->pdf_data.buffer == NULL)
+        return 1;
+
+    #ifdef _WIN32
+        threads = 1;
+    #else
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        if (cpus > 0)
+            threads = MIN(threads, (size_t)cpus);
+    #endif
+
+    return MAX(threads, 1);
+}
+
+pool_t *pool_create(size_t threads)
+{
+    pool_t *pool;
+
+    pool = mem_alloc(sizeof(*pool));
+    if (pool == NULL)
+        return NULL;
+
+    sigil_zeroize(pool, sizeof(*pool));
+
+    pool->threads  = 0;
+    pool->head     = NULL;
+    pool->tail     = NULL;
+    pool->running  = 0;
+    pool->shutdown = 0;
+    pool->err      = ERR_NONE;
+
+    #ifndef _WIN32
+        pool->thread = NULL;
+
+        if (threads <= 1)
+            return pool;
+
+        pool->thread = mem_alloc(sizeof(*pool->thread) * threads);
+        if (pool->thread == NULL)
+            return pool;
+
+        if (pthread_mutex_init(&(pool->lock), NULL) != 0) {
+            mem_free(pool->thread);
+            pool->thread = NULL;
+            return pool;
+        }
+
+        if (pthread_cond_init(&(pool->work), NULL) != 0) {
+            pthread_mutex_destroy(&(pool->lock));
+            mem_free(pool->thread);
+            pool->thread = NULL;
+            return pool;
+        }
+
+        if (pthread_cond_init(&(pool->idle), NULL) != 0) {
+            pthread_cond_destroy(&(pool->work));
+            pthread_mutex_destroy(&(pool->lock));
+            mem_free(pool->thread);
+            pool->thread = NULL;
+            return pool;
+        }
+
+        // the tasks are run on submit if no thread starts
+        while (pool->threads < threads) {
+            if (pthread_create(&(pool->thread[pool->threads]), NULL,
+                               pool_worker, pool) != 0)
+            {
+                break;
+            }
+            pool->threads++;
+        }
+    #else
+        (void)threads;
+    #endif
+
+    return pool;
+}
+
+sigil_err_t pool_submit(pool_t *pool, pool_fn_t run, void *arg)
+{
+    pool_task_t *task;
+
+    if (pool == NULL || run == NULL)
+        return ERR_PARAMETER;
+
+    if (pool->threads <= 0) {
+        record_error(pool, run(pool, arg));
+        return ERR_NONE;
+    }
+
+    task = mem_alloc(sizeof(*task));
+    if (task == NULL)
+        return ERR_ALLOCATION;
+
+    task->run = run;
+    task->arg = arg;
+    task->next = NULL;
+
+    #ifndef _WIN32
+        pthread_mutex_lock(&(pool->lock));
+
+        if (pool->tail != NULL) {
+            pool->tail->next = task;
+        } else {
+            pool->head = task;
+        }
+        pool->tail = task;
+
+        pthread_cond_signal(&(pool->work));
+        pthread_mutex_unlock(&(pool->lock));
+    #endif
+
+    return ERR_NONE;
+}
+
+sigil_err_t pool_wait(pool_t *pool)
+{
+    sigil_err_t err;
+
+    if (pool == NULL)
+        return ERR_PARAMETER;
+
+    #ifndef _WIN32
+        if (pool->threads > 0) {
+            pthread_mutex_lock(&(pool->lock));
+
+            while (pool->head != NULL || pool->running > 0)
+                pthread_cond_wait(&(pool->idle), &(pool->lock));
+
+            err = pool->err;
+            pool->err = ERR_NONE;
+
+            pthread_mutex_unlock(&(pool->lock));
+
+            return err;
+        }
+    #endif
+
+    err = pool->err;
+    pool->err = ERR_NONE;
+
+    return err;
+}
+
+void pool_free(pool_t *pool)
+{
+    if (pool == NULL)
+        return;
+
+    #ifndef _WIN32
+        if (pool->thread != NULL) {
+            if (pool->threads > 0) {
+                pthread_mutex_lock(&(pool->lock));
+                pool->shutdown = 1;
+                pthread_cond_broadcast(&(pool->work));
+                pthread_mutex_unlock(&(pool->lock));
+
+                for (size_t i = 0; i < pool->threads; i++) {
+                    pthread_join(pool->thread[i], NULL);
+                }
+            }
+
+            pthread_cond_destroy(&(pool->idle));
+            pthread_cond_destroy(&(pool->work));
+            pthread_mutex_destroy(&(pool->lock));
+            mem_free(pool->thread);
+        }
+    #endif
+
+    mem_free(pool);
+}
+
+// the task fills its slot, the first ones submit one more task each
+typedef struct {
+    int   *slot;
+    size_t index;
+    size_t count;
+} test_task_t;
+
+static sigil_err_t test_task(pool_t *pool, void *arg)
+{
+    test_task_t *task = arg;
+
+    task->slot[task->index] = 1;
+
+    if (task->index < task->count) {
+        task[task->count].slot = task->slot;
+        task[task->count].index = task->index + task->count;
+        task[task->count].count = task->count;
+        return pool_submit(pool, test_task, &(task[task->count]));
+    }
+
+    return task->index == 2 * task->count - 1 ? ERR_NO_DATA : ERR_NONE;
+}
+
+int sigil_pool_self_test(int verbosity)
+{
+    pool_t *pool = NULL;
+
+    print_module_name("pool", verbosity);
+
+    // TEST: fn pool_submit - on submit, and with the threads
+    print_test_item("fn pool_submit", verbosity);
+
+    for (size_t threads = 1; threads <= 4; threads += 3) {
+        test_task_t task[2 * 16];
+        int slot[2 * 16];
+
+        pool = pool_create(threads);
+        if (pool == NULL)
+            goto failed;
+
+        for (size_t i = 0; i < 2 * 16; i++) {
+            slot[i] = 0;
+        }
+
+        for (size_t i = 0; i < 16; i++) {
+            task[i].slot = slot;
+            task[i].index = i;
+            task[i].count = 16;
+            if (pool_submit(pool, test_task, &(task[i])) != ERR_NONE)
+                goto failed;
+        }
+
+        // the error of the last task reported
+        if (pool_wait(pool) != ERR_NO_DATA)
+            goto failed;
+
+        for (size_t i = 0; i < 2 * 16; i++) {
+            if (slot[i] != 1)
+                goto failed;
+        }
+
+        // error cleared, the pool reusable
+        if (pool_wait(pool) != ERR_NONE)
+            goto failed;
+
+        pool_free(pool);
+        pool = NULL;
+    }
+
+    print_test_result(1, verbosity);
+
+    // all tests done
+    print_module_result(1, verbosity);
+
+    return 0;
+
+failed:
+    if (pool != NULL) {
+        pool_wait(pool);
+        pool_free(pool);
+    }
+
+    print_test_result(0, verbosity);
+    print_module_result(0, verbosity);
+
+    return 1;
+}
@@ -1,6 +1,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <types.h>
+#include "arena.h"
 #include "auxiliary.h"
 #include "cert.h"
 #include "contents.h"
@@ -11,14 +12,14 @@
 #define SUBFILTER_MAX    30
 
 
-static sigil_err_t parse_subfilter(sigil_t *sgl)
+static sigil_err_t parse_subfilter(sigil_t *sgl, signature_t *sig)
 {
     sigil_err_t err;
     int count = 0;
     char tmp[SUBFILTER_MAX],
             c;
 
-    if (sgl == NULL)
+    if (sgl == NULL || sig == NULL)
         return ERR_PARAMETER;
 
     sigil_zeroize(tmp, SUBFILTER_MAX * sizeof(*tmp));
@@ -46,29 +47,29 @@ static sigil_err_t parse_subfilter(sigil_t *sgl)
         return err;
 
     if (strncmp(tmp, "adbe.x509.rsa_sha1", 18) == 0) {
-        sgl->subfilter_type = SUBFILTER_adbe_x509_rsa_sha1;
+        sig->subfilter_type = SUBFILTER_adbe_x509_rsa_sha1;
     } else {
-        sgl->subfilter_type = SUBFILTER_UNKNOWN;
+        sig->subfilter_type = SUBFILTER_UNKNOWN;
     }
 
     return ERR_NONE;
 }
 
-static sigil_err_t parse_byte_range(sigil_t *sgl)
+static sigil_err_t parse_byte_range(sigil_t *sgl, signature_t *sig)
 {
     sigil_err_t err;
     range_t **byte_range;
     size_t start,
            length;
 
-    if (sgl == NULL)
+    if (sgl == NULL || sig == NULL)
         return ERR_PARAMETER;
 
     err = skip_word(sgl, "[");
     if (err != ERR_NONE)
         return err;
 
-    byte_range = &(sgl->byte_range);
+    byte_range = &(sig->byte_range);
 
     while (1) {
         if (skip_word(sgl, "]") == ERR_NONE)
@@ -86,10 +87,9 @@ static sigil_err_t parse_byte_range(sigil_t *sgl)
             return ERR_PDF_CONTENT;
 
         if (*byte_range == NULL) {
-            *byte_range = malloc(sizeof(**byte_range));
+            *byte_range = arena_alloc(&(sgl->arena), sizeof(**byte_range), 0);
             if (*byte_range == NULL)
                 return ERR_ALLOCATION;
-            sigil_zeroize(*byte_range, sizeof(**byte_range));
         }
 
         (*byte_range)->start = start;
@@ -99,20 +99,25 @@ static sigil_err_t parse_byte_range(sigil_t *sgl)
     }
 }
 
-sigil_err_t process_sig_dict(sigil_t *sgl)
+sigil_err_t process_sig_dict(sigil_t *sgl, signature_t *sig)
 {
     sigil_err_t err;
     dict_key_t dict_key;
 
-    if (sgl == NULL)
+    if (sgl == NULL || sig == NULL)
         return ERR_PARAMETER;
 
-    if (sgl->offset_sig_dict <= 0 && sgl->ref_sig_dict.object_num > 0) {
-        err = pdf_goto_obj(sgl, &(sgl->ref_sig_dict));
+    if (sig->offset_sig_dict <= 0 && sig->ref_sig_dict.object_num > 0) {
+        err = pdf_goto_obj(sgl, &(sig->ref_sig_dict));
         if (err != ERR_NONE)
             return err;
     } else {
-        err = pdf_move_pos_abs(sgl, sgl->offset_sig_dict);
+        // the offset is in the data of the field - the file or its object stream
+        err = pdf_goto_obj(sgl, &(sig->ref_sig_field));
+        if (err != ERR_NONE)
+            return err;
+
+        err = pdf_move_pos_abs(sgl, sig->offset_sig_dict);
         if (err != ERR_NONE)
             return err;
     }
@@ -124,30 +129,28 @@ sigil_err_t process_sig_dict(sigil_t *sgl)
     while ((err = parse_dict_key(sgl, &dict_key)) == ERR_NONE) {
         switch (dict_key) {
             case DICT_KEY_SubFilter:
-                if ((err = parse_subfilter(sgl)) != ERR_NONE)
+                if ((err = parse_subfilter(sgl, sig)) != ERR_NONE)
                     return err;
                 break;
             case DICT_KEY_Cert:
-                err = parse_certs(sgl);
+                err = parse_certs(sgl, sig);
                 if (err != ERR_NONE)
                     return err;
                 break;
             case DICT_KEY_Contents:
-                err = parse_contents(sgl);
+                err = parse_contents(sgl, sig);
                 if (err != ERR_NONE)
                     return err;
                 break;
             case DICT_KEY_ByteRange:
-                if ((err = parse_byte_range(sgl)) != ERR_NONE)
+                if ((err = parse_byte_range(sgl, sig)) != ERR_NONE)
                     return err;
                 break;
-            case DICT_KEY_UNKNOWN:
+            default: // also the known keys not used in this dictionary
                 err = skip_dict_unknown_value(sgl);
                 if (err != ERR_NONE)
                     return err;
                 break;
-            default:
-                return ERR_PDF_CONTENT;
         }
     }
 
@@ -1,10 +1,37 @@
 #include <types.h>
+#include "arena.h"
 #include "auxiliary.h"
+#include "config.h"
 #include "constants.h"
 #include "sig_field.h"
 
 
-sigil_err_t find_sig_field(sigil_t *sgl)
+static sigil_err_t add_signature(sigil_t *sgl, const reference_t *ref_sig_field)
+{
+    signature_t *tmp;
+    size_t capacity;
+
+    if (sgl->signature_count >= sgl->signature_capacity) {
+        capacity = MAX(sgl->signature_capacity * 2, SIGNATURE_PREALLOCATION);
+
+        // zeroed, so all the results start as unknown
+        tmp = arena_realloc(&(sgl->arena), sgl->signature,
+                            sizeof(*tmp) * sgl->signature_capacity,
+                            sizeof(*tmp) * capacity, 0);
+        if (tmp == NULL)
+            return ERR_ALLOCATION;
+
+        sgl->signature = tmp;
+        sgl->signature_capacity = capacity;
+    }
+
+    sgl->signature[sgl->signature_count].ref_sig_field = *ref_sig_field;
+    sgl->signature_count++;
+
+    return ERR_NONE;
+}
+
+sigil_err_t find_sig_fields(sigil_t *sgl)
 {
     sigil_err_t err;
     dict_key_t dict_key;
@@ -13,7 +40,7 @@ sigil_err_t find_sig_field(sigil_t *sgl)
     if (sgl == NULL)
         return ERR_PARAMETER;
 
-    err = ERR_NO_DATA;
+    sgl->signature_count = 0;
 
     for (size_t i = 0; i < sgl->fields.capacity; i++) {
         if (sgl->fields.entry[i] == NULL)
@@ -33,40 +60,41 @@ sigil_err_t find_sig_field(sigil_t *sgl)
             switch (dict_key) {
                 case DICT_KEY_FT:
                     if (skip_word(sgl, "/Sig") == ERR_NONE) {
-                        sgl->ref_sig_field = *(sgl->fields.entry[i]);
-                        return ERR_NONE;
-                    } else {
-                        other_ft = 1;
-                        break;
+                        err = add_signature(sgl, sgl->fields.entry[i]);
+                        if (err != ERR_NONE)
+                            return err;
                     }
-                case DICT_KEY_UNKNOWN:
+                    other_ft = 1;
+                    break;
+                default: // also the known keys not used in this dictionary
                     err = skip_dict_unknown_value(sgl);
                     if (err != ERR_NONE)
                         return err;
                     break;
-                default:
-                    return ERR_PDF_CONTENT;
             }
         }
+
+        if (!other_ft && err != ERR_END_OF_DICT)
+            return err;
     }
 
-    if (err != ERR_NONE)
-        return err;
+    if (sgl->signature_count <= 0)
+        return ERR_NO_DATA;
 
-    return ERR_NO_DATA;
+    return ERR_NONE;
 }
 
-sigil_err_t process_sig_field(sigil_t *sgl)
+sigil_err_t process_sig_field(sigil_t *sgl, signature_t *sig)
 {
     sigil_err_t err;
     size_t offset;
     dict_key_t dict_key;
     char c;
 
-    if (sgl == NULL)
+    if (sgl == NULL || sig == NULL)
         return ERR_PARAMETER;
 
-    err = pdf_goto_obj(sgl, &(sgl->ref_sig_field));
+    err = pdf_goto_obj(sgl, &(sig->ref_sig_field));
     if (err != ERR_NONE)
         return err;
 
@@ -89,7 +117,7 @@ sigil_err_t process_sig_field(sigil_t *sgl)
                     if ((err = get_curr_position(sgl, &offset)) != ERR_NONE)
                         return err;
 
-                    sgl->offset_sig_dict = offset;
+                    sig->offset_sig_dict = offset;
 
                     if ((err = skip_word(sgl, "<<")) != ERR_NONE)
                         return err;
@@ -98,25 +126,27 @@ sigil_err_t process_sig_field(sigil_t *sgl)
                     if (err != ERR_NONE)
                         return err;
                 } else {
-                    err = parse_indirect_reference(sgl, &(sgl->ref_sig_dict));
+                    err = parse_indirect_reference(sgl, &(sig->ref_sig_dict));
                     if (err != ERR_NONE)
                         return err;
                 }
                 break;
-            case DICT_KEY_UNKNOWN:
+            default: // also the known keys not used in this dictionary
                 err = skip_dict_unknown_value(sgl);
                 if (err != ERR_NONE)
                     return err;
                 break;
-            default:
-                return ERR_PDF_CONTENT;
         }
     }
 
-    if (err == ERR_END_OF_DICT)
-        return ERR_NONE;
+    if (err != ERR_END_OF_DICT)
+        return err;
+
+    // field not signed yet
+    if (sig->offset_sig_dict <= 0 && sig->ref_sig_dict.object_num <= 0)
+        return ERR_NO_DATA;
 
-    return err;;
+    return ERR_NONE;
 }
 
 int sigil_sig_field_self_test(int verbosity)
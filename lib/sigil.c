@@ -3,6 +3,7 @@
 #include <string.h>
 #include <types.h>
 #include "acroform.h"
+#include "arena.h"
 #include "auxiliary.h"
 #include "catalog.h"
 #include "cert.h"
@@ -11,6 +12,9 @@
 #include "contents.h"
 #include "cryptography.h"
 #include "header.h"
+#include "mem.h"
+#include "objstm.h"
+#include "pool.h"
 #include "sig_dict.h"
 #include "sig_field.h"
 #include "sigil.h"
@@ -18,57 +22,167 @@
 #include "types.h"
 #include "xref.h"
 
+#ifndef _WIN32
+    #include <errno.h>
+    #include <fcntl.h>
+    #include <stdint.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+// default values of the state related to the processed document
+static void set_document_defaults(sigil_t *sgl)
+{
+    sgl->pdf_data.file                   = NULL;
+    sgl->pdf_data.buffer                 = NULL;
+    sgl->pdf_data.reader.ctx             = NULL;
+    sgl->pdf_data.reader.read_at         = NULL;
+    sgl->pdf_data.reader.get_size        = NULL;
+    sgl->pdf_data.reader.borrow          = NULL;
+    sgl->pdf_data.reader.close           = NULL;
+    sgl->pdf_data.fd                     = -1;
+    sgl->pdf_data.window_start           = 0;
+    sgl->pdf_data.window_size            = 0;
+    sgl->pdf_data.buf_pos                = 0;
+    sgl->pdf_data.size                   = 0;
+    sgl->pdf_data.deallocation_info      = 0;
+    sgl->pdf_x                           = 0;
+    sgl->pdf_y                           = 0;
+    sgl->sig_flags                       = 0;
+    sgl->xref_type                       = XREF_TYPE_UNSET;
+    sgl->xref_reconstructed              = 0;
+    sgl->ref_acroform.object_num         = 0;
+    sgl->ref_acroform.generation_num     = 0;
+    sgl->ref_catalog_dict.object_num     = 0;
+    sgl->ref_catalog_dict.generation_num = 0;
+    sgl->offset_acroform                 = 0;
+    sgl->offset_pdf_start                = 0;
+    sgl->offset_startxref                = 0;
+    sgl->offset_eof                      = NULL;
+    sgl->eof_count                       = 0;
+    sgl->fields.capacity                 = 0;
+    sgl->fields.entry                    = NULL;
+    sgl->signature                       = NULL;
+    sgl->signature_count                 = 0;
+    sgl->signature_capacity              = 0;
+    sgl->file_digest                     = NULL;
+}
+
+sigil_err_t sigil_set_allocator(const sigil_allocator_t *allocator)
+{
+    return mem_set_allocator(allocator);
+}
+
 sigil_err_t sigil_init(sigil_t **sgl)
 {
     // function parameter checks
     if (sgl == NULL)
         return ERR_PARAMETER;
 
-    *sgl = malloc(sizeof(sigil_t));
+    *sgl = mem_alloc(sizeof(sigil_t));
     if (*sgl == NULL)
         return ERR_ALLOCATION;
 
     sigil_zeroize(*sgl, sizeof(**sgl));
 
     // set default values
-    (*sgl)->pdf_data.file                   = NULL;
-    (*sgl)->pdf_data.buffer                 = NULL;
-    (*sgl)->pdf_data.buf_pos                = 0;
-    (*sgl)->pdf_data.size                   = 0;
-    (*sgl)->pdf_data.deallocation_info      = 0;
-    (*sgl)->pdf_x                           = 0;
-    (*sgl)->pdf_y                           = 0;
-    (*sgl)->sig_flags                       = 0;
-    (*sgl)->subfilter_type                  = SUBFILTER_UNKNOWN;
-    (*sgl)->xref_type                       = XREF_TYPE_UNSET;
-    (*sgl)->hash_fn                         = HASH_FN_UNKNOWN;
-    (*sgl)->ref_acroform.object_num         = 0;
-    (*sgl)->ref_acroform.generation_num     = 0;
-    (*sgl)->ref_catalog_dict.object_num     = 0;
-    (*sgl)->ref_catalog_dict.generation_num = 0;
-    (*sgl)->ref_sig_dict.object_num         = 0;
-    (*sgl)->ref_sig_dict.generation_num     = 0;
-    (*sgl)->ref_sig_field.object_num        = 0;
-    (*sgl)->ref_sig_field.generation_num    = 0;
-    (*sgl)->offset_acroform                 = 0;
-    (*sgl)->offset_pdf_start                = 0;
-    (*sgl)->offset_sig_dict                 = 0;
-    (*sgl)->offset_startxref                = 0;
-    (*sgl)->digest_algorithm                = NULL;
-    (*sgl)->digest_computed                 = NULL;
-    (*sgl)->digest_original                 = NULL;
-    (*sgl)->fields.capacity                 = 0;
-    (*sgl)->fields.entry                    = NULL;
-    (*sgl)->byte_range                      = NULL;
-    (*sgl)->certificates                    = NULL;
-    (*sgl)->contents                        = NULL;
+    set_document_defaults(*sgl);
+
+    // kept across the documents by sigil_reset
+    (*sgl)->pdf_data.window                 = NULL;
     (*sgl)->xref                            = NULL;
+    (*sgl)->objstm.entry                    = NULL;
+    (*sgl)->objstm.clock                    = 0;
+    (*sgl)->objstm.active                   = 0;
     (*sgl)->trusted_store                   = X509_STORE_new();
-    (*sgl)->result_cert_verification        = CERT_STATUS_UNKNOWN;
-    (*sgl)->result_digest_comparison        = HASH_CMP_RESULT_UNKNOWN;
+    (*sgl)->verify_threads                  = 1;
+
+    arena_init(&((*sgl)->arena));
+
+    return ERR_NONE;
+}
+
+#ifdef _WIN32
+static sigil_err_t file_read_at(void *ctx, size_t offset, char *result,
+                                size_t size, size_t *res_size)
+{
+    FILE *file = ctx;
+
+    if (file == NULL || result == NULL || res_size == NULL)
+        return ERR_PARAMETER;
+
+    if (fseek(file, (long)offset, SEEK_SET) != 0)
+        return ERR_IO;
+
+    *res_size = fread(result, sizeof(char), size, file);
+    if (*res_size < size && ferror(file))
+        return ERR_IO;
 
     return ERR_NONE;
 }
+#else
+// reads without any shared file position, so one descriptor can be used
+// by multiple contexts or threads at once
+static sigil_err_t fd_read_at(void *ctx, size_t offset, char *result,
+                              size_t size, size_t *res_size)
+{
+    int fd = (int)(intptr_t)ctx;
+    ssize_t processed;
+
+    if (fd < 0 || result == NULL || res_size == NULL)
+        return ERR_PARAMETER;
+
+    do {
+        processed = pread(fd, result, size, (off_t)offset);
+    } while (processed < 0 && errno == EINTR);
+
+    if (processed < 0)
+        return ERR_IO;
+
+    *res_size = (size_t)processed;
+
+    return ERR_NONE;
+}
+
+static sigil_err_t fd_get_size(void *ctx, size_t *size)
+{
+    struct stat file_stat;
+
+    if (size == NULL)
+        return ERR_PARAMETER;
+
+    if (fstat((int)(intptr_t)ctx, &file_stat) != 0 || file_stat.st_size < 0)
+        return ERR_IO;
+
+    *size = (size_t)file_stat.st_size;
+
+    return ERR_NONE;
+}
+
+/** @brief Maps the whole file read-only into memory and sets it as the buffer
+ *
+ * @param sgl context with the size of PDF data already set
+ * @param fd file descriptor
+ * @return ERR_NONE if success
+ */
+static sigil_err_t map_file(sigil_t *sgl, int fd)
+{
+    void *content;
+
+    if (sgl->pdf_data.size <= 0)
+        return ERR_NO_DATA;
+
+    content = mmap(NULL, sgl->pdf_data.size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (content == MAP_FAILED)
+        return ERR_IO;
+
+    sgl->pdf_data.buffer = content;
+    sgl->pdf_data.deallocation_info |= DEALLOCATE_MAPPING;
+
+    return ERR_NONE;
+}
+#endif
 
 sigil_err_t sigil_set_pdf_file(sigil_t *sgl, FILE *pdf_file)
 {
@@ -98,12 +212,17 @@ sigil_err_t sigil_set_pdf_file(sigil_t *sgl, FILE *pdf_file)
     if (fseek(sgl->pdf_data.file, 0, SEEK_SET) != 0)
         return ERR_IO;
 
-    if (sgl->pdf_data.size < THRESHOLD_FILE_BUFFERING) {
-        content = malloc(sizeof(char) * (sgl->pdf_data.size + 1));
-        if (content == NULL) {
-            // fallback to using the file
+    #ifndef _WIN32
+        // map the whole file read-only, no copy of the data is needed,
+        // otherwise fallback to buffering or using the file
+        if (map_file(sgl, fileno(sgl->pdf_data.file)) == ERR_NONE)
             return ERR_NONE;
-        }
+    #endif
+
+    if (sgl->pdf_data.size < THRESHOLD_FILE_BUFFERING) {
+        content = mem_alloc(sizeof(char) * (sgl->pdf_data.size + 1));
+        if (content == NULL)
+            goto use_file;
 
         total_processed = 0;
 
@@ -114,27 +233,68 @@ sigil_err_t sigil_set_pdf_file(sigil_t *sgl, FILE *pdf_file)
             if (processed <= 0 ||
                 total_processed * sizeof(char) > sgl->pdf_data.size)
             {
-                // fallback to using the file
-                free(content);
-                return ERR_NONE;
+                mem_free(content);
+                goto use_file;
             }
         }
 
         if (total_processed * sizeof(char) != sgl->pdf_data.size) {
-            // fallback to using the file
-            free(content);
-            return ERR_NONE;
+            mem_free(content);
+            goto use_file;
         }
 
         content[total_processed] = '\0';
 
         sgl->pdf_data.buffer = content;
         sgl->pdf_data.deallocation_info |= DEALLOCATE_BUFFER;
+
+        return ERR_NONE;
     }
 
+use_file:
+    // fallback to reading the data from the file when needed
+    #ifdef _WIN32
+        sgl->pdf_data.reader.ctx = sgl->pdf_data.file;
+        sgl->pdf_data.reader.read_at = file_read_at;
+    #else
+        sgl->pdf_data.reader.ctx = (void *)(intptr_t)fileno(sgl->pdf_data.file);
+        sgl->pdf_data.reader.read_at = fd_read_at;
+        sgl->pdf_data.reader.get_size = fd_get_size;
+        sgl->pdf_data.fd = fileno(sgl->pdf_data.file);
+    #endif
+
     return ERR_NONE;
 }
 
+sigil_err_t sigil_set_pdf_fd(sigil_t *sgl, int fd)
+{
+    if (sgl == NULL || fd < 0)
+        return ERR_PARAMETER;
+
+    #ifdef _WIN32
+        return ERR_NOT_IMPLEMENTED;
+    #else
+        sigil_reader_t reader;
+        sigil_err_t err;
+
+        sigil_zeroize(&reader, sizeof(reader));
+        reader.ctx = (void *)(intptr_t)fd;
+        reader.read_at = fd_read_at;
+        reader.get_size = fd_get_size;
+
+        err = sigil_set_pdf_reader(sgl, &reader);
+        if (err != ERR_NONE)
+            return err;
+
+        sgl->pdf_data.fd = fd;
+
+        // mapping is position-independent as well, use it if possible
+        map_file(sgl, fd);
+
+        return ERR_NONE;
+    #endif
+}
+
 sigil_err_t sigil_set_pdf_path(sigil_t *sgl, const char *path_to_pdf)
 {
     FILE *pdf_file = NULL;
@@ -150,7 +310,7 @@ sigil_err_t sigil_set_pdf_path(sigil_t *sgl, const char *path_to_pdf)
         wchar_t *path_to_pdf_win;
 
         path_len = strlen(path_to_pdf) + 1;
-        path_to_pdf_win = malloc(path_len * sizeof(wchar_t));
+        path_to_pdf_win = mem_alloc(path_len * sizeof(wchar_t));
         if (path_to_pdf_win == NULL)
             return ERR_ALLOCATION;
         sigil_zeroize(path_to_pdf_win, path_len * sizeof(wchar_t));
@@ -161,16 +321,16 @@ sigil_err_t sigil_set_pdf_path(sigil_t *sgl, const char *path_to_pdf)
                        path_len - 1     // in  ... max wide chars to store
            ) != 0)
         {
-            free(path_to_pdf_win);
+            mem_free(path_to_pdf_win);
             return ERR_IO;
         }// MultiByteToWideChar may be used instead?
 
         if (_wfopen_s(&pdf_file, path_to_pdf_win, L"rb") != 0) {
-            free(path_to_pdf_win);
+            mem_free(path_to_pdf_win);
             return ERR_IO;
         }
 
-        free(path_to_pdf_win);
+        mem_free(path_to_pdf_win);
     #else
         if ((pdf_file = fopen(path_to_pdf, "rb")) == NULL)
             return ERR_IO;
@@ -181,6 +341,36 @@ sigil_err_t sigil_set_pdf_path(sigil_t *sgl, const char *path_to_pdf)
     return sigil_set_pdf_file(sgl, pdf_file);
 }
 
+sigil_err_t sigil_set_pdf_reader(sigil_t *sgl, const sigil_reader_t *reader)
+{
+    sigil_err_t err;
+    const char *content;
+    size_t size;
+
+    if (sgl == NULL || reader == NULL || reader->read_at == NULL ||
+        reader->get_size == NULL)
+    {
+        return ERR_PARAMETER;
+    }
+
+    err = reader->get_size(reader->ctx, &size);
+    if (err != ERR_NONE)
+        return err;
+
+    sgl->pdf_data.reader = *reader;
+    sgl->pdf_data.fd = -1;
+    sgl->pdf_data.size = size;
+
+    // use the data directly if the whole document is available in memory
+    if (reader->borrow != NULL && size > 0) {
+        content = reader->borrow(reader->ctx, 0, size);
+        if (content != NULL)
+            sgl->pdf_data.buffer = content;
+    }
+
+    return ERR_NONE;
+}
+
 sigil_err_t sigil_set_pdf_buffer(sigil_t *sgl, char *pdf_content, size_t size)
 {
     if (sgl == NULL || pdf_content == NULL || size <= 0)
@@ -234,144 +424,339 @@ sigil_err_t sigil_set_trusted_dir(sigil_t *sgl, const char *path_to_dir)
     return ERR_NONE;
 }
 
-static sigil_err_t sigil_verify_adbe_x509_rsa_sha1(sigil_t *sgl)
+sigil_err_t sigil_set_verify_threads(sigil_t *sgl, size_t threads)
 {
+    if (sgl == NULL || threads < 1)
+        return ERR_PARAMETER;
+
+    sgl->verify_threads = MIN(threads, VERIFY_THREADS_MAX);
+
+    return ERR_NONE;
+}
+
+typedef struct {
+    sigil_t     *sgl;
+    signature_t *sig;
+} verify_task_t;
+
+// everything of the signature not depending on the signed data
+static sigil_err_t prepare_signature(pool_t *pool, void *arg)
+{
+    verify_task_t *task = arg;
     sigil_err_t err;
 
-    err = load_certificates(sgl);
-    if (err != ERR_NONE)
-        return err;
+    (void)pool;
+
+    err = load_certificates(task->sig);
+
+    if (err == ERR_NONE)
+        err = verify_signing_certificate(task->sgl, task->sig);
 
-    err = verify_signing_certificate(sgl);
+    if (err == ERR_NONE)
+        err = load_digest(task->sig);
+
+    // only this signature fails, the others are verified anyway
+    task->sig->err = err;
+
+    return ERR_NONE;
+}
+
+static sigil_err_t sigil_verify_adbe_x509_rsa_sha1(sigil_t *sgl, pool_t *pool,
+                                                   signature_t **sig, size_t count)
+{
+    sigil_err_t err,
+                err_wait;
+    verify_task_t *task;
+
+    task = mem_alloc(sizeof(*task) * MAX(count, 1));
+    if (task == NULL)
+        return ERR_ALLOCATION;
+
+    err = ERR_NONE;
+    for (size_t i = 0; i < count && err == ERR_NONE; i++) {
+        task[i].sgl = sgl;
+        task[i].sig = sig[i];
+        err = pool_submit(pool, prepare_signature, &(task[i]));
+    }
+
+    // the tasks submitted so far use the array
+    err_wait = pool_wait(pool);
+    mem_free(task);
+    if (err == ERR_NONE)
+        err = err_wait;
     if (err != ERR_NONE)
         return err;
 
-    err = load_digest(sgl);
+    // all at once with the whole file, each byte read only once
+    err = compute_digest_pkcs1(sgl, pool, sig, count, &(sgl->file_digest));
     if (err != ERR_NONE)
         return err;
 
-    err = compute_digest_pkcs1(sgl);
+    for (size_t i = 0; i < count; i++) {
+        if (sig[i]->err == ERR_NONE)
+            sig[i]->err = compare_digest(sig[i]);
+    }
+
+    return ERR_NONE;
+}
+
+// releases what the signatures hold outside of the arena
+static void release_signatures(sigil_t *sgl)
+{
+    signature_t *sig;
+
+    for (size_t i = 0; i < sgl->signature_count; i++) {
+        sig = &(sgl->signature[i]);
+
+        if (sig->certificates != NULL)
+            cert_free(sig->certificates);
+
+        if (sig->digest_computed != NULL)
+            ASN1_OCTET_STRING_free(sig->digest_computed);
+
+        if (sig->digest_algorithm != NULL)
+            X509_ALGOR_free(sig->digest_algorithm);
+
+        if (sig->digest_original != NULL)
+            ASN1_OCTET_STRING_free(sig->digest_original);
+
+        sigil_zeroize(sig, sizeof(*sig));
+    }
+
+    sgl->signature_count = 0;
+}
+
+/** @brief Loads the cross-reference sections needed to find the catalog,
+ *         starting from the one referred to by startxref
+ *
+ */
+static sigil_err_t load_xref(sigil_t *sgl)
+{
+    sigil_err_t err;
+
+    // determine offset to the first cross-reference section
+    err = read_startxref(sgl);
     if (err != ERR_NONE)
         return err;
 
-    return compare_digest(sgl);
+    if (sgl->xref != NULL) {
+        xref_reset(sgl->xref);
+    } else if ((sgl->xref = xref_init()) == NULL) {
+        return ERR_ALLOCATION;
+    }
+
+    sgl->xref->prev_section = sgl->offset_startxref;
+
+    // the newest section, older ones only till a trailer refers to the catalog,
+    // the rest of them is loaded on lookup misses
+    do {
+        err = xref_load_sections(sgl, 1);
+        if (err != ERR_NONE)
+            return err;
+    } while (sgl->ref_catalog_dict.object_num <= 0 && sgl->xref->prev_section > 0);
+
+    return ERR_NONE;
 }
 
 sigil_err_t sigil_verify(sigil_t *sgl)
 {
     sigil_err_t err;
+    signature_t **pkcs1;
+    pool_t *pool;
+    size_t count;
+    int not_implemented;
 
     // function parameter checks
     if (sgl == NULL)
         return ERR_PARAMETER;
 
+    // decoded object streams belong to the previous cross-reference table
+    objstm_free(sgl);
+
     // process header - %PDF-<pdf_x>.<pdf_y>
     err = process_header(sgl);
     if (err != ERR_NONE)
         return err;
 
-    // determine offset to the first cross-reference section
-    err = read_startxref(sgl);
+    sgl->xref_reconstructed = 0;
+
+    // damaged cross-reference sections are replaced by scanning the file
+    err = load_xref(sgl);
+    if (err != ERR_NONE && err != ERR_ALLOCATION)
+        err = xref_reconstruct(sgl);
     if (err != ERR_NONE)
         return err;
 
-    if (sgl->xref != NULL)
-        xref_free(sgl->xref);
-    sgl->xref = xref_init();
-    if (sgl->xref == NULL)
-        return ERR_ALLOCATION;
+    err = process_catalog(sgl);
+    if (err != ERR_NONE)
+        return err;
 
-    sgl->xref->prev_section = sgl->offset_startxref;
+    err = process_acroform(sgl);
+    if (err != ERR_NONE)
+        return err;
 
-    size_t max_file_updates = MAX_FILE_UPDATES;
+    if ((sgl->sig_flags & 0x01) == 0)
+        return ERR_NO_SIGNATURE;
 
-    while (sgl->xref->prev_section > 0 && (max_file_updates--) > 0) {
-        // go to the position of the beginning of next cross-reference section
-        err = pdf_move_pos_abs(sgl, sgl->xref->prev_section);
-        if (err != ERR_NONE)
-            return err;
+    release_signatures(sgl);
 
-        sgl->xref->prev_section = 0;
+    if (sgl->file_digest != NULL) {
+        ASN1_OCTET_STRING_free(sgl->file_digest);
+        sgl->file_digest = NULL;
+    }
 
-        err = process_xref(sgl);
+    err = find_sig_fields(sgl);
+    if (err != ERR_NONE)
+        return err;
+
+    // the fields not signed yet are left out
+    count = 0;
+    for (size_t i = 0; i < sgl->signature_count; i++) {
+        err = process_sig_field(sgl, &(sgl->signature[i]));
+        if (err == ERR_NO_DATA)
+            continue;
         if (err != ERR_NONE)
             return err;
 
-        err = process_trailer(sgl);
+        sgl->signature[count++] = sgl->signature[i];
+    }
+
+    sgl->signature_count = count;
+    if (sgl->signature_count <= 0)
+        return ERR_NO_SIGNATURE;
+
+    // all the dictionaries parsed against the shared cross-reference table
+    for (size_t i = 0; i < sgl->signature_count; i++) {
+        err = process_sig_dict(sgl, &(sgl->signature[i]));
         if (err != ERR_NONE)
             return err;
     }
 
-    err = process_catalog(sgl);
-    if (err != ERR_NONE)
-        return err;
+    // the signed byte ranges are in the PDF data, not in any object stream
+    objstm_leave(sgl);
 
-    err = process_acroform(sgl);
-    if (err != ERR_NONE)
-        return err;
+    pkcs1 = mem_alloc(sizeof(*pkcs1) * sgl->signature_count);
+    if (pkcs1 == NULL)
+        return ERR_ALLOCATION;
 
-    if ((sgl->sig_flags & 0x01) == 0)
-        return ERR_NO_SIGNATURE;
+    count = 0;
+    not_implemented = 0;
+
+    for (size_t i = 0; i < sgl->signature_count; i++) {
+        switch (sgl->signature[i].subfilter_type) {
+            case SUBFILTER_adbe_x509_rsa_sha1:
+                pkcs1[count++] = &(sgl->signature[i]);
+                break;
+            default:
+                // the other signatures still get verified
+                not_implemented = 1;
+                break;
+        }
+    }
 
-    err = find_sig_field(sgl);
-    if (err != ERR_NONE)
-        return err;
+    pool = pool_create(pool_thread_count(sgl, count, sgl->verify_threads));
+    if (pool == NULL) {
+        mem_free(pkcs1);
+        return ERR_ALLOCATION;
+    }
 
-    err = process_sig_field(sgl);
+    err = sigil_verify_adbe_x509_rsa_sha1(sgl, pool, pkcs1, count);
+    pool_free(pool);
+    mem_free(pkcs1);
     if (err != ERR_NONE)
         return err;
 
-    err = process_sig_dict(sgl);
-    if (err != ERR_NONE)
-        return err;
+    if (not_implemented)
+        return ERR_NOT_IMPLEMENTED;
+
+    return ERR_NONE;
+}
+
+// the getters without an index describe the first signature of the document
+static const signature_t *first_signature(const sigil_t *sgl)
+{
+    static const signature_t unknown; // all the results unknown
+
+    if (sgl->signature_count <= 0)
+        return &unknown;
 
-    switch (sgl->subfilter_type) {
+    return &(sgl->signature[0]);
+}
+
+static sigil_err_t signature_result(const signature_t *sig, int *result)
+{
+    if (sig->err != ERR_NONE) {
+        *result = VERIFY_FAILED;
+        return ERR_NONE;
+    }
+
+    switch (sig->subfilter_type) {
         case SUBFILTER_adbe_x509_rsa_sha1:
-            err = sigil_verify_adbe_x509_rsa_sha1(sgl);
-            if (err != ERR_NONE)
-                return err;
+            if (sig->result_cert_verification == CERT_STATUS_VERIFIED &&
+                sig->result_digest_comparison == HASH_CMP_RESULT_MATCH)
+            {
+                *result = VERIFY_SUCCESS;
+            } else {
+                *result = VERIFY_FAILED;
+            }
 
             return ERR_NONE;
         default:
             return ERR_NOT_IMPLEMENTED;
     }
-
-    return ERR_NONE;
 }
 
 sigil_err_t sigil_get_result(sigil_t *sgl, int *result)
 {
     sigil_err_t err;
-    int cert_res;
-    int digest_res;
+    int sig_result;
 
     if (sgl == NULL || result == NULL)
         return ERR_PARAMETER;
 
     *result = 0;
 
-    switch (sgl->subfilter_type) {
-        case SUBFILTER_adbe_x509_rsa_sha1:
-            err = sigil_get_cert_validation_result(sgl, &cert_res);
-            if (err != ERR_NONE)
-                return err;
-
-            err = sigil_get_data_integrity_result(sgl, &digest_res);
-            if (err != ERR_NONE)
-                return err;
+    if (sgl->signature_count <= 0)
+        return ERR_NOT_IMPLEMENTED;
 
-            if (cert_res == CERT_STATUS_VERIFIED &&
-                digest_res == HASH_CMP_RESULT_MATCH)
-            {
-                *result = VERIFY_SUCCESS;
-            } else {
-                *result = VERIFY_FAILED;
-            }
+    // successful only if all the signatures are
+    for (size_t i = 0; i < sgl->signature_count; i++) {
+        err = signature_result(&(sgl->signature[i]), &sig_result);
+        if (err != ERR_NONE)
+            return err;
 
-            return ERR_NONE;
-        default:
-            return ERR_NOT_IMPLEMENTED;
+        if (sig_result != VERIFY_SUCCESS)
+            *result = VERIFY_FAILED;
     }
+
+    return ERR_NONE;
+}
+
+sigil_err_t sigil_get_signature_count(sigil_t *sgl, size_t *count)
+{
+    if (sgl == NULL || count == NULL)
+        return ERR_PARAMETER;
+
+    *count = sgl->signature_count;
+
+    return ERR_NONE;
+}
+
+sigil_err_t sigil_get_signature_result(sigil_t *sgl, size_t index, int *result)
+{
+    sigil_err_t err;
+
+    if (sgl == NULL || result == NULL || index >= sgl->signature_count)
+        return ERR_PARAMETER;
+
+    *result = 0;
+
+    err = signature_result(&(sgl->signature[index]), result);
+    if (err != ERR_NONE)
+        return err;
+
+    // failed, and why
+    return sgl->signature[index].err;
 }
 
 sigil_err_t sigil_get_cert_validation_result(sigil_t *sgl, int *result)
@@ -379,7 +764,7 @@ sigil_err_t sigil_get_cert_validation_result(sigil_t *sgl, int *result)
     if (sgl == NULL || result == NULL)
         return ERR_PARAMETER;
 
-    *result = sgl->result_cert_verification;
+    *result = first_signature(sgl)->result_cert_verification;
 
     return ERR_NONE;
 }
@@ -389,7 +774,7 @@ sigil_err_t sigil_get_data_integrity_result(sigil_t *sgl, int *result)
     if (sgl == NULL || result == NULL)
         return ERR_PARAMETER;
 
-    *result = sgl->result_digest_comparison;
+    *result = first_signature(sgl)->result_digest_comparison;
 
     return ERR_NONE;
 }
@@ -399,7 +784,7 @@ sigil_err_t sigil_get_subfilter(sigil_t *sgl, int *subfilter)
     if (sgl == NULL || subfilter == NULL)
         return ERR_PARAMETER;
 
-    *subfilter = sgl->subfilter_type;
+    *subfilter = first_signature(sgl)->subfilter_type;
 
     return ERR_NONE;
 }
@@ -409,7 +794,17 @@ sigil_err_t sigil_get_hash_fn(sigil_t *sgl, int *hash_fn)
     if (sgl == NULL || hash_fn == NULL)
         return ERR_PARAMETER;
 
-    *hash_fn = sgl->hash_fn;
+    *hash_fn = first_signature(sgl)->hash_fn;
+
+    return ERR_NONE;
+}
+
+sigil_err_t sigil_get_xref_reconstructed(sigil_t *sgl, int *result)
+{
+    if (sgl == NULL || result == NULL)
+        return ERR_PARAMETER;
+
+    *result = sgl->xref_reconstructed;
 
     return ERR_NONE;
 }
@@ -419,10 +814,10 @@ sigil_err_t sigil_get_original_digest(sigil_t *sgl, ASN1_OCTET_STRING **digest)
     if (sgl == NULL || digest == NULL)
         return ERR_PARAMETER;
 
-    if (sgl->digest_original == NULL)
+    if (first_signature(sgl)->digest_original == NULL)
         return ERR_NO_DATA;
 
-    *digest = ASN1_OCTET_STRING_dup(sgl->digest_original);
+    *digest = ASN1_OCTET_STRING_dup(first_signature(sgl)->digest_original);
 
     return ERR_NONE;
 }
@@ -432,10 +827,25 @@ sigil_err_t sigil_get_computed_digest(sigil_t *sgl, ASN1_OCTET_STRING **digest)
     if (sgl == NULL || digest == NULL)
         return ERR_PARAMETER;
 
-    if (sgl->digest_computed == NULL)
+    if (first_signature(sgl)->digest_computed == NULL)
+        return ERR_NO_DATA;
+
+    *digest = ASN1_OCTET_STRING_dup(first_signature(sgl)->digest_computed);
+
+    return ERR_NONE;
+}
+
+sigil_err_t sigil_get_file_digest(sigil_t *sgl, ASN1_OCTET_STRING **digest)
+{
+    if (sgl == NULL || digest == NULL)
+        return ERR_PARAMETER;
+
+    if (sgl->file_digest == NULL)
         return ERR_NO_DATA;
 
-    *digest = ASN1_OCTET_STRING_dup(sgl->digest_computed);
+    *digest = ASN1_OCTET_STRING_dup(sgl->file_digest);
+    if (*digest == NULL)
+        return ERR_ALLOCATION;
 
     return ERR_NONE;
 }
@@ -479,6 +889,17 @@ void sigil_print_computed_digest(sigil_t *sgl)
     sigil_print_digest(digest);
 }
 
+void sigil_print_file_digest(sigil_t *sgl)
+{
+    ASN1_OCTET_STRING *digest;
+
+    if (sigil_get_file_digest(sgl, &digest) != ERR_NONE)
+        return;
+
+    sigil_print_digest(digest);
+    ASN1_OCTET_STRING_free(digest);
+}
+
 void sigil_print_subfilter(sigil_t *sgl)
 {
     int subfilter;
@@ -532,83 +953,102 @@ void sigil_print_hash_fn(sigil_t *sgl)
 
 void sigil_print_cert_info(sigil_t *sgl)
 {
-    BIO *out = BIO_new_fp(stdout,BIO_NOCLOSE);
+    const cert_t *certificates;
+    BIO *out;
 
-    if (sgl == NULL || sgl->certificates == NULL || sgl->certificates->x509 == NULL)
+    if (sgl == NULL)
         return;
 
-    X509_print_ex(out, sgl->certificates->x509, XN_FLAG_COMPAT, X509_FLAG_COMPAT);
+    certificates = first_signature(sgl)->certificates;
+    if (certificates == NULL || certificates->x509 == NULL)
+        return;
+
+    out = BIO_new_fp(stdout,BIO_NOCLOSE);
+
+    X509_print_ex(out, certificates->x509, XN_FLAG_COMPAT, X509_FLAG_COMPAT);
 
     BIO_free_all(out);
 }
 
-static void range_free(range_t *range)
+// releases the source of PDF data, as set by sigil_set_pdf_*
+static void release_pdf_data(sigil_t *sgl)
 {
-    if (range == NULL)
-        return;
+    if (sgl->pdf_data.deallocation_info & DEALLOCATE_FILE) {
+        fclose(sgl->pdf_data.file);
+        sgl->pdf_data.deallocation_info ^= DEALLOCATE_FILE;
+    }
+    if (sgl->pdf_data.deallocation_info & DEALLOCATE_BUFFER) {
+        sigil_zeroize((void *)sgl->pdf_data.buffer, sgl->pdf_data.size);
+        mem_free((void *)sgl->pdf_data.buffer);
+        sgl->pdf_data.deallocation_info ^= DEALLOCATE_BUFFER;
+    }
+    #ifndef _WIN32
+        if (sgl->pdf_data.deallocation_info & DEALLOCATE_MAPPING) {
+            munmap((void *)sgl->pdf_data.buffer, sgl->pdf_data.size);
+            sgl->pdf_data.deallocation_info ^= DEALLOCATE_MAPPING;
+        }
+    #endif
 
-    range_free(range->next);
-    sigil_zeroize(range, sizeof(*range));
-    free(range);
+    if (sgl->pdf_data.reader.close != NULL)
+        sgl->pdf_data.reader.close(sgl->pdf_data.reader.ctx);
 }
 
-void sigil_free(sigil_t **sgl)
+// releases everything parsed from the document
+static void release_document(sigil_t *sgl)
 {
-    if (sgl == NULL || *sgl == NULL)
-        return;
+    if (sgl->offset_eof != NULL)
+        mem_free(sgl->offset_eof);
 
-    if ((*sgl)->pdf_data.deallocation_info & DEALLOCATE_FILE) {
-        fclose((*sgl)->pdf_data.file);
-        (*sgl)->pdf_data.deallocation_info ^= DEALLOCATE_FILE;
-    }
-    if ((*sgl)->pdf_data.deallocation_info & DEALLOCATE_BUFFER) {
-        sigil_zeroize((*sgl)->pdf_data.buffer, (*sgl)->pdf_data.size);
-        free((*sgl)->pdf_data.buffer);
-        (*sgl)->pdf_data.deallocation_info ^= DEALLOCATE_BUFFER;
-    }
+    if (sgl->file_digest != NULL)
+        ASN1_OCTET_STRING_free(sgl->file_digest);
 
-    if ((*sgl)->xref != NULL)
-        xref_free((*sgl)->xref);
+    release_signatures(sgl);
+}
 
-    if ((*sgl)->fields.capacity > 0) {
-        for (size_t i = 0; i < (*sgl)->fields.capacity; i++) {
-            if ((*sgl)->fields.entry[i] != NULL) {
-                sigil_zeroize((*sgl)->fields.entry[i],
-                              sizeof(*(*sgl)->fields.entry[i]));
-                free((*sgl)->fields.entry[i]);
-            }
-        }
+void sigil_reset(sigil_t *sgl)
+{
+    if (sgl == NULL)
+        return;
 
-        if ((*sgl)->fields.entry != NULL) {
-            sigil_zeroize((*sgl)->fields.entry,
-                          sizeof(*(*sgl)->fields.entry) * (*sgl)->fields.capacity);
-            free((*sgl)->fields.entry);
-        }
-    }
+    // PDF data need to be back in place before being released
+    objstm_free(sgl);
+    release_pdf_data(sgl);
+    release_document(sgl);
+
+    // the allocated capacities stay for the next document
+    xref_reset(sgl->xref);
+    arena_reset(&(sgl->arena));
 
-    if ((*sgl)->byte_range != NULL)
-        range_free((*sgl)->byte_range);
+    set_document_defaults(sgl);
+}
 
-    if ((*sgl)->certificates != NULL)
-        cert_free((*sgl)->certificates);
+void sigil_free(sigil_t **sgl)
+{
+    if (sgl == NULL || *sgl == NULL)
+        return;
 
-    if ((*sgl)->contents != NULL)
-        contents_free(*sgl);
+    // PDF data need to be back in place before being released
+    objstm_free(*sgl);
+    release_pdf_data(*sgl);
+    release_document(*sgl);
 
-    if ((*sgl)->digest_computed != NULL)
-        ASN1_OCTET_STRING_free((*sgl)->digest_computed);
+    if ((*sgl)->pdf_data.window != NULL) {
+        sigil_zeroize((*sgl)->pdf_data.window,
+                      sizeof(*(*sgl)->pdf_data.window) * READ_WINDOW_SIZE);
+        mem_free((*sgl)->pdf_data.window);
+    }
 
-    if ((*sgl)->digest_algorithm != NULL)
-        X509_ALGOR_free((*sgl)->digest_algorithm);
+    if ((*sgl)->xref != NULL)
+        xref_free((*sgl)->xref);
 
-    if ((*sgl)->digest_original != NULL)
-        ASN1_OCTET_STRING_free((*sgl)->digest_original);
+    // fields and the signatures with their parts all at once
+    arena_release(&((*sgl)->arena));
 
     if ((*sgl)->trusted_store != NULL)
         X509_STORE_free((*sgl)->trusted_store);
 
     sigil_zeroize(*sgl, sizeof(**sgl));
-    free(*sgl);
+    mem_free(*sgl);
     *sgl = NULL;
 }
 
@@ -679,6 +1119,390 @@ int sigil_sigil_self_test(int verbosity)
 
     print_test_result(1, verbosity);
 
+    // TEST: file mapped into memory
+    print_test_item("file mapping", verbosity);
+
+    {
+        sgl = test_prepare_sgl_path("test/subtype_adbe.x509.rsa_sha1.pdf");
+        if (sgl == NULL)
+            goto failed;
+
+        #ifndef _WIN32
+            if (!(sgl->pdf_data.deallocation_info & DEALLOCATE_MAPPING))
+                goto failed;
+        #endif
+
+        if (sgl->pdf_data.buffer == NULL ||
+            strncmp(sgl->pdf_data.buffer, "\x25PDF-1.4", 8) != 0)
+        {
+            goto failed;
+        }
+
+        sigil_free(&sgl);
+    }
+
+    print_test_result(1, verbosity);
+
+    // TEST: fn sigil_set_pdf_reader
+    print_test_item("fn sigil_set_pdf_reader", verbosity);
+
+    {
+        sigil_reader_t reader;
+        char output[6];
+        size_t output_size;
+        size_t number;
+        char c;
+
+        test_string_reader(&reader, "abcde 42 x");
+
+        if (sigil_init(&sgl) != ERR_NONE)
+            goto failed;
+
+        if (sigil_set_pdf_reader(sgl, &reader) != ERR_NONE ||
+            sgl->pdf_data.buffer != NULL || sgl->pdf_data.size != 10)
+        {
+            goto failed;
+        }
+
+        if (pdf_read(sgl, 5, output, &output_size) != ERR_NONE ||
+            output_size != 5 || strncmp(output, "abcde", 5) != 0)
+        {
+            goto failed;
+        }
+
+        if (parse_number(sgl, &number) != ERR_NONE || number != 42)
+            goto failed;
+
+        if (skip_leading_whitespaces(sgl) != ERR_NONE ||
+            pdf_peek_char(sgl, &c) != ERR_NONE || c != 'x' ||
+            pdf_get_char(sgl, &c) != ERR_NONE || c != 'x' ||
+            pdf_get_char(sgl, &c) != ERR_NO_DATA)
+        {
+            goto failed;
+        }
+
+        if (pdf_move_pos_abs(sgl, 1) != ERR_NONE ||
+            pdf_get_char(sgl, &c) != ERR_NONE || c != 'b')
+        {
+            goto failed;
+        }
+
+        sigil_free(&sgl);
+    }
+
+    print_test_result(1, verbosity);
+
+    // TEST: reading through the window across the block boundary
+    print_test_item("read window boundary", verbosity);
+
+    {
+        sigil_reader_t reader;
+        char *data;
+        char output[11];
+        size_t output_size;
+        char c;
+
+        data = mem_alloc(sizeof(*data) * (2 * READ_WINDOW_SIZE + 1));
+        if (data == NULL)
+            goto failed;
+
+        for (size_t i = 0; i < 2 * READ_WINDOW_SIZE; i++) {
+            data[i] = (char)('a' + i % 26);
+        }
+        data[2 * READ_WINDOW_SIZE] = '\0';
+
+        test_string_reader(&reader, data);
+
+        if (sigil_init(&sgl) != ERR_NONE ||
+            sigil_set_pdf_reader(sgl, &reader) != ERR_NONE)
+        {
+            mem_free(data);
+            goto failed;
+        }
+
+        if (pdf_move_pos_abs(sgl, READ_WINDOW_SIZE - 5) != ERR_NONE ||
+            pdf_read(sgl, 10, output, &output_size) != ERR_NONE ||
+            output_size != 10 ||
+            strncmp(output, data + READ_WINDOW_SIZE - 5, 10) != 0 ||
+            pdf_get_char(sgl, &c) != ERR_NONE ||
+            c != data[READ_WINDOW_SIZE + 5])
+        {
+            mem_free(data);
+            goto failed;
+        }
+
+        sigil_free(&sgl);
+        mem_free(data);
+    }
+
+    print_test_result(1, verbosity);
+
+    #ifndef _WIN32
+    // TEST: fn sigil_set_pdf_fd
+    print_test_item("fn sigil_set_pdf_fd", verbosity);
+
+    {
+        sigil_t *sgl_2 = NULL;
+        sigil_reader_t reader;
+        char output[9];
+        size_t output_size;
+        int fd;
+
+        fd = open("test/subtype_adbe.x509.rsa_sha1.pdf", O_RDONLY);
+        if (fd < 0)
+            goto failed;
+
+        // one descriptor shared by two contexts, each with its own position
+        if (sigil_init(&sgl) != ERR_NONE ||
+            sigil_set_pdf_fd(sgl, fd) != ERR_NONE ||
+            sgl->pdf_data.size != 58415)
+        {
+            close(fd);
+            goto failed;
+        }
+
+        sigil_zeroize(&reader, sizeof(reader));
+        reader.ctx = (void *)(intptr_t)fd;
+        reader.read_at = fd_read_at;
+        reader.get_size = fd_get_size;
+
+        if (sigil_init(&sgl_2) != ERR_NONE ||
+            sigil_set_pdf_reader(sgl_2, &reader) != ERR_NONE ||
+            sgl_2->pdf_data.buffer != NULL)
+        {
+            sigil_free(&sgl_2);
+            close(fd);
+            goto failed;
+        }
+
+        if (pdf_move_pos_abs(sgl_2, 58077) != ERR_NONE ||
+            pdf_read(sgl, 8, output, &output_size) != ERR_NONE ||
+            output_size != 8 || strncmp(output, "\x25PDF-1.4", 8) != 0 ||
+            pdf_read(sgl_2, 4, output, &output_size) != ERR_NONE ||
+            output_size != 4 || strncmp(output, "xref", 4) != 0)
+        {
+            sigil_free(&sgl_2);
+            close(fd);
+            goto failed;
+        }
+
+        sigil_free(&sgl_2);
+        sigil_free(&sgl);
+        close(fd);
+    }
+
+    print_test_result(1, verbosity);
+    #endif
+
+    // TEST: fn sigil_reset - the same context used for the next document
+    print_test_item("fn sigil_reset", verbosity);
+
+    {
+        X509_STORE *trusted_store;
+        xref_t *xref;
+        int result;
+
+        sgl = test_prepare_sgl_path("test/modified_pkcs1.pdf");
+        if (sgl == NULL)
+            goto failed;
+
+        if (sigil_verify(sgl) != ERR_NONE)
+            goto failed;
+
+        trusted_store = sgl->trusted_store;
+        xref = sgl->xref;
+
+        sigil_reset(sgl);
+
+        if (sgl->pdf_data.deallocation_info != 0 || sgl->pdf_data.size != 0 ||
+            sgl->signature != NULL || sgl->signature_count != 0 ||
+            sgl->offset_eof != NULL || sgl->xref_type != XREF_TYPE_UNSET)
+        {
+            goto failed;
+        }
+
+        if (sigil_set_pdf_path(sgl, "test/object_stream.pdf") != ERR_NONE ||
+            sigil_verify(sgl) != ERR_NONE)
+        {
+            goto failed;
+        }
+
+        err = sigil_get_data_integrity_result(sgl, &result);
+        if (err != ERR_NONE || result != HASH_CMP_RESULT_MATCH)
+            goto failed;
+
+        // buffers and the trusted store kept
+        if (sgl->trusted_store != trusted_store || sgl->xref != xref)
+            goto failed;
+
+        sigil_free(&sgl);
+    }
+
+    print_test_result(1, verbosity);
+
+    // TEST: fn sigil_set_allocator - all the allocations go through it
+    print_test_item("fn sigil_set_allocator", verbosity);
+
+    {
+        sigil_allocator_t allocator;
+        test_counter_t counter;
+        int result;
+
+        test_count_allocator(&allocator, &counter);
+
+        if (sigil_set_allocator(&allocator) != ERR_NONE)
+            goto failed;
+
+        sgl = test_prepare_sgl_path("test/subtype_adbe.x509.rsa_sha1.pdf");
+        if (sgl == NULL || sigil_verify(sgl) != ERR_NONE) {
+            sigil_free(&sgl);
+            sigil_set_allocator(NULL);
+            goto failed;
+        }
+
+        err = sigil_get_data_integrity_result(sgl, &result);
+        sigil_free(&sgl);
+        sigil_set_allocator(NULL);
+
+        if (err != ERR_NONE || result != HASH_CMP_RESULT_MATCH ||
+            counter.allocated == 0 || counter.allocated != counter.released)
+        {
+            goto failed;
+        }
+    }
+
+    print_test_result(1, verbosity);
+
+    // TEST: fn sigil_verify with several signature fields
+    print_test_item("VERIFY multiple signatures", verbosity);
+
+    {
+        char *data = NULL;
+        const char *sig_dict = NULL;
+        size_t sig_dict_len = 0,
+               offset[7], // objects 12, 19, 20, 21, 22, 23 and 24
+               count,
+               size,
+               pos,
+               xref_pos;
+        int result;
+
+        sgl = test_prepare_sgl_path("test/subtype_adbe.x509.rsa_sha1.pdf");
+        if (sgl == NULL)
+            goto failed;
+
+        size = sgl->pdf_data.size;
+        data = mem_alloc(sizeof(*data) * (3 * size + 1024));
+        if (data == NULL)
+            goto failed;
+        memcpy(data, sgl->pdf_data.buffer, size);
+        sigil_free(&sgl);
+
+        // signature dictionary to be copied with a different byte range
+        for (pos = 0; pos + 9 < size; pos++) {
+            if (sig_dict == NULL && strncmp(data + pos, "\n16 0 obj", 9) == 0)
+                sig_dict = data + pos + 9;
+            if (sig_dict != NULL && strncmp(data + pos, "endobj", 6) == 0) {
+                sig_dict_len = (size_t)(data + pos - sig_dict);
+                break;
+            }
+        }
+        if (sig_dict_len <= 0) {
+            mem_free(data);
+            goto failed;
+        }
+
+        // appended update - the original field, another one with the same
+        // signature, an unsigned one, and one with a modified byte range
+        pos = size;
+        offset[0] = pos;
+        pos += (size_t)sprintf(data + pos,
+            "12 0 obj\n<</Type /Catalog /Pages 4 0 R /AcroForm <</Fields "
+            "[14 0 R 19 0 R 20 0 R 21 0 R 23 0 R] /SigFlags 3>> >>\nendobj\n");
+        offset[1] = pos;
+        pos += (size_t)sprintf(data + pos,
+            "19 0 obj\n<</FT /Sig /T (Signature2) /V 16 0 R>>\nendobj\n");
+        offset[2] = pos;
+        pos += (size_t)sprintf(data + pos,
+            "20 0 obj\n<</FT /Sig /T (Signature3)>>\nendobj\n");
+        offset[3] = pos;
+        pos += (size_t)sprintf(data + pos,
+            "21 0 obj\n<</FT /Sig /T (Signature4) /V 22 0 R>>\nendobj\n");
+        offset[4] = pos;
+        pos += (size_t)sprintf(data + pos, "22 0 obj");
+        memcpy(data + pos, sig_dict, sig_dict_len);
+        for (size_t i = pos; i + 17 < pos + sig_dict_len; i++) {
+            if (strncmp(data + i, "/ByteRange [0 200", 17) == 0)
+                data[i + 16] = '1';
+        }
+        pos += sig_dict_len;
+        pos += (size_t)sprintf(data + pos, "endobj\n");
+        offset[5] = pos;
+        pos += (size_t)sprintf(data + pos,
+            "23 0 obj\n<</FT /Sig /T (Signature5) /V 24 0 R>>\nendobj\n");
+        offset[6] = pos;
+        pos += (size_t)sprintf(data + pos, "24 0 obj");
+        memcpy(data + pos, sig_dict, sig_dict_len);
+        for (size_t i = pos; i + 15 < pos + sig_dict_len; i++) {
+            if (strncmp(data + i, "/Contents <0482", 15) == 0)
+                data[i + 11] = '5'; // not an OCTET STRING any more
+        }
+        pos += sig_dict_len;
+        pos += (size_t)sprintf(data + pos, "endobj\n");
+
+        xref_pos = pos;
+        pos += (size_t)sprintf(data + pos, "xref\n0 1\n0000000000 65535 f \n"
+                                           "12 1\n%010zu 00000 n \n19 6\n",
+                               offset[0]);
+        for (int i = 1; i < 7; i++) {
+            pos += (size_t)sprintf(data + pos, "%010zu 00000 n \n", offset[i]);
+        }
+        pos += (size_t)sprintf(data + pos,
+            "trailer\n<</Size 25 /Root 12 0 R /Prev 58077>>\nstartxref\n%zu\n"
+            "\045\045EOF\n", xref_pos);
+
+        // the same results on one thread, and verified in parallel
+        for (size_t threads = 1; threads <= 4; threads += 3) {
+            if ((sgl = test_prepare_sgl_buffer(data, pos)) == NULL) {
+                mem_free(data);
+                goto failed;
+            }
+
+            if (sigil_set_verify_threads(sgl, threads) != ERR_NONE ||
+                sigil_verify(sgl) != ERR_NONE ||
+                sigil_get_signature_count(sgl, &count) != ERR_NONE || count != 4 ||
+                sgl->signature[0].result_digest_comparison != HASH_CMP_RESULT_MATCH ||
+                sgl->signature[1].result_digest_comparison != HASH_CMP_RESULT_MATCH ||
+                sgl->signature[2].result_digest_comparison != HASH_CMP_RESULT_DIFFER ||
+                sgl->signature[2].ref_sig_dict.object_num != 22 ||
+                sgl->signature[3].err != ERR_OPENSSL)
+            {
+                mem_free(data);
+                goto failed;
+            }
+
+            // modified byte range fails the whole document, the unreadable
+            // signature only reports why
+            if (sigil_get_signature_result(sgl, 2, &result) != ERR_NONE ||
+                result != VERIFY_FAILED ||
+                sigil_get_signature_result(sgl, 3, &result) != ERR_OPENSSL ||
+                result != VERIFY_FAILED ||
+                sigil_get_signature_result(sgl, 4, &result) != ERR_PARAMETER ||
+                sigil_get_result(sgl, &result) != ERR_NONE ||
+                result != VERIFY_FAILED)
+            {
+                mem_free(data);
+                goto failed;
+            }
+
+            sigil_free(&sgl);
+        }
+
+        mem_free(data);
+    }
+
+    print_test_result(1, verbosity);
+
     // TEST: fn sigil_verify with subfilter x509.rsa_sha1 (correct)
     print_test_item("VERIFY PKCS#1 (correct)", verbosity);
 
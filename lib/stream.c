@@ -0,0 +1,747 @@
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include <zlib.h>
+#include "auxiliary.h"
+#include "config.h"
+#include "constants.h"
+#include "mem.h"
+#include "sigil.h"
+#include "stream.h"
+#include "types.h"
+
+#if defined(__AVX2__)
+    #include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+    #include <emmintrin.h>
+#endif
+
+// zlib allocates through the allocator of the library as well
+static voidpf zlib_alloc(voidpf opaque, uInt items, uInt size)
+{
+    (void)opaque;
+    return mem_calloc(items, size);
+}
+
+static void zlib_free(voidpf opaque, voidpf address)
+{
+    (void)opaque;
+    mem_free(address);
+}
+
+void stream_init(stream_t *stream)
+{
+    if (stream == NULL)
+        return;
+
+    sigil_zeroize(stream, sizeof(*stream));
+
+    stream->position      = 0;
+    stream->remaining     = 0;
+    stream->filter        = STREAM_FILTER_NONE;
+    stream->predictor     = 1;
+    stream->columns       = 1;
+    stream->zstream_ready = 0;
+    stream->zstream_end   = 0;
+    stream->in            = NULL;
+    stream->out           = NULL;
+    stream->out_pos       = 0;
+    stream->out_size      = 0;
+    stream->row           = NULL;
+    stream->prev_row      = NULL;
+    stream->row_pos       = 0;
+}
+
+sigil_err_t stream_parse_filter(sigil_t *sgl, stream_t *stream)
+{
+    int array = 0;
+
+    if (sgl == NULL || stream == NULL)
+        return ERR_PARAMETER;
+
+    if (skip_word(sgl, "[") == ERR_NONE) {
+        array = 1;
+
+        if (skip_word(sgl, "]") == ERR_NONE)
+            return ERR_NONE;
+    }
+
+    if (skip_word(sgl, "/FlateDecode") != ERR_NONE)
+        return ERR_NOT_IMPLEMENTED;
+
+    stream->filter = STREAM_FILTER_FLATE;
+
+    // chain of more filters is not supported
+    if (array && skip_word(sgl, "]") != ERR_NONE)
+        return ERR_NOT_IMPLEMENTED;
+
+    return ERR_NONE;
+}
+
+sigil_err_t stream_parse_decode_parms(sigil_t *sgl, stream_t *stream)
+{
+    sigil_err_t err;
+    dict_key_t dict_key;
+    int array = 0;
+
+    if (sgl == NULL || stream == NULL)
+        return ERR_PARAMETER;
+
+    if (skip_word(sgl, "[") == ERR_NONE)
+        array = 1;
+
+    if (skip_word(sgl, "null") != ERR_NONE) {
+        err = skip_word(sgl, "<<");
+        if (err != ERR_NONE)
+            return err;
+
+        while ((err = parse_dict_key(sgl, &dict_key)) == ERR_NONE) {
+            switch (dict_key) {
+                case DICT_KEY_Predictor:
+                    err = parse_number(sgl, &(stream->predictor));
+                    break;
+                case DICT_KEY_Columns:
+                    err = parse_number(sgl, &(stream->columns));
+                    break;
+                default: // also the known keys not used in this dictionary
+                    err = skip_dict_unknown_value(sgl);
+                    break;
+            }
+
+            if (err != ERR_NONE)
+                return err;
+        }
+
+        if (err != ERR_END_OF_DICT)
+            return err;
+    }
+
+    if (array)
+        return skip_word(sgl, "]");
+
+    return ERR_NONE;
+}
+
+sigil_err_t stream_open(sigil_t *sgl, stream_t *stream, size_t length)
+{
+    sigil_err_t err;
+    size_t position;
+    char c;
+
+    if (sgl == NULL || stream == NULL)
+        return ERR_PARAMETER;
+
+    // TIFF predictor is not supported
+    if (stream->predictor != 1 && stream->predictor < 10)
+        return ERR_NOT_IMPLEMENTED;
+
+    if (stream->columns <= 0 || stream->columns > STREAM_CHUNK_SIZE)
+        return ERR_PDF_CONTENT;
+
+    err = skip_word(sgl, "stream");
+    if (err != ERR_NONE)
+        return err;
+
+    // end of line - CRLF or LF (or CR alone written by some producers)
+    if ((err = pdf_peek_char(sgl, &c)) != ERR_NONE)
+        return err;
+    if (c == 0x0d) {
+        if ((err = pdf_move_pos_rel(sgl, 1)) != ERR_NONE)
+            return err;
+        if ((err = pdf_peek_char(sgl, &c)) != ERR_NONE)
+            return err;
+    }
+    if (c == 0x0a) {
+        if ((err = pdf_move_pos_rel(sgl, 1)) != ERR_NONE)
+            return err;
+    }
+
+    if ((err = get_curr_position(sgl, &position)) != ERR_NONE)
+        return err;
+
+    if (length > sgl->pdf_data.size - sgl->offset_pdf_start - position)
+        return ERR_PDF_CONTENT;
+
+    stream->position = position;
+    stream->remaining = length;
+
+    stream->out = mem_alloc(sizeof(*stream->out) * STREAM_CHUNK_SIZE);
+    if (stream->out == NULL)
+        return ERR_ALLOCATION;
+    sigil_zeroize(stream->out, sizeof(*stream->out) * STREAM_CHUNK_SIZE);
+
+    if (stream->predictor >= 10) {
+        stream->row = mem_alloc(sizeof(*stream->row) * (stream->columns + 1));
+        if (stream->row == NULL)
+            return ERR_ALLOCATION;
+        sigil_zeroize(stream->row, sizeof(*stream->row) * (stream->columns + 1));
+
+        // the row before the first one is all zeros
+        stream->prev_row = mem_alloc(sizeof(*stream->prev_row) * stream->columns);
+        if (stream->prev_row == NULL)
+            return ERR_ALLOCATION;
+        sigil_zeroize(stream->prev_row, sizeof(*stream->prev_row) * stream->columns);
+
+        stream->row_pos = stream->columns;
+    }
+
+    if (stream->filter == STREAM_FILTER_FLATE) {
+        stream->zstream.zalloc = zlib_alloc;
+        stream->zstream.zfree = zlib_free;
+        stream->zstream.opaque = Z_NULL;
+        if (inflateInit(&(stream->zstream)) != Z_OK)
+            return ERR_ALLOCATION;
+        stream->zstream_ready = 1;
+    }
+
+    return ERR_NONE;
+}
+
+/** @brief Provides up to *max_size* next encoded bytes - borrowed if available
+ *         in memory, otherwise read into the input buffer
+ *
+ */
+static sigil_err_t fill_input(sigil_t *sgl, stream_t *stream, size_t max_size,
+                              const char **data, size_t *size)
+{
+    sigil_err_t err;
+    size_t chunk,
+           read_size;
+
+    if (stream->remaining <= 0)
+        return ERR_NO_DATA;
+
+    chunk = MIN(stream->remaining, max_size);
+
+    if (pdf_borrow(sgl, stream->position, chunk, data) != ERR_NONE) {
+        chunk = MIN(chunk, STREAM_CHUNK_SIZE);
+
+        if (stream->in == NULL) {
+            stream->in = mem_alloc(sizeof(*stream->in) * (STREAM_CHUNK_SIZE + 1));
+            if (stream->in == NULL)
+                return ERR_ALLOCATION;
+            sigil_zeroize(stream->in, sizeof(*stream->in) * (STREAM_CHUNK_SIZE + 1));
+        }
+
+        err = pdf_move_pos_abs(sgl, stream->position);
+        if (err != ERR_NONE)
+            return err;
+
+        err = pdf_read(sgl, chunk, stream->in, &read_size);
+        if (err != ERR_NONE)
+            return err;
+        if (read_size != chunk)
+            return ERR_PDF_CONTENT;
+
+        *data = stream->in;
+    }
+
+    stream->position += chunk;
+    stream->remaining -= chunk;
+    *size = chunk;
+
+    return ERR_NONE;
+}
+
+/** @brief Refills the output buffer with the next chunk of filtered data
+ *
+ */
+static sigil_err_t fill_output(sigil_t *sgl, stream_t *stream)
+{
+    sigil_err_t err;
+    const char *data;
+    size_t size;
+    int ret;
+
+    stream->out_pos = 0;
+    stream->out_size = 0;
+
+    if (stream->filter == STREAM_FILTER_NONE) {
+        err = fill_input(sgl, stream, STREAM_CHUNK_SIZE, &data, &size);
+        if (err != ERR_NONE)
+            return err;
+
+        memcpy(stream->out, data, size);
+        stream->out_size = size;
+
+        return ERR_NONE;
+    }
+
+    if (stream->zstream_end)
+        return ERR_NO_DATA;
+
+    stream->zstream.next_out = (Bytef *)stream->out;
+    stream->zstream.avail_out = STREAM_CHUNK_SIZE;
+
+    while (stream->zstream.avail_out > 0) {
+        if (stream->zstream.avail_in <= 0) {
+            err = fill_input(sgl, stream, UINT_MAX, &data, &size);
+            if (err == ERR_NO_DATA) // truncated data, use what was inflated
+                break;
+            if (err != ERR_NONE)
+                return err;
+
+            stream->zstream.next_in = (Bytef *)data;
+            stream->zstream.avail_in = (uInt)size;
+        }
+
+        ret = inflate(&(stream->zstream), Z_NO_FLUSH);
+        if (ret == Z_STREAM_END) {
+            stream->zstream_end = 1;
+            break;
+        }
+        if (ret != Z_OK)
+            return ERR_PDF_CONTENT;
+    }
+
+    stream->out_size = STREAM_CHUNK_SIZE - stream->zstream.avail_out;
+    if (stream->out_size <= 0)
+        return ERR_NO_DATA;
+
+    return ERR_NONE;
+}
+
+/** @brief Reads the filtered data, before applying the predictor
+ *
+ */
+static sigil_err_t read_filtered(sigil_t *sgl, stream_t *stream, char *result,
+                                 size_t size, size_t *res_size)
+{
+    sigil_err_t err;
+    size_t chunk;
+
+    *res_size = 0;
+
+    while (*res_size < size) {
+        if (stream->out_pos >= stream->out_size) {
+            err = fill_output(sgl, stream);
+            if (err == ERR_NO_DATA)
+                break;
+            if (err != ERR_NONE)
+                return err;
+        }
+
+        chunk = MIN(size - *res_size, stream->out_size - stream->out_pos);
+        memcpy(result + *res_size, stream->out + stream->out_pos, chunk);
+        stream->out_pos += chunk;
+        *res_size += chunk;
+    }
+
+    if (*res_size <= 0 && size > 0)
+        return ERR_NO_DATA;
+
+    return ERR_NONE;
+}
+
+/** @brief Adds the *delta* to the *row* byte by byte (PNG Up predictor),
+ *         processing 16 or 32 bytes at once where SSE2 or AVX2 is available
+ *
+ */
+static void png_up(unsigned char *row, const unsigned char *delta, size_t size)
+{
+    size_t i = 0;
+
+    #if defined(__AVX2__)
+        for (; i + 32 <= size; i += 32) {
+            __m256i a = _mm256_loadu_si256((const __m256i *)(row + i));
+            __m256i b = _mm256_loadu_si256((const __m256i *)(delta + i));
+            _mm256_storeu_si256((__m256i *)(row + i), _mm256_add_epi8(a, b));
+        }
+    #endif
+    #if defined(__AVX2__) || defined(__SSE2__) || defined(_M_X64)
+        for (; i + 16 <= size; i += 16) {
+            __m128i a = _mm_loadu_si128((const __m128i *)(row + i));
+            __m128i b = _mm_loadu_si128((const __m128i *)(delta + i));
+            _mm_storeu_si128((__m128i *)(row + i), _mm_add_epi8(a, b));
+        }
+    #endif
+
+    for (; i < size; i++) {
+        row[i] = (unsigned char)(row[i] + delta[i]);
+    }
+}
+
+static unsigned char paeth(unsigned char left, unsigned char up,
+                           unsigned char up_left)
+{
+    int p  = left + up - up_left,
+        pa = abs(p - left),
+        pb = abs(p - up),
+        pc = abs(p - up_left);
+
+    if (pa <= pb && pa <= pc)
+        return left;
+    if (pb <= pc)
+        return up;
+    return up_left;
+}
+
+/** @brief Decodes the row (with the leading PNG filter type) in place of the
+ *         previous decoded row, one byte per pixel
+ *
+ */
+static sigil_err_t png_decode_row(stream_t *stream)
+{
+    const unsigned char *delta = stream->row + 1;
+    unsigned char *row = stream->prev_row,
+                  left = 0,
+                  up_left = 0,
+                  up;
+    size_t i;
+
+    switch (stream->row[0]) {
+        case 0: // None
+            memcpy(row, delta, stream->columns);
+            break;
+        case 1: // Sub
+            for (i = 0; i < stream->columns; i++) {
+                row[i] = left = (unsigned char)(delta[i] + left);
+            }
+            break;
+        case 2: // Up
+            png_up(row, delta, stream->columns);
+            break;
+        case 3: // Average
+            for (i = 0; i < stream->columns; i++) {
+                row[i] = left = (unsigned char)(delta[i] + (left + row[i]) / 2);
+            }
+            break;
+        case 4: // Paeth
+            for (i = 0; i < stream->columns; i++) {
+                up = row[i];
+                row[i] = left = (unsigned char)(delta[i] + paeth(left, up, up_left));
+                up_left = up;
+            }
+            break;
+        default:
+            return ERR_PDF_CONTENT;
+    }
+
+    return ERR_NONE;
+}
+
+sigil_err_t stream_read(sigil_t *sgl, stream_t *stream, char *result,
+                        size_t size, size_t *res_size)
+{
+    sigil_err_t err;
+    size_t read_size,
+           chunk;
+
+    if (sgl == NULL || stream == NULL || stream->out == NULL ||
+        result == NULL || res_size == NULL)
+    {
+        return ERR_PARAMETER;
+    }
+
+    if (stream->predictor < 10)
+        return read_filtered(sgl, stream, result, size, res_size);
+
+    *res_size = 0;
+
+    while (*res_size < size) {
+        if (stream->row_pos >= stream->columns) {
+            err = read_filtered(sgl, stream, (char *)stream->row,
+                                stream->columns + 1, &read_size);
+            if (err != ERR_NONE && err != ERR_NO_DATA)
+                return err;
+            if (err == ERR_NO_DATA || read_size < stream->columns + 1)
+                break;
+
+            err = png_decode_row(stream);
+            if (err != ERR_NONE)
+                return err;
+
+            stream->row_pos = 0;
+        }
+
+        chunk = MIN(size - *res_size, stream->columns - stream->row_pos);
+        memcpy(result + *res_size, stream->prev_row + stream->row_pos, chunk);
+        stream->row_pos += chunk;
+        *res_size += chunk;
+    }
+
+    if (*res_size <= 0 && size > 0)
+        return ERR_NO_DATA;
+
+    return ERR_NONE;
+}
+
+void stream_free(stream_t *stream)
+{
+    if (stream == NULL)
+        return;
+
+    if (stream->zstream_ready)
+        inflateEnd(&(stream->zstream));
+
+    if (stream->in != NULL) {
+        sigil_zeroize(stream->in, sizeof(*stream->in) * (STREAM_CHUNK_SIZE + 1));
+        mem_free(stream->in);
+    }
+
+    if (stream->out != NULL) {
+        sigil_zeroize(stream->out, sizeof(*stream->out) * STREAM_CHUNK_SIZE);
+        mem_free(stream->out);
+    }
+
+    if (stream->row != NULL)
+        mem_free(stream->row);
+
+    if (stream->prev_row != NULL)
+        mem_free(stream->prev_row);
+
+    sigil_zeroize(stream, sizeof(*stream));
+}
+
+// encodes the row for the tests, inverse of the png_decode_row
+static void test_png_encode_row(unsigned char type, const unsigned char *row,
+                                const unsigned char *prev, unsigned char *result,
+                                size_t columns)
+{
+    unsigned char left,
+                  up,
+                  up_left;
+
+    result[0] = type;
+
+    for (size_t i = 0; i < columns; i++) {
+        left = i > 0 ? row[i - 1] : 0;
+        up = prev[i];
+        up_left = i > 0 ? prev[i - 1] : 0;
+
+        switch (type) {
+            case 1:
+                result[i + 1] = (unsigned char)(row[i] - left);
+                break;
+            case 2:
+                result[i + 1] = (unsigned char)(row[i] - up);
+                break;
+            case 3:
+                result[i + 1] = (unsigned char)(row[i] - (left + up) / 2);
+                break;
+            case 4:
+                result[i + 1] = (unsigned char)(row[i] - paeth(left, up, up_left));
+                break;
+            default:
+                result[i + 1] = row[i];
+                break;
+        }
+    }
+}
+
+int sigil_stream_self_test(int verbosity)
+{
+    sigil_t *sgl = NULL;
+    sigil_err_t err;
+    stream_t stream;
+    unsigned char *raw = NULL,
+                  *encoded = NULL;
+    char *pdf = NULL;
+
+    stream_init(&stream);
+
+    print_module_name("stream", verbosity);
+
+    // TEST: fn stream_read - no filter
+    print_test_item("fn stream_read", verbosity);
+
+    {
+        char output[8];
+        size_t output_size;
+
+        char *sstream = " stream\r\nabcdefgh\nendstream";
+        if ((sgl = test_prepare_sgl_buffer(sstream, strlen(sstream) + 1)) == NULL)
+            goto failed;
+
+        if (stream_open(sgl, &stream, 6) != ERR_NONE ||
+            stream_read(sgl, &stream, output, 4, &output_size) != ERR_NONE ||
+            output_size != 4 || memcmp(output, "abcd", 4) != 0 ||
+            stream_read(sgl, &stream, output, 4, &output_size) != ERR_NONE ||
+            output_size != 2 || memcmp(output, "ef", 2) != 0 ||
+            stream_read(sgl, &stream, output, 4, &output_size) != ERR_NO_DATA)
+        {
+            goto failed;
+        }
+
+        stream_free(&stream);
+        sigil_free(&sgl);
+    }
+
+    print_test_result(1, verbosity);
+
+    // TEST: fn stream_parse_filter, stream_parse_decode_parms
+    print_test_item("fn stream_parse_decode_parms", verbosity);
+
+    {
+        dict_key_t dict_key;
+
+        char *sstream = "<</Filter [/FlateDecode] /DecodeParms [<<"   \
+                        "/Columns 5/Predictor 12>>]/Length 1>>"       \
+                        "<</Filter/LZWDecode>>";
+        if ((sgl = test_prepare_sgl_buffer(sstream, strlen(sstream) + 1)) == NULL)
+            goto failed;
+
+        stream_init(&stream);
+
+        if (skip_word(sgl, "<<") != ERR_NONE ||
+            parse_dict_key(sgl, &dict_key) != ERR_NONE ||
+            dict_key != DICT_KEY_Filter ||
+            stream_parse_filter(sgl, &stream) != ERR_NONE ||
+            parse_dict_key(sgl, &dict_key) != ERR_NONE ||
+            dict_key != DICT_KEY_DecodeParms ||
+            stream_parse_decode_parms(sgl, &stream) != ERR_NONE ||
+            stream.filter != STREAM_FILTER_FLATE ||
+            stream.columns != 5 || stream.predictor != 12 ||
+            parse_dict_key(sgl, &dict_key) != ERR_NONE ||
+            dict_key != DICT_KEY_Length ||
+            skip_dict_unknown_value(sgl) != ERR_NONE ||
+            parse_dict_key(sgl, &dict_key) != ERR_END_OF_DICT)
+        {
+            goto failed;
+        }
+
+        if (skip_word(sgl, "<<") != ERR_NONE ||
+            parse_dict_key(sgl, &dict_key) != ERR_NONE ||
+            dict_key != DICT_KEY_Filter ||
+            stream_parse_filter(sgl, &stream) != ERR_NOT_IMPLEMENTED)
+        {
+            goto failed;
+        }
+
+        stream_free(&stream);
+        sigil_free(&sgl);
+    }
+
+    print_test_result(1, verbosity);
+
+    // TEST: Flate filter with PNG predictors, larger than one chunk
+    print_test_item("Flate and PNG predictors", verbosity);
+
+    {
+        // wide enough rows for the vectorized Up predictor
+        const size_t columns = 37,
+                     rows = 3 * STREAM_CHUNK_SIZE / columns;
+        char output[37];
+        size_t output_size,
+               raw_size = rows * (columns + 1),
+               header_size;
+        uLongf encoded_size;
+
+        raw = mem_alloc(raw_size);
+        encoded = mem_alloc(compressBound(raw_size));
+        if (raw == NULL || encoded == NULL)
+            goto failed;
+
+        // every row encoded with a different filter type
+        {
+            unsigned char prev[37] = { 0 },
+                          row[37];
+
+            for (size_t r = 0; r < rows; r++) {
+                for (size_t i = 0; i < columns; i++) {
+                    row[i] = (unsigned char)(r * 31 + i * 7 + (r >> 3));
+                }
+                test_png_encode_row((unsigned char)(r % 5), row, prev,
+                                    raw + r * (columns + 1), columns);
+                memcpy(prev, row, columns);
+            }
+        }
+
+        encoded_size = compressBound(raw_size);
+        if (compress(encoded, &encoded_size, raw, raw_size) != Z_OK)
+            goto failed;
+
+        header_size = strlen("stream\n");
+        pdf = mem_alloc(header_size + encoded_size + 1);
+        if (pdf == NULL)
+            goto failed;
+        memcpy(pdf, "stream\n", header_size);
+        memcpy(pdf + header_size, encoded, encoded_size);
+        pdf[header_size + encoded_size] = '\n';
+
+        if ((sgl = test_prepare_sgl_buffer(pdf, header_size + encoded_size + 1)) == NULL)
+            goto failed;
+
+        stream_init(&stream);
+        stream.filter = STREAM_FILTER_FLATE;
+        stream.predictor = 12;
+        stream.columns = columns;
+
+        if (stream_open(sgl, &stream, encoded_size) != ERR_NONE)
+            goto failed;
+
+        for (size_t r = 0; r < rows; r++) {
+            if (stream_read(sgl, &stream, output, columns, &output_size) != ERR_NONE ||
+                output_size != columns)
+            {
+                goto failed;
+            }
+
+            for (size_t i = 0; i < columns; i++) {
+                if ((unsigned char)output[i] !=
+                    (unsigned char)(r * 31 + i * 7 + (r >> 3)))
+                {
+                    goto failed;
+                }
+            }
+        }
+
+        if (stream_read(sgl, &stream, output, columns, &output_size) != ERR_NO_DATA)
+            goto failed;
+
+        stream_free(&stream);
+        sigil_free(&sgl);
+
+        // damaged data (here the checksum) fail the read, not just end it
+        pdf[header_size + encoded_size - 1] ^= 0x5a;
+
+        if ((sgl = test_prepare_sgl_buffer(pdf, header_size + encoded_size + 1)) == NULL)
+            goto failed;
+
+        stream_init(&stream);
+        stream.filter = STREAM_FILTER_FLATE;
+        stream.predictor = 12;
+        stream.columns = columns;
+
+        if (stream_open(sgl, &stream, encoded_size) != ERR_NONE)
+            goto failed;
+
+        do {
+            err = stream_read(sgl, &stream, output, columns, &output_size);
+        } while (err == ERR_NONE);
+
+        if (err != ERR_PDF_CONTENT)
+            goto failed;
+
+        stream_free(&stream);
+        sigil_free(&sgl);
+        mem_free(pdf);
+        mem_free(encoded);
+        mem_free(raw);
+        pdf = NULL;
+        encoded = NULL;
+        raw = NULL;
+    }
+
+    print_test_result(1, verbosity);
+
+    // all tests done
+    print_module_result(1, verbosity);
+    return 0;
+
+failed:
+    stream_free(&stream);
+    if (sgl)
+        sigil_free(&sgl);
+    if (pdf)
+        mem_free(pdf);
+    if (encoded)
+        mem_free(encoded);
+    if (raw)
+        mem_free(raw);
+
+    print_test_result(0, verbosity);
+    print_module_result(0, verbosity);
+
+    return 1;
+}
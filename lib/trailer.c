@@ -1,7 +1,66 @@
 #include <stdio.h>
+#include <string.h>
 #include "auxiliary.h"
 #include "constants.h"
+#include "sigil.h"
 #include "trailer.h"
+#include "xref.h"
+
+sigil_err_t process_trailer_entry(sigil_t *sgl, dict_key_t dict_key)
+{
+    sigil_err_t err;
+    size_t position;
+
+    if (sgl == NULL || sgl->xref == NULL)
+        return ERR_PARAMETER;
+
+    switch (dict_key) {
+        case DICT_KEY_Size:
+            if (sgl->xref->size_from_trailer > 0) {
+                err = skip_dict_unknown_value(sgl);
+            } else {
+                err = parse_number(sgl, &(sgl->xref->size_from_trailer));
+            }
+            if (err != ERR_NONE)
+                return err;
+            break;
+        case DICT_KEY_Prev:
+            err = parse_number(sgl, &(sgl->xref->prev_section));
+            if (err != ERR_NONE)
+                return err;
+            break;
+        case DICT_KEY_Root:
+            if (sgl->ref_catalog_dict.object_num > 0 ||
+                sgl->ref_catalog_dict.generation_num > 0)
+            {
+                err = skip_dict_unknown_value(sgl);
+            } else {
+                err = parse_indirect_reference(sgl, &(sgl->ref_catalog_dict));
+            }
+            if (err != ERR_NONE)
+                return err;
+            break;
+        case DICT_KEY_XRefStm:
+            err = parse_number(sgl, &position);
+            if (err != ERR_NONE)
+                return err;
+
+            // hybrid-reference file, the stream belongs only to the table
+            if (sgl->xref_type == XREF_TYPE_TABLE) {
+                err = process_xref_stm(sgl, position);
+                if (err != ERR_NONE)
+                    return err;
+            }
+            break;
+        default: // also the known keys not used in this dictionary
+            err = skip_dict_unknown_value(sgl);
+            if (err != ERR_NONE)
+                return err;
+            break;
+    }
+
+    return ERR_NONE;
+}
 
 sigil_err_t process_trailer(sigil_t *sgl)
 {
@@ -20,40 +79,9 @@ sigil_err_t process_trailer(sigil_t *sgl)
         return err;
 
     while ((err = parse_dict_key(sgl, &dict_key)) == ERR_NONE) {
-        switch (dict_key) {
-            case DICT_KEY_Size:
-                if (sgl->xref->size_from_trailer > 0) {
-                    err = skip_dict_unknown_value(sgl);
-                } else {
-                    err = parse_number(sgl, &(sgl->xref->size_from_trailer));
-                }
-                if (err != ERR_NONE)
-                    return err;
-                break;
-            case DICT_KEY_Prev:
-                err = parse_number(sgl, &(sgl->xref->prev_section));
-                if (err != ERR_NONE)
-                    return err;
-                break;
-            case DICT_KEY_Root:
-                if (sgl->ref_catalog_dict.object_num > 0 ||
-                    sgl->ref_catalog_dict.generation_num > 0)
-                {
-                    err = skip_dict_unknown_value(sgl);
-                } else {
-                    err = parse_indirect_reference(sgl, &(sgl->ref_catalog_dict));
-                }
-                if (err != ERR_NONE)
-                    return err;
-                break;
-            case DICT_KEY_UNKNOWN:
-                err = skip_dict_unknown_value(sgl);
-                if (err != ERR_NONE)
-                    return err;
-                break;
-            default:
-                return ERR_PDF_CONTENT;
-        }
+        err = process_trailer_entry(sgl, dict_key);
+        if (err != ERR_NONE)
+            return err;
     }
 
     if (err == ERR_END_OF_DICT)
@@ -64,20 +92,115 @@ sigil_err_t process_trailer(sigil_t *sgl)
 
 int sigil_trailer_self_test(int verbosity)
 {
+    sigil_t *sgl = NULL;
+
     print_module_name("trailer", verbosity);
 
-    // place for possible later tests
-    // ...
+    // TEST: hybrid-reference file - /XRefStm in the trailer
+    print_test_item("fn process_trailer /XRefStm", verbosity);
+
+    {
+        char pdf[1024];
+        size_t pos,
+               offset_catalog,
+               offset_objstm,
+               offset_xref_stm,
+               offset_xref,
+               offset,
+               generation;
+        reference_t ref;
+        uint8_t type;
+
+        pos = (size_t)sprintf(pdf, "%%PDF-1.5\n");
+        offset_catalog = pos;
+        pos += (size_t)sprintf(pdf + pos,
+            "1 0 obj\n<</Type /Catalog>>\nendobj\n");
+        offset_objstm = pos;
+        pos += (size_t)sprintf(pdf + pos,
+            "4 0 obj\n<</Type /ObjStm /N 1 /First 4 /Length 8>>\n"
+            "stream\n5 0 <<>>\nendstream\nendobj\n");
+
+        // object 1 at a wrong offset, the table takes precedence, /Prev of
+        // the stream is not followed
+        offset_xref_stm = pos;
+        pos += (size_t)sprintf(pdf + pos,
+            "6 0 obj\n<</Type /XRef /Size 7 /W [1 2 1] /Index [1 1 5 1]"
+            " /Prev 999 /Length 8>>\nstream\n");
+        memcpy(pdf + pos, "\x01\x00\x03\x00\x02\x00\x04\x00", 8);
+        pos += 8;
+        pos += (size_t)sprintf(pdf + pos, "\nendstream\nendobj\n");
+
+        // object 5 only in the object stream, free in the table
+        offset_xref = pos;
+        pos += (size_t)sprintf(pdf + pos,
+            "xref\n0 7\n"
+            "0000000000 65535 f \n"
+            "%010zu 00000 n \n"
+            "0000000000 65535 f \n"
+            "0000000000 65535 f \n"
+            "%010zu 00000 n \n"
+            "0000000000 65535 f \n"
+            "0000000000 65535 f \n"
+            "trailer\n<</Size 7 /XRefStm %zu /Root 1 0 R>>\n"
+            "startxref\n%zu\n%%%%EOF\n",
+            offset_catalog, offset_objstm, offset_xref_stm, offset_xref);
+
+        if ((sgl = test_prepare_sgl_buffer(pdf, pos)) == NULL)
+            goto failed;
+
+        if (read_startxref(sgl) != ERR_NONE ||
+            (sgl->xref = xref_init()) == NULL)
+        {
+            goto failed;
+        }
+
+        sgl->xref->prev_section = sgl->offset_startxref;
+
+        if (xref_load_sections(sgl, 1) != ERR_NONE ||
+            sgl->xref->section_count != 1 ||
+            sgl->xref->prev_section != 0 ||
+            sgl->ref_catalog_dict.object_num != 1)
+        {
+            goto failed;
+        }
+
+        ref.generation_num = 0;
+        ref.object_num = 1;
+        if (xref_get_entry(sgl, &ref, &type, &offset, &generation) != ERR_NONE ||
+            type != XREF_ENTRY_IN_USE || offset != offset_catalog)
+        {
+            goto failed;
+        }
+
+        ref.object_num = 5;
+        if (xref_get_entry(sgl, &ref, &type, &offset, &generation) != ERR_NONE ||
+            type != XREF_ENTRY_COMPRESSED || offset != 4 || generation != 0)
+        {
+            goto failed;
+        }
+
+        if (pdf_goto_obj(sgl, &ref) != ERR_NONE ||
+            skip_word(sgl, "<<>>") != ERR_NONE ||
+            sgl->xref_reconstructed)
+        {
+            goto failed;
+        }
+
+        sigil_free(&sgl);
+    }
+
+    print_test_result(1, verbosity);
 
     // all tests done
     print_module_result(1, verbosity);
     return 0;
 
-/*
 failed:
+    if (sgl)
+        sigil_free(&sgl);
+
     print_test_result(0, verbosity);
     print_module_result(0, verbosity);
 
     return 1;
-*/
-}
\ No newline at end of file
+}
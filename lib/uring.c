@@ -0,0 +1,286 @@
+#include <string.h>
+#include "auxiliary.h"
+#include "constants.h"
+#include "types.h"
+#include "uring.h"
+
+#ifdef HAVE_LINUX_IO_URING_H
+    #include <errno.h>
+    #include <fcntl.h>
+    #include <linux/io_uring.h>
+    #include <sys/mman.h>
+    #include <sys/syscall.h>
+    #include <unistd.h>
+#endif
+
+#if defined(HAVE_LINUX_IO_URING_H) && defined(__NR_io_uring_setup) && \
+    defined(__NR_io_uring_enter)
+
+static int sys_io_uring_setup(unsigned entries, struct io_uring_params *params)
+{
+    return (int)syscall(__NR_io_uring_setup, entries, params);
+}
+
+static int sys_io_uring_enter(int fd, unsigned to_submit, unsigned min_complete,
+                              unsigned flags)
+{
+    return (int)syscall(__NR_io_uring_enter, fd, to_submit, min_complete,
+                        flags, NULL, 0);
+}
+
+sigil_err_t uring_init(uring_t *ring, unsigned entries)
+{
+    struct io_uring_params params;
+
+    if (ring == NULL || entries == 0)
+        return ERR_PARAMETER;
+
+    sigil_zeroize(ring, sizeof(*ring));
+    sigil_zeroize(&params, sizeof(params));
+
+    ring->fd = sys_io_uring_setup(entries, &params);
+    if (ring->fd < 0) {
+        ring->fd = -1;
+        return ERR_NOT_IMPLEMENTED;
+    }
+
+    ring->sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    ring->cq_ring_size = params.cq_off.cqes +
+                         params.cq_entries * sizeof(struct io_uring_cqe);
+    ring->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        ring->sq_ring_size = MAX(ring->sq_ring_size, ring->cq_ring_size);
+        ring->cq_ring_size = ring->sq_ring_size;
+    }
+
+    ring->sq_ring = mmap(NULL, ring->sq_ring_size, PROT_READ | PROT_WRITE,
+                         MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQ_RING);
+    if (ring->sq_ring == MAP_FAILED) {
+        ring->sq_ring = NULL;
+        uring_free(ring);
+        return ERR_NOT_IMPLEMENTED;
+    }
+
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        ring->cq_ring = ring->sq_ring;
+    } else {
+        ring->cq_ring = mmap(NULL, ring->cq_ring_size, PROT_READ | PROT_WRITE,
+                             MAP_SHARED | MAP_POPULATE, ring->fd,
+                             IORING_OFF_CQ_RING);
+        if (ring->cq_ring == MAP_FAILED) {
+            ring->cq_ring = NULL;
+            uring_free(ring);
+            return ERR_NOT_IMPLEMENTED;
+        }
+    }
+
+    ring->sqes = mmap(NULL, ring->sqes_size, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQES);
+    if (ring->sqes == MAP_FAILED) {
+        ring->sqes = NULL;
+        uring_free(ring);
+        return ERR_NOT_IMPLEMENTED;
+    }
+
+    ring->sq_head  = (unsigned *)((char *)ring->sq_ring + params.sq_off.head);
+    ring->sq_tail  = (unsigned *)((char *)ring->sq_ring + params.sq_off.tail);
+    ring->sq_mask  = (unsigned *)((char *)ring->sq_ring + params.sq_off.ring_mask);
+    ring->sq_array = (unsigned *)((char *)ring->sq_ring + params.sq_off.array);
+    ring->cq_head  = (unsigned *)((char *)ring->cq_ring + params.cq_off.head);
+    ring->cq_tail  = (unsigned *)((char *)ring->cq_ring + params.cq_off.tail);
+    ring->cq_mask  = (unsigned *)((char *)ring->cq_ring + params.cq_off.ring_mask);
+    ring->cqes     = (char *)ring->cq_ring + params.cq_off.cqes;
+
+    return ERR_NONE;
+}
+
+sigil_err_t uring_queue_read(uring_t *ring, int fd, char *buffer, size_t size,
+                             size_t offset, uint64_t user_data)
+{
+    struct io_uring_sqe *sqe;
+    unsigned tail,
+             index;
+
+    if (ring == NULL || ring->fd < 0 || buffer == NULL)
+        return ERR_PARAMETER;
+
+    tail = *ring->sq_tail;
+    if (tail - __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE) > *ring->sq_mask)
+        return ERR_NO_DATA; // submission queue is full
+
+    index = tail & *ring->sq_mask;
+    sqe = (struct io_uring_sqe *)ring->sqes + index;
+
+    sigil_zeroize(sqe, sizeof(*sqe));
+    sqe->opcode    = IORING_OP_READ;
+    sqe->fd        = fd;
+    sqe->addr      = (uint64_t)(uintptr_t)buffer;
+    sqe->len       = (uint32_t)size;
+    sqe->off       = (uint64_t)offset;
+    sqe->user_data = user_data;
+
+    ring->sq_array[index] = index;
+    __atomic_store_n(ring->sq_tail, tail + 1, __ATOMIC_RELEASE);
+    ring->to_submit++;
+
+    return ERR_NONE;
+}
+
+sigil_err_t uring_wait(uring_t *ring, uint64_t *user_data, int *result)
+{
+    struct io_uring_cqe *cqe;
+    unsigned head;
+    int ret;
+
+    if (ring == NULL || ring->fd < 0 || user_data == NULL || result == NULL)
+        return ERR_PARAMETER;
+
+    while (1) {
+        head = *ring->cq_head;
+
+        if (head != __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE) &&
+            ring->to_submit == 0)
+        {
+            cqe = (struct io_uring_cqe *)ring->cqes + (head & *ring->cq_mask);
+            *user_data = cqe->user_data;
+            *result = cqe->res;
+            __atomic_store_n(ring->cq_head, head + 1, __ATOMIC_RELEASE);
+
+            return ERR_NONE;
+        }
+
+        ret = sys_io_uring_enter(ring->fd, ring->to_submit, 1,
+                                 IORING_ENTER_GETEVENTS);
+        if (ret < 0) {
+            if (errno == EINTR)
+                continue;
+            return ERR_IO;
+        }
+
+        ring->to_submit -= MIN((unsigned)ret, ring->to_submit);
+    }
+}
+
+void uring_free(uring_t *ring)
+{
+    if (ring == NULL)
+        return;
+
+    if (ring->sqes != NULL)
+        munmap(ring->sqes, ring->sqes_size);
+    if (ring->cq_ring != NULL && ring->cq_ring != ring->sq_ring)
+        munmap(ring->cq_ring, ring->cq_ring_size);
+    if (ring->sq_ring != NULL)
+        munmap(ring->sq_ring, ring->sq_ring_size);
+    if (ring->fd >= 0)
+        close(ring->fd);
+
+    sigil_zeroize(ring, sizeof(*ring));
+    ring->fd = -1;
+}
+
+#else
+
+sigil_err_t uring_init(uring_t *ring, unsigned entries)
+{
+    if (ring == NULL)
+        return ERR_PARAMETER;
+
+    sigil_zeroize(ring, sizeof(*ring));
+    ring->fd = -1;
+
+    return ERR_NOT_IMPLEMENTED;
+}
+
+sigil_err_t uring_queue_read(uring_t *ring, int fd, char *buffer, size_t size,
+                             size_t offset, uint64_t user_data)
+{
+    return ERR_NOT_IMPLEMENTED;
+}
+
+sigil_err_t uring_wait(uring_t *ring, uint64_t *user_data, int *result)
+{
+    return ERR_NOT_IMPLEMENTED;
+}
+
+void uring_free(uring_t *ring)
+{
+    if (ring == NULL)
+        return;
+
+    sigil_zeroize(ring, sizeof(*ring));
+    ring->fd = -1;
+}
+
+#endif /* HAVE_LINUX_IO_URING_H */
+
+int sigil_uring_self_test(int verbosity)
+{
+    uring_t ring;
+    sigil_err_t err;
+
+    print_module_name("uring", verbosity);
+
+    // TEST: fn uring_init, uring_free
+    print_test_item("fn uring_init", verbosity);
+
+    err = uring_init(&ring, 4);
+    if (err != ERR_NONE && err != ERR_NOT_IMPLEMENTED)
+        goto failed;
+
+    uring_free(&ring);
+
+    print_test_result(1, verbosity);
+
+    #ifdef HAVE_LINUX_IO_URING_H
+    // TEST: read through the io_uring (skipped if not available at runtime)
+    print_test_item("fn uring_queue_read", verbosity);
+
+    {
+        char output[5];
+        uint64_t user_data;
+        int result;
+        int fd;
+
+        if (uring_init(&ring, 4) == ERR_NONE) {
+            fd = open("test/subtype_adbe.x509.rsa_sha1.pdf", O_RDONLY);
+            if (fd < 0) {
+                uring_free(&ring);
+                goto failed;
+            }
+
+            if (uring_queue_read(&ring, fd, output, 4, 58077, 42) != ERR_NONE ||
+                uring_wait(&ring, &user_data, &result) != ERR_NONE ||
+                user_data != 42)
+            {
+                close(fd);
+                uring_free(&ring);
+                goto failed;
+            }
+
+            close(fd);
+            uring_free(&ring);
+
+            // an old kernel may not know the read operation
+            if (result != -EINVAL &&
+                (result != 4 || strncmp(output, "xref", 4) != 0))
+            {
+                goto failed;
+            }
+        }
+    }
+
+    print_test_result(1, verbosity);
+    #endif
+
+    // all tests done
+    print_module_result(1, verbosity);
+    return 0;
+
+failed:
+    print_test_result(0, verbosity);
+    print_module_result(0, verbosity);
+
+    return 1;
+}
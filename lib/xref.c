@@ -4,7 +4,12 @@
 #include "auxiliary.h"
 #include "config.h"
 #include "constants.h"
+#include "mem.h"
+#include "objstm.h"
+#include "pool.h"
 #include "sigil.h"
+#include "stream.h"
+#include "trailer.h"
 #include "xref.h"
 
 // Determine whether this file is using Cross-reference table or stream
@@ -30,126 +35,662 @@ static sigil_err_t determine_xref_type(sigil_t *sgl)
     return ERR_NONE;
 }
 
-static sigil_err_t
-add_xref_entry(xref_t *xref, size_t obj, size_t offset, size_t generation)
+/** @brief Size the flat table may grow to - within the /Size from trailer
+ *         (if known already) and proportional to the number of entries, so
+ *         that a few objects with high numbers don't make it huge
+ *
+ * @param xref cross-reference table
+ * @param pending number of entries about to be added
+ * @return the limit
+ */
+static size_t dense_limit(const xref_t *xref, size_t pending)
 {
-    int resize_factor = 1;
+    size_t limit = XREF_MAX_OBJECT_NUM + 1,
+           entries = xref->dense_count + pending;
 
-    if (xref == NULL)
-        return ERR_PARAMETER;
+    if (xref->size_from_trailer > 0)
+        limit = MIN(limit, xref->size_from_trailer);
+
+    if (entries < limit / 2)
+        limit = MIN(limit, 2 * entries + XREF_PREALLOCATION);
+
+    return limit;
+}
+
+/** @brief Makes the flat table large enough for objects up to *count* - 1.
+ *         Grows to the exact size requested, or twice the current capacity if
+ *         that is more and still within dense_limit, so the sections listing
+ *         objects one by one don't cause a reallocation each time
+ *
+ * @param xref cross-reference table
+ * @param count number of objects to hold, within dense_limit
+ * @return ERR_NONE if success
+ */
+static sigil_err_t xref_reserve(xref_t *xref, size_t count)
+{
+    size_t capacity;
+    void *tmp;
+
+    if (count <= xref->capacity)
+        return ERR_NONE;
+
+    capacity = MAX(count, MIN(xref->capacity * 2, dense_limit(xref, 0)));
+
+    tmp = mem_realloc(xref->byte_offset, sizeof(*xref->byte_offset) * capacity);
+    if (tmp == NULL)
+        return ERR_ALLOCATION;
+    xref->byte_offset = tmp;
+
+    tmp = mem_realloc(xref->generation_num, sizeof(*xref->generation_num) * capacity);
+    if (tmp == NULL)
+        return ERR_ALLOCATION;
+    xref->generation_num = tmp;
+
+    tmp = mem_realloc(xref->section, sizeof(*xref->section) * capacity);
+    if (tmp == NULL)
+        return ERR_ALLOCATION;
+    xref->section = tmp;
+
+    tmp = mem_realloc(xref->type, sizeof(*xref->type) * capacity);
+    if (tmp == NULL)
+        return ERR_ALLOCATION;
+    xref->type = tmp;
+
+    sigil_zeroize(xref->byte_offset + xref->capacity,
+                  sizeof(*xref->byte_offset) * (capacity - xref->capacity));
+    sigil_zeroize(xref->generation_num + xref->capacity,
+                  sizeof(*xref->generation_num) * (capacity - xref->capacity));
+    sigil_zeroize(xref->section + xref->capacity,
+                  sizeof(*xref->section) * (capacity - xref->capacity));
+    sigil_zeroize(xref->type + xref->capacity,
+                  sizeof(*xref->type) * (capacity - xref->capacity));
+    xref->capacity = capacity;
+
+    return ERR_NONE;
+}
+
+// index of the section being processed, the entries added belong to it
+static uint32_t current_section(const xref_t *xref)
+{
+    return xref->section_count > 0 ? (uint32_t)(xref->section_count - 1) : 0;
+}
+
+// generation of the object described by the entry, compressed objects keep
+// their index in the object stream in place of the generation
+static size_t entry_generation(uint8_t type, size_t generation)
+{
+    return type == XREF_ENTRY_COMPRESSED ? 0 : generation;
+}
 
-    // resize if needed
-    while (obj > resize_factor * xref->capacity - 1) {
-        resize_factor *= 2;
+/** @brief Adds the entry to the overflow map, used for the objects having
+ *         already an entry with different generation in the flat table, and
+ *         the ones beyond dense_limit
+ *
+ */
+static sigil_err_t add_xref_overflow(xref_t *xref, size_t obj, size_t offset,
+                                     size_t generation, uint8_t type,
+                                     uint32_t section)
+{
+    xref_overflow_t *overflow;
+
+    for (size_t i = 0; i < xref->overflow_count; i++) {
+        if (xref->overflow[i].object_num == obj &&
+            entry_generation(xref->overflow[i].type,
+                             xref->overflow[i].generation_num) ==
+            entry_generation(type, generation))
+        {
+            if (section >= xref->overflow[i].section)
+                return ERR_NONE;
+
+            overflow = &(xref->overflow[i]);
+            goto set;
+        }
     }
 
-    if (resize_factor != 1) {
-        xref->entry = realloc(xref->entry, sizeof(xref_entry_t *) * xref->capacity * resize_factor);
-        if (xref->entry == NULL)
+    if (xref->overflow_count >= xref->overflow_capacity) {
+        overflow = mem_realloc(xref->overflow, sizeof(*overflow) *
+                               MAX(xref->overflow_capacity * 2, XREF_PREALLOCATION));
+        if (overflow == NULL)
             return ERR_ALLOCATION;
-        sigil_zeroize(xref->entry + xref->capacity, sizeof(xref_entry_t *) * (xref->capacity * (resize_factor - 1)));
-        xref->capacity *= resize_factor;
+
+        xref->overflow = overflow;
+        xref->overflow_capacity = MAX(xref->overflow_capacity * 2,
+                                      XREF_PREALLOCATION);
     }
 
-    xref_entry_t **xref_entry = &(xref->entry[obj]);
+    overflow = &(xref->overflow[xref->overflow_count++]);
+    overflow->object_num = obj;
 
-    while (*xref_entry != NULL) {
-        if ((*xref_entry)->generation_num == generation)
-            return ERR_NONE;
+set:
+    overflow->byte_offset = offset;
+    overflow->generation_num = (uint32_t)generation;
+    overflow->section = section;
+    overflow->type = type;
+
+    return ERR_NONE;
+}
+
+// the entry from the newest section (the lowest index) is kept for each object
+// and generation, so the sections may be added in any order. For
+// XREF_ENTRY_COMPRESSED the *offset* is the object number of the object stream
+// and *generation* the index in it
+static sigil_err_t add_xref_entry_at(xref_t *xref, size_t obj, size_t offset,
+                                     size_t generation, uint8_t type,
+                                     uint32_t section)
+{
+    sigil_err_t err;
+
+    if (xref == NULL ||
+        (type != XREF_ENTRY_IN_USE && type != XREF_ENTRY_COMPRESSED))
+    {
+        return ERR_PARAMETER;
+    }
+
+    if (generation > UINT32_MAX || obj > XREF_MAX_OBJECT_NUM)
+        return ERR_PDF_CONTENT;
+
+    if (obj >= xref->capacity) {
+        // also the objects beyond /Size are kept, only not in the flat table
+        if (obj >= dense_limit(xref, 1))
+            return add_xref_overflow(xref, obj, offset, generation, type, section);
+
+        err = xref_reserve(xref, obj + 1);
+        if (err != ERR_NONE)
+            return err;
+    }
+
+    if (xref->type[obj] != XREF_ENTRY_NONE) {
+        if (entry_generation(xref->type[obj], xref->generation_num[obj]) !=
+            entry_generation(type, generation))
+        {
+            return add_xref_overflow(xref, obj, offset, generation, type, section);
+        }
 
-        xref_entry = &(*xref_entry)->next;
+        if (section >= xref->section[obj])
+            return ERR_NONE;
+    } else {
+        xref->dense_count++;
     }
 
-    *xref_entry = malloc(sizeof(xref_entry_t));
-    if (*xref_entry == NULL)
-        return ERR_ALLOCATION;
-    sigil_zeroize(*xref_entry, sizeof(xref_entry_t));
+    xref->byte_offset[obj] = offset;
+    xref->generation_num[obj] = (uint32_t)generation;
+    xref->section[obj] = section;
+    xref->type[obj] = type;
 
-    (*xref_entry)->byte_offset = offset;
-    (*xref_entry)->generation_num = generation;
+    return ERR_NONE;
+}
+
+// adds the entry as a part of the section being processed
+static sigil_err_t add_xref_entry(xref_t *xref, size_t obj, size_t offset,
+                                  size_t generation, uint8_t type)
+{
+    if (xref == NULL)
+        return ERR_PARAMETER;
+
+    return add_xref_entry_at(xref, obj, offset, generation, type,
+                             current_section(xref));
+}
+
+/** @brief Records the subsection of cross-reference table to be decoded
+ *         on lookup
+ *
+ */
+static sigil_err_t
+add_xref_subsection(xref_t *xref, size_t position, size_t first, size_t count)
+{
+    xref_subsection_t *subsection;
+
+    if (xref->subsection_count >= xref->subsection_capacity) {
+        subsection = mem_realloc(xref->subsection, sizeof(*subsection) *
+                                 MAX(xref->subsection_capacity * 2, XREF_PREALLOCATION));
+        if (subsection == NULL)
+            return ERR_ALLOCATION;
+
+        xref->subsection = subsection;
+        xref->subsection_capacity = MAX(xref->subsection_capacity * 2,
+                                        XREF_PREALLOCATION);
+    }
+
+    subsection = &(xref->subsection[xref->subsection_count++]);
+    subsection->position = position;
+    subsection->first_object = first;
+    subsection->count = count;
+    subsection->section = current_section(xref);
 
     return ERR_NONE;
 }
 
-static void free_xref_entry(xref_entry_t *entry)
+/** @brief Decodes the 20-byte entry of the cross-reference table in the format
+ *         "nnnnnnnnnn ggggg n" followed by 2-character end of line
+ *
+ * @param entry the entry
+ * @param offset output - byte offset (or next free object)
+ * @param generation output - generation number
+ * @param type output - 'n' for in-use entry, 'f' for free entry
+ * @return ERR_NONE if success, ERR_PDF_CONTENT if not in the format
+ */
+static sigil_err_t
+decode_xref_entry(const char *entry, size_t *offset, size_t *generation, char *type)
 {
-    if (entry != NULL) {
-        free_xref_entry(entry->next);
-        sigil_zeroize(entry, sizeof(*entry));
-        free(entry);
+    size_t i;
+
+    *offset = 0;
+    *generation = 0;
+
+    for (i = 0; i < 10; i++) {
+        if (!is_digit(entry[i]))
+            return ERR_PDF_CONTENT;
+        *offset = *offset * 10 + (size_t)(entry[i] - '0');
     }
+
+    for (i = 11; i < 16; i++) {
+        if (!is_digit(entry[i]))
+            return ERR_PDF_CONTENT;
+        *generation = *generation * 10 + (size_t)(entry[i] - '0');
+    }
+
+    if (entry[10] != ' ' || entry[16] != ' ' ||
+        (entry[17] != 'n' && entry[17] != 'f') ||
+        !is_whitespace(entry[18]) || !is_whitespace(entry[19]))
+    {
+        return ERR_PDF_CONTENT;
+    }
+
+    *type = entry[17];
+
+    return ERR_NONE;
+}
+
+/** @brief Reads and decodes the 20-byte entry at the *position*, without
+ *         moving the position in PDF
+ *
+ */
+static sigil_err_t read_xref_entry(sigil_t *sgl, size_t position, size_t *offset,
+                                   size_t *generation, char *type)
+{
+    sigil_err_t err;
+    const char *data;
+    char entry[21];
+    size_t read_size,
+           buf_pos;
+
+    if (pdf_borrow(sgl, position, 20, &data) == ERR_NONE)
+        return decode_xref_entry(data, offset, generation, type);
+
+    buf_pos = sgl->pdf_data.buf_pos;
+
+    err = pdf_move_pos_abs(sgl, position);
+    if (err == ERR_NONE)
+        err = pdf_read(sgl, 20, entry, &read_size);
+
+    sgl->pdf_data.buf_pos = buf_pos;
+
+    if (err != ERR_NONE)
+        return err;
+    if (read_size != 20)
+        return ERR_PDF_CONTENT;
+
+    return decode_xref_entry(entry, offset, generation, type);
 }
 
 xref_t *xref_init(void)
 {
-    xref_t *xref = malloc(sizeof(xref_t));
+    xref_t *xref = mem_alloc(sizeof(xref_t));
     if (xref == NULL)
         return NULL;
     sigil_zeroize(xref, sizeof(*xref));
 
-    xref->entry = malloc(sizeof(xref_entry_t *) * XREF_PREALLOCATION);
-    if (xref->entry == NULL) {
-        free(xref);
-        return NULL;
-    }
-    sigil_zeroize(xref->entry, sizeof(*(xref->entry)) * XREF_PREALLOCATION);
-    xref->capacity = XREF_PREALLOCATION;
+    xref->byte_offset = NULL;
+    xref->generation_num = NULL;
+    xref->section = NULL;
+    xref->type = NULL;
+    xref->capacity = 0;
+    xref->dense_count = 0;
+    xref->overflow = NULL;
+    xref->overflow_count = 0;
+    xref->overflow_capacity = 0;
+    xref->subsection = NULL;
+    xref->subsection_count = 0;
+    xref->subsection_capacity = 0;
+    xref->section_count = 0;
+    xref->sections_left = MAX_FILE_UPDATES;
+    xref->stream = NULL;
+    xref->stream_count = 0;
+    xref->stream_capacity = 0;
     xref->size_from_trailer = 0;
     xref->prev_section = 0;
 
+    if (xref_reserve(xref, XREF_PREALLOCATION) != ERR_NONE) {
+        xref_free(xref);
+        return NULL;
+    }
+
     return xref;
 }
 
+void xref_reset(xref_t *xref)
+{
+    if (xref == NULL)
+        return;
+
+    // the capacities are kept, entries are looked up by their type
+    if (xref->type != NULL)
+        memset(xref->type, XREF_ENTRY_NONE, sizeof(*xref->type) * xref->capacity);
+
+    for (size_t i = 0; i < xref->stream_count; i++) {
+        if (xref->stream[i].index != NULL)
+            mem_free(xref->stream[i].index);
+    }
+
+    xref->dense_count = 0;
+    xref->overflow_count = 0;
+    xref->subsection_count = 0;
+    xref->stream_count = 0;
+    xref->section_count = 0;
+    xref->sections_left = MAX_FILE_UPDATES;
+    xref->size_from_trailer = 0;
+    xref->prev_section = 0;
+}
+
 void xref_free(xref_t *xref)
 {
     if (xref == NULL)
         return;
 
-    if (xref->entry != NULL) {
-        for (size_t i = 0; i < xref->capacity; i++) {
-            free_xref_entry(xref->entry[i]);
+    if (xref->byte_offset != NULL)
+        mem_free(xref->byte_offset);
+    if (xref->generation_num != NULL)
+        mem_free(xref->generation_num);
+    if (xref->section != NULL)
+        mem_free(xref->section);
+    if (xref->type != NULL)
+        mem_free(xref->type);
+    if (xref->overflow != NULL)
+        mem_free(xref->overflow);
+    if (xref->subsection != NULL)
+        mem_free(xref->subsection);
+    if (xref->stream != NULL) {
+        for (size_t i = 0; i < xref->stream_count; i++) {
+            if (xref->stream[i].index != NULL)
+                mem_free(xref->stream[i].index);
         }
-        free(xref->entry);
+        mem_free(xref->stream);
     }
 
     sigil_zeroize(xref, sizeof(*xref));
-    free(xref);
+    mem_free(xref);
 }
 
-sigil_err_t read_startxref(sigil_t *sgl)
+/** @brief Looks up the entry in the cross-reference sections loaded so far
+ *
+ */
+static sigil_err_t find_xref_entry(sigil_t *sgl, const reference_t *ref,
+                                   uint8_t *type, size_t *field_1, size_t *field_2)
 {
     sigil_err_t err;
-    size_t offset;
-    size_t read_size;
-    char tmp[10];
+    xref_t *xref;
+    xref_subsection_t *subsection;
+    size_t found_section = SIZE_MAX,
+           found_offset = 0,
+           found_generation = 0,
+           offset,
+           generation;
+    uint8_t found_type = XREF_ENTRY_NONE;
+    char entry_type;
+
+    xref = sgl->xref;
+
+    // entries parsed in advance
+    if (ref->object_num < xref->capacity &&
+        xref->type[ref->object_num] != XREF_ENTRY_NONE &&
+        entry_generation(xref->type[ref->object_num],
+                         xref->generation_num[ref->object_num]) == ref->generation_num)
+    {
+        found_section = xref->section[ref->object_num];
+        found_offset = xref->byte_offset[ref->object_num];
+        found_generation = xref->generation_num[ref->object_num];
+        found_type = xref->type[ref->object_num];
+    } else {
+        for (size_t i = 0; i < xref->overflow_count; i++) {
+            if (xref->overflow[i].object_num == ref->object_num &&
+                entry_generation(xref->overflow[i].type,
+                                 xref->overflow[i].generation_num) == ref->generation_num)
+            {
+                found_section = xref->overflow[i].section;
+                found_offset = xref->overflow[i].byte_offset;
+                found_generation = xref->overflow[i].generation_num;
+                found_type = xref->overflow[i].type;
+                break;
+            }
+        }
+    }
 
-    if (sgl == NULL)
-        return ERR_PARAMETER;
+    // subsections from sections newer than the entry found, the newest first,
+    // also from the same section, as the table takes precedence over the
+    // stream of the hybrid-reference file
+    for (size_t i = 0; i < xref->subsection_count; i++) {
+        subsection = &(xref->subsection[i]);
 
-    for (offset = 9; offset < XREF_SEARCH_OFFSET; offset++) {
-        if ((err = pdf_move_pos_abs(sgl, sgl->pdf_data.size - offset)) != ERR_NONE)
-            return err;
-        
-        err = pdf_read(sgl, 9, tmp, &read_size);
+        if (subsection->section > found_section)
+            break;
+
+        if (ref->object_num < subsection->first_object ||
+            ref->object_num - subsection->first_object >= subsection->count)
+        {
+            continue;
+        }
+
+        err = read_xref_entry(sgl, subsection->position +
+                              20 * (ref->object_num - subsection->first_object),
+                              &offset, &generation, &entry_type);
         if (err != ERR_NONE)
             return err;
-        if (read_size != 9)
-            return ERR_PDF_CONTENT;
-
-        if (strncmp(tmp, "startxref", 9) == 0) {
-            if ((err = parse_number(sgl, &(sgl->offset_startxref))) != ERR_NONE)
-                return err;
-            if (sgl->offset_startxref == 0)
-                return ERR_PDF_CONTENT;
 
+        if (entry_type == 'n' && generation == ref->generation_num) {
+            *type = XREF_ENTRY_IN_USE;
+            *field_1 = offset;
+            *field_2 = generation;
             return ERR_NONE;
         }
     }
 
-    return ERR_PDF_CONTENT;
+    if (found_type == XREF_ENTRY_NONE)
+        return ERR_NO_DATA;
+
+    *type = found_type;
+    *field_1 = found_offset;
+    *field_2 = found_generation;
+
+    return ERR_NONE;
+}
+
+sigil_err_t xref_get_entry(sigil_t *sgl, const reference_t *ref, uint8_t *type,
+                           size_t *field_1, size_t *field_2)
+{
+    sigil_err_t err;
+    size_t buf_pos;
+
+    if (sgl == NULL || sgl->xref == NULL || ref == NULL || type == NULL ||
+        field_1 == NULL || field_2 == NULL)
+    {
+        return ERR_PARAMETER;
+    }
+
+    while ((err = find_xref_entry(sgl, ref, type, field_1, field_2)) == ERR_NO_DATA) {
+        // older sections are loaded only when needed, the PDF data need to
+        // be in place (not the decoded object stream)
+        if (sgl->xref->prev_section <= 0 || sgl->objstm.active)
+            break;
+
+        buf_pos = sgl->pdf_data.buf_pos;
+        err = xref_load_sections(sgl, pool_thread_count(sgl, XREF_THREADS_MAX,
+                                                       XREF_THREADS_MAX));
+        sgl->pdf_data.buf_pos = buf_pos;
+
+        if (err != ERR_NONE)
+            return err;
+    }
+
+    return err;
+}
+
+sigil_err_t xref_get_offset(sigil_t *sgl, const reference_t *ref, size_t *result)
+{
+    sigil_err_t err;
+    uint8_t type;
+    size_t offset,
+           generation;
+
+    if (result == NULL)
+        return ERR_PARAMETER;
+
+    err = xref_get_entry(sgl, ref, &type, &offset, &generation);
+    if (err != ERR_NONE)
+        return err;
+
+    // the offset of a compressed entry is the number of its object stream
+    if (type != XREF_ENTRY_IN_USE)
+        return ERR_NOT_IMPLEMENTED;
+
+    *result = offset;
+
+    return ERR_NONE;
+}
+
+/** @brief Records positions of all the "%%EOF" markers found in the data
+ *         into the context, replacing the previously recorded ones
+ *
+ * @param sgl context
+ * @param position position of the data in PDF (relative like in
+ *                 pdf_move_pos_abs)
+ * @param data the data to search
+ * @param size number of bytes of the data
+ * @return ERR_NONE if success
+ */
+static sigil_err_t
+record_eof_markers(sigil_t *sgl, size_t position, const char *data, size_t size)
+{
+    size_t count = 0,
+           i;
+
+    if (sgl->offset_eof != NULL) {
+        mem_free(sgl->offset_eof);
+        sgl->offset_eof = NULL;
+    }
+    sgl->eof_count = 0;
+
+    for (i = 0; (i += find_str(data + i, size - i, "\045\045EOF", 5)) < size; i++)
+        count++;
+
+    if (count <= 0)
+        return ERR_NONE;
+
+    sgl->offset_eof = mem_alloc(sizeof(*sgl->offset_eof) * count);
+    if (sgl->offset_eof == NULL)
+        return ERR_ALLOCATION;
+
+    for (i = 0; (i += find_str(data + i, size - i, "\045\045EOF", 5)) < size; i++)
+        sgl->offset_eof[sgl->eof_count++] = position + i;
+
+    return ERR_NONE;
+}
+
+sigil_err_t read_startxref(sigil_t *sgl)
+{
+    sigil_err_t err;
+    const char *tail;
+    char *copy = NULL;
+    size_t pdf_size,
+           tail_start,
+           tail_size,
+           found;
+
+    if (sgl == NULL)
+        return ERR_PARAMETER;
+
+    if (sgl->pdf_data.size <= sgl->offset_pdf_start)
+        return ERR_PDF_CONTENT;
+
+    // read the end of file at once and search it in memory
+    pdf_size = sgl->pdf_data.size - sgl->offset_pdf_start;
+    tail_size = MIN(pdf_size, XREF_SEARCH_OFFSET);
+    tail_start = pdf_size - tail_size;
+
+    err = pdf_view(sgl, tail_start, tail_size, &tail, &copy);
+    if (err != ERR_NONE)
+        return err;
+
+    err = record_eof_markers(sgl, tail_start, tail, tail_size);
+    if (err != ERR_NONE)
+        goto end;
+
+    found = find_str_reverse(tail, tail_size, "startxref", 9);
+    if (found >= tail_size) {
+        err = ERR_PDF_CONTENT;
+        goto end;
+    }
+
+    err = pdf_move_pos_abs(sgl, tail_start + found + 9);
+    if (err != ERR_NONE)
+        goto end;
+
+    err = parse_number(sgl, &(sgl->offset_startxref));
+    if (err != ERR_NONE)
+        goto end;
+
+    if (sgl->offset_startxref == 0)
+        err = ERR_PDF_CONTENT;
+
+end:
+    if (copy != NULL) {
+        sigil_zeroize(copy, sizeof(*copy) * tail_size);
+        mem_free(copy);
+    }
+
+    return err;
+}
+
+/** @brief Records the subsection starting at the current position to be
+ *         decoded on lookup, if all the entries have the regular 20-byte
+ *         format, and moves the position after it
+ *
+ * @param sgl context
+ * @param first first object of the subsection
+ * @param count number of entries of the subsection
+ * @return ERR_NONE if success, ERR_PDF_CONTENT if the entries are not regular
+ *         and need to be parsed one by one
+ */
+static sigil_err_t record_xref_subsection(sigil_t *sgl, size_t first, size_t count)
+{
+    sigil_err_t err;
+    size_t position,
+           offset,
+           generation;
+    char type;
+
+    if ((err = skip_leading_whitespaces(sgl)) != ERR_NONE)
+        return err;
+
+    if ((err = get_curr_position(sgl, &position)) != ERR_NONE)
+        return err;
+
+    // misplaced end of line anywhere in between shifts the last entry
+    if (read_xref_entry(sgl, position, &offset, &generation, &type) != ERR_NONE ||
+        read_xref_entry(sgl, position + 20 * (count - 1), &offset, &generation,
+                        &type) != ERR_NONE)
+    {
+        return ERR_PDF_CONTENT;
+    }
+
+    err = add_xref_subsection(sgl->xref, position, first, count);
+    if (err != ERR_NONE)
+        return err;
+
+    return pdf_move_pos_abs(sgl, position + 20 * count);
 }
 
-/** @brief Reads all the entries from the cross-reference table to the context
+/** @brief Reads the cross-reference table to the context, the subsections
+ *         with regular entries are only recorded for the lookup
  *
  * @param sgl context
  * @return ERR_NONE if success
@@ -175,6 +716,8 @@ static sigil_err_t read_xref_table(sigil_t *sgl)
     if ((err = skip_word(sgl, "xref")) != ERR_NONE)
         return err;
 
+    sgl->xref->section_count++;
+
     while (!xref_end) { // for all xref sections
         while (1) {
             // read 2 numbers:
@@ -185,9 +728,30 @@ static sigil_err_t read_xref_table(sigil_t *sgl)
                 break;
             }
             if (parse_number(sgl, &section_cnt) != ERR_NONE)
-                return 1;
+                return ERR_PDF_CONTENT;
             if (section_start < 0 || section_cnt < 1)
-                return 1;
+                return ERR_PDF_CONTENT;
+
+            // each entry takes 20 bytes, the count can't be over the file size
+            if (section_cnt > sgl->pdf_data.size / 20 ||
+                section_start > SIZE_MAX - section_cnt)
+            {
+                return ERR_PDF_CONTENT;
+            }
+
+            // regular entries are decoded only when looked up
+            err = record_xref_subsection(sgl, section_start, section_cnt);
+            if (err == ERR_NONE)
+                continue;
+            if (err != ERR_PDF_CONTENT)
+                return err;
+
+            // whole subsection at once, usually the only allocation needed
+            if (section_start + section_cnt <= dense_limit(sgl->xref, section_cnt)) {
+                err = xref_reserve(sgl->xref, section_start + section_cnt);
+                if (err != ERR_NONE)
+                    return err;
+            }
 
             // for all entries in one section
             for (size_t section_offset = 0; section_offset < section_cnt; section_offset++) {
@@ -207,7 +771,8 @@ static sigil_err_t read_xref_table(sigil_t *sgl)
 
                 size_t obj_num = section_start + section_offset;
 
-                err = add_xref_entry(sgl->xref, obj_num, obj_offset, obj_generation);
+                err = add_xref_entry(sgl->xref, obj_num, obj_offset, obj_generation,
+                                     XREF_ENTRY_IN_USE);
                 if (err != ERR_NONE)
                     return err;
             }
@@ -217,6 +782,473 @@ static sigil_err_t read_xref_table(sigil_t *sgl)
     return ERR_NONE;
 }
 
+/** @brief Loads an array of numbers from the current position in the PDF
+ *
+ * @param sgl context
+ * @param numbers output - newly allocated array, to be freed by the caller
+ * @param count output - number of loaded numbers
+ * @return ERR_NONE if success
+ */
+static sigil_err_t parse_number_array(sigil_t *sgl, size_t **numbers, size_t *count)
+{
+    sigil_err_t err;
+    size_t capacity = XREF_PREALLOCATION;
+    void *tmp;
+
+    if (*numbers != NULL)
+        mem_free(*numbers);
+    *count = 0;
+
+    *numbers = mem_alloc(sizeof(**numbers) * capacity);
+    if (*numbers == NULL)
+        return ERR_ALLOCATION;
+
+    err = skip_word(sgl, "[");
+    if (err != ERR_NONE)
+        return err;
+
+    while (skip_word(sgl, "]") != ERR_NONE) {
+        if (*count >= capacity) {
+            tmp = mem_realloc(*numbers, sizeof(**numbers) * capacity * 2);
+            if (tmp == NULL)
+                return ERR_ALLOCATION;
+            *numbers = tmp;
+            capacity *= 2;
+        }
+
+        err = parse_number(sgl, &((*numbers)[*count]));
+        if (err != ERR_NONE)
+            return err;
+        (*count)++;
+    }
+
+    return ERR_NONE;
+}
+
+/** @brief Adds the cross-reference stream to the ones waiting for their data
+ *         to be decoded by process_xref_streams
+ *
+ */
+static xref_stream_t *add_xref_stream(xref_t *xref)
+{
+    xref_stream_t *stream;
+
+    if (xref->stream_count >= xref->stream_capacity) {
+        stream = mem_realloc(xref->stream, sizeof(*stream) *
+                             MAX(xref->stream_capacity * 2, XREF_PREALLOCATION));
+        if (stream == NULL)
+            return NULL;
+
+        xref->stream = stream;
+        xref->stream_capacity = MAX(xref->stream_capacity * 2, XREF_PREALLOCATION);
+    }
+
+    stream = &(xref->stream[xref->stream_count++]);
+    sigil_zeroize(stream, sizeof(*stream));
+    stream->section = current_section(xref);
+
+    return stream;
+}
+
+/** @brief Reads the dictionary of the cross-reference stream, which serves
+ *         also as the trailer. The stream data are only recorded to be decoded
+ *         later by process_xref_streams.
+ *
+ * @param sgl context
+ * @param hybrid whether it is the stream referred to by /XRefStm, which is
+ *               a part of the section of the table, and its dictionary doesn't
+ *               serve as the trailer
+ * @return ERR_NONE if success
+ */
+static sigil_err_t read_xref_stream(sigil_t *sgl, int hybrid)
+{
+    sigil_err_t err;
+    stream_t stream;
+    xref_stream_t *xref_stream;
+    dict_key_t dict_key;
+    size_t *width = NULL,
+           *index = NULL,
+           width_count = 0,
+           index_count = 0,
+           size = 0,
+           length = 0,
+           entry_size = 0,
+           number;
+
+    if (sgl == NULL)
+        return ERR_PARAMETER;
+
+    if (sgl->xref == NULL) {
+        sgl->xref = xref_init();
+        if (sgl->xref == NULL)
+            return ERR_ALLOCATION;
+    }
+
+    stream_init(&stream);
+    if (!hybrid)
+        sgl->xref->section_count++;
+
+    // "<object number> <generation number> obj"
+    if ((err = parse_number(sgl, &number)) != ERR_NONE ||
+        (err = parse_number(sgl, &number)) != ERR_NONE ||
+        (err = skip_word(sgl, "obj")) != ERR_NONE ||
+        (err = skip_word(sgl, "<<")) != ERR_NONE)
+    {
+        goto end;
+    }
+
+    while ((err = parse_dict_key(sgl, &dict_key)) == ERR_NONE) {
+        switch (dict_key) {
+            case DICT_KEY_W:
+                err = parse_number_array(sgl, &width, &width_count);
+                break;
+            case DICT_KEY_Index:
+                err = parse_number_array(sgl, &index, &index_count);
+                break;
+            case DICT_KEY_Size:
+                err = parse_number(sgl, &size);
+                if (err == ERR_NONE && sgl->xref->size_from_trailer <= 0)
+                    sgl->xref->size_from_trailer = size;
+                break;
+            case DICT_KEY_Length:
+                err = parse_number(sgl, &length);
+                break;
+            case DICT_KEY_Filter:
+                err = stream_parse_filter(sgl, &stream);
+                break;
+            case DICT_KEY_DecodeParms:
+                err = stream_parse_decode_parms(sgl, &stream);
+                break;
+            default: // /Prev, /Root and the rest as in the trailer
+                if (hybrid) {
+                    err = skip_dict_unknown_value(sgl);
+                } else {
+                    err = process_trailer_entry(sgl, dict_key);
+                }
+                break;
+        }
+
+        if (err != ERR_NONE)
+            goto end;
+    }
+
+    if (err != ERR_END_OF_DICT)
+        goto end;
+
+    // widths of the fields, each of them needs to fit into size_t
+    if (width_count != 3) {
+        err = ERR_PDF_CONTENT;
+        goto end;
+    }
+
+    for (size_t i = 0; i < 3; i++) {
+        if (width[i] > sizeof(size_t)) {
+            err = ERR_PDF_CONTENT;
+            goto end;
+        }
+        entry_size += width[i];
+    }
+
+    if (entry_size <= 0) {
+        err = ERR_PDF_CONTENT;
+        goto end;
+    }
+
+    // subsections - pairs of the first object and the number of entries
+    if (index == NULL) {
+        index = mem_alloc(sizeof(*index) * 2);
+        if (index == NULL) {
+            err = ERR_ALLOCATION;
+            goto end;
+        }
+        index[0] = 0;
+        index[1] = size;
+        index_count = 2;
+    }
+
+    if (index_count % 2 != 0) {
+        err = ERR_PDF_CONTENT;
+        goto end;
+    }
+
+    for (size_t i = 0; i < index_count; i += 2) {
+        if (index[i] > SIZE_MAX - index[i + 1]) {
+            err = ERR_PDF_CONTENT;
+            goto end;
+        }
+    }
+
+    xref_stream = add_xref_stream(sgl->xref);
+    if (xref_stream == NULL) {
+        err = ERR_ALLOCATION;
+        goto end;
+    }
+
+    if ((err = get_curr_position(sgl, &(xref_stream->position))) != ERR_NONE)
+        goto end;
+
+    xref_stream->length = length;
+    xref_stream->filter = stream.filter;
+    xref_stream->predictor = stream.predictor;
+    xref_stream->columns = stream.columns;
+    for (size_t i = 0; i < 3; i++) {
+        xref_stream->width[i] = width[i];
+    }
+    xref_stream->index = index;
+    xref_stream->index_count = index_count;
+    index = NULL;
+
+end:
+    stream_free(&stream);
+
+    if (width != NULL)
+        mem_free(width);
+    if (index != NULL)
+        mem_free(index);
+
+    return err;
+}
+
+/** @brief Decoding of one cross-reference stream, possibly in a separate
+ *         thread. The entries are collected as a compact list, merged into
+ *         the table of the context afterwards.
+ *
+ */
+typedef struct {
+    const sigil_t       *sgl;
+    const xref_stream_t *xref_stream;
+    xref_overflow_t     *record; // the entries in the order of the stream
+    size_t               record_count;
+    size_t               record_capacity;
+    sigil_err_t          err;
+} xref_part_t;
+
+static sigil_err_t add_xref_record(xref_part_t *part, size_t obj, size_t offset,
+                                   size_t generation, uint8_t type)
+{
+    xref_overflow_t *record;
+
+    if (obj > XREF_MAX_OBJECT_NUM || generation > UINT32_MAX)
+        return ERR_PDF_CONTENT;
+
+    if (part->record_count >= part->record_capacity) {
+        record = mem_realloc(part->record, sizeof(*record) *
+                             MAX(part->record_capacity * 2, XREF_PREALLOCATION));
+        if (record == NULL)
+            return ERR_ALLOCATION;
+
+        part->record = record;
+        part->record_capacity = MAX(part->record_capacity * 2,
+                                    XREF_PREALLOCATION);
+    }
+
+    record = &(part->record[part->record_count++]);
+    record->object_num = obj;
+    record->byte_offset = offset;
+    record->generation_num = (uint32_t)generation;
+    record->section = part->xref_stream->section;
+    record->type = type;
+
+    return ERR_NONE;
+}
+
+/** @brief Decodes the entries of the cross-reference stream directly from its
+ *         data as they are inflated
+ *
+ * @param sgl context used only for reading the PDF data
+ * @param part output - the stream recorded by read_xref_stream, receiving
+ *             the entries
+ * @return ERR_NONE if success
+ */
+static sigil_err_t read_xref_stream_data(sigil_t *sgl, xref_part_t *part)
+{
+    sigil_err_t err;
+    stream_t stream;
+    unsigned char entry[3 * sizeof(size_t)];
+    const unsigned char *field_data;
+    const xref_stream_t *xref_stream = part->xref_stream;
+    const size_t *width = xref_stream->width,
+                 *index = xref_stream->index;
+    size_t entry_size = width[0] + width[1] + width[2],
+           field[3],
+           read_size;
+
+    stream_init(&stream);
+    stream.filter = xref_stream->filter;
+    stream.predictor = xref_stream->predictor;
+    stream.columns = xref_stream->columns;
+
+    if ((err = pdf_move_pos_abs(sgl, xref_stream->position)) != ERR_NONE ||
+        (err = stream_open(sgl, &stream, xref_stream->length)) != ERR_NONE)
+    {
+        goto end;
+    }
+
+    for (size_t i = 0; i < xref_stream->index_count; i += 2) {
+        for (size_t obj = index[i]; obj < index[i] + index[i + 1]; obj++) {
+            err = stream_read(sgl, &stream, (char *)entry, entry_size, &read_size);
+            if (err == ERR_NO_DATA || (err == ERR_NONE && read_size != entry_size))
+                err = ERR_PDF_CONTENT;
+            if (err != ERR_NONE)
+                goto end;
+
+            // big-endian fields, missing type means 1 and generation 0
+            field_data = entry;
+            for (size_t f = 0; f < 3; f++) {
+                field[f] = 0;
+                for (size_t b = 0; b < width[f]; b++) {
+                    field[f] = (field[f] << 8) | *field_data++;
+                }
+            }
+            if (width[0] <= 0)
+                field[0] = 1;
+
+            switch (field[0]) {
+                case 1:
+                    err = add_xref_record(part, obj, field[1], field[2],
+                                          XREF_ENTRY_IN_USE);
+                    break;
+                case 2:
+                    err = add_xref_record(part, obj, field[1], field[2],
+                                          XREF_ENTRY_COMPRESSED);
+                    break;
+                default: // free objects and unknown types
+                    break;
+            }
+
+            if (err != ERR_NONE)
+                goto end;
+        }
+    }
+
+end:
+    stream_free(&stream);
+
+    return err;
+}
+
+static sigil_err_t parse_xref_part(pool_t *pool, void *arg)
+{
+    xref_part_t *part = arg;
+    sigil_t reader;
+
+    (void)pool;
+
+    // only the PDF data with own position and read window, nothing else of
+    // the context is shared with the other threads
+    sigil_zeroize(&reader, sizeof(reader));
+    reader.pdf_data = part->sgl->pdf_data;
+    reader.pdf_data.window = NULL;
+    reader.pdf_data.window_start = 0;
+    reader.pdf_data.window_size = 0;
+    reader.offset_pdf_start = part->sgl->offset_pdf_start;
+
+    part->err = read_xref_stream_data(&reader, part);
+
+    if (reader.pdf_data.window != NULL) {
+        sigil_zeroize(reader.pdf_data.window,
+                      sizeof(*reader.pdf_data.window) * READ_WINDOW_SIZE);
+        mem_free(reader.pdf_data.window);
+    }
+
+    // reported in the order of the sections by process_xref_streams
+    return ERR_NONE;
+}
+
+/** @brief Adds the entries decoded from the cross-reference stream to the
+ *         table of the context, the newest entry of each object wins
+ *
+ */
+static sigil_err_t merge_xref_part(xref_t *xref, const xref_part_t *part)
+{
+    sigil_err_t err;
+    const xref_overflow_t *record;
+
+    for (size_t i = 0; i < part->record_count; i++) {
+        record = &(part->record[i]);
+
+        err = add_xref_entry_at(xref, record->object_num, record->byte_offset,
+                                record->generation_num, record->type,
+                                record->section);
+        if (err != ERR_NONE)
+            return err;
+    }
+
+    return ERR_NONE;
+}
+
+sigil_err_t process_xref_streams(sigil_t *sgl)
+{
+    sigil_err_t err = ERR_NONE,
+                err_wait;
+    xref_t *xref;
+    xref_part_t *parts;
+    pool_t *pool;
+    size_t count;
+
+    if (sgl == NULL || sgl->xref == NULL)
+        return ERR_PARAMETER;
+
+    xref = sgl->xref;
+    count = xref->stream_count;
+
+    if (count <= 0)
+        return ERR_NONE;
+
+    parts = mem_alloc(sizeof(*parts) * count);
+    if (parts == NULL)
+        return ERR_ALLOCATION;
+    sigil_zeroize(parts, sizeof(*parts) * count);
+
+    // separate list of entries for each section
+    for (size_t i = 0; i < count; i++) {
+        parts[i].sgl = sgl;
+        parts[i].xref_stream = &(xref->stream[i]);
+    }
+
+    pool = pool_create(pool_thread_count(sgl, count, XREF_THREADS_MAX));
+    if (pool == NULL) {
+        err = ERR_ALLOCATION;
+        goto end;
+    }
+
+    for (size_t i = 0; i < count && err == ERR_NONE; i++) {
+        err = pool_submit(pool, parse_xref_part, &(parts[i]));
+    }
+
+    // the tasks submitted so far use the parts
+    err_wait = pool_wait(pool);
+    pool_free(pool);
+    if (err == ERR_NONE)
+        err = err_wait;
+    if (err != ERR_NONE)
+        goto end;
+
+    // the newest section first, reporting its error like the serial parsing
+    for (size_t i = 0; i < count; i++) {
+        if ((err = parts[i].err) != ERR_NONE)
+            goto end;
+
+        if ((err = merge_xref_part(xref, &(parts[i]))) != ERR_NONE)
+            goto end;
+    }
+
+end:
+    for (size_t i = 0; i < count; i++) {
+        if (parts[i].record != NULL)
+            mem_free(parts[i].record);
+    }
+    mem_free(parts);
+
+    for (size_t i = 0; i < xref->stream_count; i++) {
+        if (xref->stream[i].index != NULL)
+            mem_free(xref->stream[i].index);
+    }
+    xref->stream_count = 0;
+
+    return err;
+}
+
 sigil_err_t process_xref(sigil_t *sgl)
 {
     sigil_err_t err;
@@ -230,79 +1262,1214 @@ sigil_err_t process_xref(sigil_t *sgl)
 
     switch (sgl->xref_type) {
         case XREF_TYPE_TABLE:
-            read_xref_table(sgl);
-            break;
+            return read_xref_table(sgl);
         case XREF_TYPE_STREAM:
-            return ERR_NOT_IMPLEMENTED;
+            // only the dictionary, the data are decoded by process_xref_streams
+            return read_xref_stream(sgl, 0);
         default:
             return ERR_PDF_CONTENT;
     }
+}
 
-    return ERR_NONE;
+sigil_err_t process_xref_stm(sigil_t *sgl, size_t position)
+{
+    sigil_err_t err;
+    size_t trailer_position;
+
+    if (sgl == NULL || sgl->xref == NULL)
+        return ERR_PARAMETER;
+
+    if ((err = get_curr_position(sgl, &trailer_position)) != ERR_NONE ||
+        (err = pdf_move_pos_abs(sgl, position)) != ERR_NONE)
+    {
+        return err;
+    }
+
+    err = read_xref_stream(sgl, 1);
+    if (err != ERR_NONE)
+        return err;
+
+    // rest of the trailer dictionary
+    return pdf_move_pos_abs(sgl, trailer_position);
 }
 
-void print_xref(xref_t *xref)
+sigil_err_t xref_load_sections(sigil_t *sgl, size_t count)
 {
-    xref_entry_t *xref_entry;
-    if (xref == NULL)
-        return;
+    sigil_err_t err;
+    size_t position;
 
-    printf("\nXREF\n");
-    for (size_t i = 0; i < xref->capacity; i++) {
-        xref_entry = xref->entry[i];
+    if (sgl == NULL || sgl->xref == NULL || count <= 0)
+        return ERR_PARAMETER;
+
+    if (sgl->xref->prev_section <= 0)
+        return ERR_NO_DATA;
+
+    // dictionaries and trailers first, following the /Prev links
+    while (sgl->xref->prev_section > 0 && count-- > 0) {
+        // prevents forever loop caused by cyclic links
+        if (sgl->xref->sections_left <= 0) {
+            sgl->xref->prev_section = 0;
+            break;
+        }
+        sgl->xref->sections_left--;
+
+        // go to the position of the beginning of next cross-reference section
+        position = sgl->xref->prev_section;
+        sgl->xref->prev_section = 0;
+
+        err = pdf_move_pos_abs(sgl, position);
+        if (err != ERR_NONE)
+            return err;
+
+        err = process_xref(sgl);
+        if (err != ERR_NONE)
+            return err;
 
-        while (xref_entry != NULL) {
-            printf("obj %zd (gen %zd) | offset %zd\n", i,
-                   xref_entry->generation_num, xref_entry->byte_offset);
-            xref_entry = xref_entry->next;
+        // dictionary of the cross-reference stream serves as the trailer
+        if (sgl->xref_type == XREF_TYPE_TABLE) {
+            err = process_trailer(sgl);
+            if (err != ERR_NONE)
+                return err;
         }
     }
+
+    // then the data of the cross-reference streams among them
+    return process_xref_streams(sgl);
 }
 
-int sigil_xref_self_test(int verbosity)
+/** @brief Positions and object numbers recorded while scanning for the "obj"
+ *         headers, examined once all the objects are in the table
+ *
+ */
+typedef struct {
+    size_t *root;     // headers of the catalogs and cross-reference streams
+    size_t  root_count;
+    size_t  root_capacity;
+    size_t *objstm;   // object numbers of the object streams
+    size_t  objstm_count;
+    size_t  objstm_capacity;
+} reconstruct_t;
+
+// keeps the positions before the block, so that the header of the "obj"
+// keyword at the beginning of the block is complete
+#define RECONSTRUCT_OVERLAP 64
+
+static sigil_err_t append_number(size_t **array, size_t *count,
+                                 size_t *capacity, size_t value)
 {
-    sigil_t *sgl = NULL;
+    size_t *tmp;
 
-    print_module_name("xref", verbosity);
+    if (*count >= *capacity) {
+        tmp = mem_realloc(*array, sizeof(*tmp) * MAX(*capacity * 2, XREF_PREALLOCATION));
+        if (tmp == NULL)
+            return ERR_ALLOCATION;
 
-    // TEST: fn determine_xref_type - TABLE
-    print_test_item("fn determine_xref_type TABLE", verbosity);
+        *array = tmp;
+        *capacity = MAX(*capacity * 2, XREF_PREALLOCATION);
+    }
+
+    (*array)[(*count)++] = value;
 
+    return ERR_NONE;
+}
+
+// number written right before the position *end*, returns the count of its
+// digits, 0 if there is no number or it is too long
+static size_t number_before(const char *data, size_t end, size_t *value)
+{
+    size_t digits = 0,
+           order = 1;
+
+    *value = 0;
+
+    while (digits < end && is_digit(data[end - digits - 1])) {
+        if (digits >= 9)
+            return 0;
+
+        *value += (size_t)(data[end - digits - 1] - '0') * order;
+        order *= 10;
+        digits++;
+    }
+
+    return digits;
+}
+
+/** @brief Checks that the "obj" keyword at *pos* is a part of the object
+ *         header "<object number> <generation number> obj"
+ *
+ * @param data scanned data
+ * @param size size of the scanned data
+ * @param pos position of the "obj" keyword in the data
+ * @param at_start whether the data begin at the beginning of PDF
+ * @param obj output - object number
+ * @param generation output - generation number
+ * @param header output - position of the header in the data
+ * @return 1 if it is the object header, 0 otherwise
+ */
+static int parse_obj_header(const char *data, size_t size, size_t pos,
+                            int at_start, size_t *obj, size_t *generation,
+                            size_t *header)
+{
+    size_t i = pos,
+           digits;
+
+    // not only the beginning of a longer word
+    if (pos + 3 < size && !is_whitespace(data[pos + 3]) &&
+        !is_delimiter(data[pos + 3]))
     {
-        sgl = test_prepare_sgl_path(
-            "test/subtype_adbe.x509.rsa_sha1.pdf");
-        if (sgl == NULL)
-            goto failed;
+        return 0;
+    }
 
-        sgl->xref_type = XREF_TYPE_UNSET;
+    // whitespaces, generation number, whitespaces, object number
+    if (i <= 0 || !is_whitespace(data[i - 1]))
+        return 0;
+    while (i > 0 && is_whitespace(data[i - 1]))
+        i--;
 
-        if (pdf_move_pos_abs(sgl, 58077) != ERR_NONE)
-            goto failed;
+    if ((digits = number_before(data, i, generation)) <= 0)
+        return 0;
+    i -= digits;
 
-        if (determine_xref_type(sgl) != ERR_NONE ||
-            sgl->xref_type != XREF_TYPE_TABLE)
-        {
-            goto failed;
-        }
+    if (i <= 0 || !is_whitespace(data[i - 1]))
+        return 0;
+    while (i > 0 && is_whitespace(data[i - 1]))
+        i--;
 
-        sigil_free(&sgl);
+    if ((digits = number_before(data, i, obj)) <= 0)
+        return 0;
+    i -= digits;
+
+    // the object number is not the end of another word
+    if (i > 0 ? !is_whitespace(data[i - 1]) && !is_delimiter(data[i - 1])
+              : !at_start)
+    {
+        return 0;
     }
 
-    print_test_result(1, verbosity);
+    if (*obj <= 0 || *obj > XREF_MAX_OBJECT_NUM || *generation > 65535)
+        return 0;
 
-    // TEST: fn read_startxref
-    print_test_item("fn read_startxref", verbosity);
+    *header = i;
+
+    return 1;
+}
 
+// the last occurrence of the object in the file wins, as the incremental
+// updates are appended
+static sigil_err_t set_reconstructed_entry(xref_t *xref, size_t obj,
+                                           size_t offset, size_t generation)
+{
+    if (obj < xref->capacity && xref->type[obj] == XREF_ENTRY_IN_USE &&
+        xref->generation_num[obj] == generation)
     {
-        char *sstream = "abcdefghi\n" \
-                        "startxref\n" \
-                        "1234567890\n"\
-                        "\045\045EOF"; // %%EOF
-        if ((sgl = test_prepare_sgl_buffer(sstream, strlen(sstream) + 1)) == NULL)
-            goto failed;
+        xref->byte_offset[obj] = offset;
+        return ERR_NONE;
+    }
 
-        if (read_startxref(sgl) != ERR_NONE ||
-            sgl->offset_startxref != 1234567890)
+    for (size_t i = 0; i < xref->overflow_count; i++) {
+        if (xref->overflow[i].object_num == obj &&
+            xref->overflow[i].type == XREF_ENTRY_IN_USE &&
+            xref->overflow[i].generation_num == generation)
+        {
+            xref->overflow[i].byte_offset = offset;
+            return ERR_NONE;
+        }
+    }
+
+    return add_xref_entry_at(xref, obj, offset, generation, XREF_ENTRY_IN_USE, 0);
+}
+
+/** @brief Adds the objects having the "obj" header in the *data* between
+ *         *from* and *to* into the table of the context
+ *
+ * @param sgl context
+ * @param data scanned data, including the bytes before *from* and after *to*
+ *             needed to check the headers
+ * @param size size of the scanned data
+ * @param from position in the data where to start
+ * @param to position in the data where to stop
+ * @param base position of the data in PDF
+ * @param rec output - candidates for the catalog and the object streams
+ * @return ERR_NONE if success
+ */
+static sigil_err_t scan_obj_headers(sigil_t *sgl, const char *data, size_t size,
+                                    size_t from, size_t to, size_t base,
+                                    reconstruct_t *rec)
+{
+    sigil_err_t err;
+    size_t pos = from,
+           found,
+           obj,
+           generation,
+           header,
+           window;
+
+    while (pos < to) {
+        found = find_str(data + pos, size - pos, "obj", 3);
+        if (found >= size - pos || pos + found >= to)
+            break;
+        pos += found;
+
+        if (parse_obj_header(data, size, pos, base <= 0, &obj, &generation,
+                             &header))
+        {
+            err = set_reconstructed_entry(sgl->xref, obj, base + header, generation);
+            if (err != ERR_NONE)
+                return err;
+
+            // type of the object only from its dictionary, before any stream
+            window = MIN(XREF_RECONSTRUCT_WINDOW, size - pos - 3);
+            window = find_str(data + pos + 3, window, "stream", 6);
+            window = find_str(data + pos + 3, window, "endobj", 6);
+
+            if (find_str(data + pos + 3, window, "/Catalog", 8) < window ||
+                find_str(data + pos + 3, window, "/XRef", 5) < window)
+            {
+                err = append_number(&(rec->root), &(rec->root_count),
+                                    &(rec->root_capacity), base + header);
+                if (err != ERR_NONE)
+                    return err;
+            }
+
+            if (generation <= 0 &&
+                find_str(data + pos + 3, window, "/ObjStm", 7) < window)
+            {
+                err = append_number(&(rec->objstm), &(rec->objstm_count),
+                                    &(rec->objstm_capacity), obj);
+                if (err != ERR_NONE)
+                    return err;
+            }
+        }
+
+        pos += 3;
+    }
+
+    return ERR_NONE;
+}
+
+// adds the objects compressed in the object stream, unless found uncompressed
+// further in the file, the later object streams override the earlier ones
+static sigil_err_t recover_objstm(sigil_t *sgl, size_t stream_num)
+{
+    sigil_err_t err;
+    xref_t *xref = sgl->xref;
+    size_t *object = NULL,
+           count = 0,
+           obj;
+
+    if (stream_num >= xref->capacity || xref->type[stream_num] != XREF_ENTRY_IN_USE)
+        return ERR_PDF_CONTENT;
+
+    err = objstm_list_objects(sgl, stream_num, &object, &count);
+    if (err != ERR_NONE)
+        return err;
+
+    for (size_t i = 0; i < count; i++) {
+        obj = object[i];
+        if (obj <= 0 || obj > XREF_MAX_OBJECT_NUM || obj == stream_num)
+            continue;
+
+        if (obj < xref->capacity &&
+            (xref->type[obj] == XREF_ENTRY_COMPRESSED ||
+             (xref->type[obj] == XREF_ENTRY_IN_USE && xref->generation_num[obj] <= 0)))
+        {
+            if (xref->type[obj] == XREF_ENTRY_IN_USE &&
+                xref->byte_offset[obj] > xref->byte_offset[stream_num])
+            {
+                continue;
+            }
+
+            xref->byte_offset[obj] = stream_num;
+            xref->generation_num[obj] = (uint32_t)i;
+            xref->type[obj] = XREF_ENTRY_COMPRESSED;
+            continue;
+        }
+
+        err = add_xref_entry_at(xref, obj, stream_num, i, XREF_ENTRY_COMPRESSED, 0);
+        if (err != ERR_NONE)
+            break;
+    }
+
+    mem_free(object);
+
+    return err;
+}
+
+// reference to the catalog from the object with the header at *position*,
+// either the catalog itself, or a cross-reference stream with /Root
+static sigil_err_t read_root_candidate(sigil_t *sgl, size_t position,
+                                       reference_t *catalog)
+{
+    sigil_err_t err;
+    dict_key_t dict_key;
+    reference_t ref,
+                root;
+    size_t value_position;
+    int has_root = 0;
+
+    if ((err = pdf_move_pos_abs(sgl, position)) != ERR_NONE ||
+        (err = parse_number(sgl, &(ref.object_num))) != ERR_NONE ||
+        (err = parse_number(sgl, &(ref.generation_num))) != ERR_NONE ||
+        (err = skip_word(sgl, "obj")) != ERR_NONE ||
+        (err = skip_word(sgl, "<<")) != ERR_NONE)
+    {
+        return err;
+    }
+
+    while ((err = parse_dict_key(sgl, &dict_key)) == ERR_NONE) {
+        switch (dict_key) {
+            case DICT_KEY_Type:
+                if ((err = get_curr_position(sgl, &value_position)) != ERR_NONE)
+                    return err;
+
+                if (skip_word(sgl, "/Catalog") == ERR_NONE) {
+                    *catalog = ref;
+                    return ERR_NONE;
+                }
+
+                if ((err = pdf_move_pos_abs(sgl, value_position)) != ERR_NONE)
+                    return err;
+                err = skip_dict_unknown_value(sgl);
+                break;
+            case DICT_KEY_Root:
+                err = parse_indirect_reference(sgl, &root);
+                has_root = (err == ERR_NONE);
+                break;
+            default: // also the known keys not used in this dictionary
+                err = skip_dict_unknown_value(sgl);
+                break;
+        }
+
+        if (err != ERR_NONE)
+            return err;
+    }
+
+    if (err != ERR_END_OF_DICT)
+        return err;
+
+    if (!has_root)
+        return ERR_NO_DATA;
+
+    *catalog = root;
+
+    return ERR_NONE;
+}
+
+sigil_err_t xref_reconstruct(sigil_t *sgl)
+{
+    sigil_err_t err;
+    reconstruct_t rec;
+    reference_t catalog;
+    const char *data;
+    char *block = NULL;
+    size_t length,
+           position,
+           before,
+           read_size;
+
+    if (sgl == NULL)
+        return ERR_PARAMETER;
+
+    // the object streams decoded so far were found by the old table
+    objstm_free(sgl);
+
+    // once per verification, also if failed
+    sgl->xref_reconstructed = 1;
+
+    sigil_zeroize(&rec, sizeof(rec));
+
+    if (sgl->xref != NULL) {
+        xref_reset(sgl->xref);
+    } else if ((sgl->xref = xref_init()) == NULL) {
+        return ERR_ALLOCATION;
+    }
+
+    if (sgl->pdf_data.size <= sgl->offset_pdf_start)
+        return ERR_PDF_CONTENT;
+    length = sgl->pdf_data.size - sgl->offset_pdf_start;
+
+    if (pdf_borrow(sgl, 0, length, &data) == ERR_NONE) {
+        // single pass through the data in memory
+        err = scan_obj_headers(sgl, data, length, 0, length, 0, &rec);
+        if (err != ERR_NONE)
+            goto end;
+    } else {
+        // blocks of READ_AHEAD_SIZE, extended on both sides to check
+        // the headers across the boundaries
+        block = mem_alloc(sizeof(*block) * (RECONSTRUCT_OVERLAP + READ_AHEAD_SIZE +
+                                            XREF_RECONSTRUCT_WINDOW + 1));
+        if (block == NULL) {
+            err = ERR_ALLOCATION;
+            goto end;
+        }
+
+        for (position = 0; position < length; position += READ_AHEAD_SIZE) {
+            before = MIN(position, RECONSTRUCT_OVERLAP);
+
+            if ((err = pdf_move_pos_abs(sgl, position - before)) != ERR_NONE ||
+                (err = pdf_read(sgl, MIN(before + READ_AHEAD_SIZE +
+                                         XREF_RECONSTRUCT_WINDOW,
+                                         length - position + before),
+                                block, &read_size)) != ERR_NONE)
+            {
+                goto end;
+            }
+
+            err = scan_obj_headers(sgl, block, read_size, before,
+                                   MIN(before + READ_AHEAD_SIZE, read_size),
+                                   position - before, &rec);
+            if (err != ERR_NONE)
+                goto end;
+        }
+    }
+
+    // objects without their own header, unreadable object streams are skipped
+    for (size_t i = 0; i < rec.objstm_count; i++) {
+        err = recover_objstm(sgl, rec.objstm[i]);
+        if (err == ERR_ALLOCATION)
+            goto end;
+    }
+
+    // catalog of the newest update, otherwise the one from a readable trailer
+    for (size_t i = rec.root_count; i > 0; i--) {
+        if (read_root_candidate(sgl, rec.root[i - 1], &catalog) == ERR_NONE) {
+            sgl->ref_catalog_dict = catalog;
+            break;
+        }
+    }
+
+    err = ERR_NONE;
+    if (sgl->ref_catalog_dict.object_num <= 0)
+        err = ERR_PDF_CONTENT;
+
+end:
+    if (block != NULL)
+        mem_free(block);
+    if (rec.root != NULL)
+        mem_free(rec.root);
+    if (rec.objstm != NULL)
+        mem_free(rec.objstm);
+
+    return err;
+}
+
+void print_xref(xref_t *xref)
+{
+    if (xref == NULL)
+        return;
+
+    printf("\nXREF\n");
+    for (size_t i = 0; i < xref->capacity; i++) {
+        if (xref->type[i] == XREF_ENTRY_NONE)
+            continue;
+
+        printf("obj %zd (gen %u) | offset %zd\n", i,
+               xref->generation_num[i], xref->byte_offset[i]);
+    }
+
+    for (size_t i = 0; i < xref->overflow_count; i++) {
+        printf("obj %zd (gen %u) | offset %zd\n", xref->overflow[i].object_num,
+               xref->overflow[i].generation_num, xref->overflow[i].byte_offset);
+    }
+
+    for (size_t i = 0; i < xref->subsection_count; i++) {
+        printf("obj %zd - %zd | not parsed, entries at %zd\n",
+               xref->subsection[i].first_object,
+               xref->subsection[i].first_object + xref->subsection[i].count - 1,
+               xref->subsection[i].position);
+    }
+}
+
+/** @brief Creates the PDF data with *count* incremental updates, each one with
+ *         a cross-reference stream (W [1 2 1]), which moves object 1 to offset
+ *         10 + the number of update and adds object 100 + the number of update
+ *         at offset 256 + the number of update
+ *
+ * @return size of the data
+ */
+static size_t test_xref_stream_chain(char *pdf, size_t count)
+{
+    size_t pos,
+           prev = 0,
+           offset;
+
+    pos = (size_t)sprintf(pdf, "%%PDF-1.5\n");
+    for (size_t i = 0; i < count; i++) {
+        offset = pos;
+        pos += (size_t)sprintf(pdf + pos,
+            "%zu 0 obj\n<</Type /XRef /Size %zu /W [1 2 1] /Index [1 1 %zu 1]",
+            100 + i, 100 + count, 100 + i);
+        if (prev > 0)
+            pos += (size_t)sprintf(pdf + pos, " /Prev %zu", prev);
+        pos += (size_t)sprintf(pdf + pos, " /Length 8>>\nstream\n");
+
+        pdf[pos++] = 1;
+        pdf[pos++] = 0;
+        pdf[pos++] = (char)(10 + i);
+        pdf[pos++] = 0;
+        pdf[pos++] = 1;
+        pdf[pos++] = 1;
+        pdf[pos++] = (char)i;
+        pdf[pos++] = 0;
+
+        pos += (size_t)sprintf(pdf + pos, "\nendstream\nendobj\n");
+        prev = offset;
+    }
+    pos += (size_t)sprintf(pdf + pos, "startxref\n%zu\n%%%%EOF\n", prev);
+
+    return pos;
+}
+
+int sigil_xref_self_test(int verbosity)
+{
+    sigil_t *sgl = NULL;
+
+    print_module_name("xref", verbosity);
+
+    // TEST: fn determine_xref_type - TABLE
+    print_test_item("fn determine_xref_type TABLE", verbosity);
+
+    {
+        sgl = test_prepare_sgl_path(
+            "test/subtype_adbe.x509.rsa_sha1.pdf");
+        if (sgl == NULL)
+            goto failed;
+
+        sgl->xref_type = XREF_TYPE_UNSET;
+
+        if (pdf_move_pos_abs(sgl, 58077) != ERR_NONE)
+            goto failed;
+
+        if (determine_xref_type(sgl) != ERR_NONE ||
+            sgl->xref_type != XREF_TYPE_TABLE)
+        {
+            goto failed;
+        }
+
+        sigil_free(&sgl);
+    }
+
+    print_test_result(1, verbosity);
+
+    // TEST: fn add_xref_entry, xref_get_offset
+    print_test_item("fn add_xref_entry", verbosity);
+
+    {
+        reference_t ref;
+        size_t offset;
+
+        if (sigil_init(&sgl) != ERR_NONE || (sgl->xref = xref_init()) == NULL)
+            goto failed;
+
+        // the newer entry (added first) wins, other generations are kept,
+        // the lone object far beyond the others doesn't make the table grow
+        if (add_xref_entry(sgl->xref, 5, 100, 0, XREF_ENTRY_IN_USE) != ERR_NONE ||
+            add_xref_entry(sgl->xref, 1000, 200, 0, XREF_ENTRY_IN_USE) != ERR_NONE ||
+            add_xref_entry(sgl->xref, 5, 300, 0, XREF_ENTRY_IN_USE) != ERR_NONE ||
+            add_xref_entry(sgl->xref, 5, 400, 1, XREF_ENTRY_IN_USE) != ERR_NONE ||
+            sgl->xref->capacity != XREF_PREALLOCATION ||
+            sgl->xref->overflow_count != 2)
+        {
+            goto failed;
+        }
+
+        ref.object_num = 1000;
+        ref.generation_num = 0;
+        if (xref_get_offset(sgl, &ref, &offset) != ERR_NONE || offset != 200)
+            goto failed;
+
+        ref.object_num = 5;
+        ref.generation_num = 0;
+        if (xref_get_offset(sgl, &ref, &offset) != ERR_NONE || offset != 100)
+            goto failed;
+
+        ref.generation_num = 1;
+        if (xref_get_offset(sgl, &ref, &offset) != ERR_NONE || offset != 400)
+            goto failed;
+
+        ref.generation_num = 2;
+        if (xref_get_offset(sgl, &ref, &offset) != ERR_NO_DATA)
+            goto failed;
+
+        ref.object_num = 999;
+        ref.generation_num = 0;
+        if (xref_get_offset(sgl, &ref, &offset) != ERR_NO_DATA)
+            goto failed;
+
+        // no offset in the file for the compressed object
+        ref.object_num = 6;
+        offset = 123;
+        if (add_xref_entry(sgl->xref, 6, 7, 0, XREF_ENTRY_COMPRESSED) != ERR_NONE ||
+            xref_get_offset(sgl, &ref, &offset) != ERR_NOT_IMPLEMENTED ||
+            offset != 123)
+        {
+            goto failed;
+        }
+
+        // object numbers over the limit are refused
+        if (add_xref_entry(sgl->xref, (size_t)1 << 40, 500, 0,
+                           XREF_ENTRY_IN_USE) != ERR_PDF_CONTENT ||
+            sgl->xref->capacity != XREF_PREALLOCATION)
+        {
+            goto failed;
+        }
+
+        // objects listed one by one grow the table, but not beyond /Size
+        sgl->xref->size_from_trailer = 40;
+        for (size_t i = 10; i < 50; i++) {
+            if (add_xref_entry(sgl->xref, i, 600 + i, 0, XREF_ENTRY_IN_USE) != ERR_NONE)
+                goto failed;
+        }
+
+        ref.object_num = 45;
+        if (sgl->xref->capacity != 40 ||
+            xref_get_offset(sgl, &ref, &offset) != ERR_NONE || offset != 645)
+        {
+            goto failed;
+        }
+
+        sigil_free(&sgl);
+    }
+
+    print_test_result(1, verbosity);
+
+    // TEST: fn read_xref_table - entries decoded on lookup
+    print_test_item("fn read_xref_table", verbosity);
+
+    {
+        reference_t ref;
+        size_t offset;
+
+        char *sstream = "xref\n"                    \
+                        "0 3\n"                     \
+                        "0000000000 65535 f\r\n"    \
+                        "0000000017 00000 n\r\n"    \
+                        "0000000081 00000 n\r\n"    \
+                        "7 1\n"                     \
+                        "0000000123 00002 n \n"     \
+                        "trailer\n";
+        if ((sgl = test_prepare_sgl_buffer(sstream, strlen(sstream) + 1)) == NULL)
+            goto failed;
+
+        if ((sgl->xref = xref_init()) == NULL ||
+            read_xref_table(sgl) != ERR_NONE ||
+            sgl->xref->subsection_count != 2 ||
+            sgl->xref->capacity != XREF_PREALLOCATION ||
+            skip_word(sgl, "trailer") != ERR_NONE)
+        {
+            goto failed;
+        }
+
+        ref.object_num = 1;
+        ref.generation_num = 0;
+        if (xref_get_offset(sgl, &ref, &offset) != ERR_NONE || offset != 17)
+            goto failed;
+
+        ref.object_num = 7;
+        ref.generation_num = 2;
+        if (xref_get_offset(sgl, &ref, &offset) != ERR_NONE || offset != 123)
+            goto failed;
+
+        ref.object_num = 0;
+        ref.generation_num = 65535;
+        if (xref_get_offset(sgl, &ref, &offset) != ERR_NO_DATA)
+            goto failed;
+
+        ref.object_num = 3;
+        ref.generation_num = 0;
+        if (xref_get_offset(sgl, &ref, &offset) != ERR_NO_DATA)
+            goto failed;
+
+        // entry from an older section doesn't override the newer one
+        sgl->xref->section_count++;
+        if (add_xref_entry(sgl->xref, 1, 999, 0, XREF_ENTRY_IN_USE) != ERR_NONE ||
+            add_xref_entry(sgl->xref, 3, 888, 0, XREF_ENTRY_IN_USE) != ERR_NONE)
+        {
+            goto failed;
+        }
+
+        ref.object_num = 1;
+        if (xref_get_offset(sgl, &ref, &offset) != ERR_NONE || offset != 17)
+            goto failed;
+
+        ref.object_num = 3;
+        if (xref_get_offset(sgl, &ref, &offset) != ERR_NONE || offset != 888)
+            goto failed;
+
+        sigil_free(&sgl);
+
+        // irregular entries (19 bytes) are parsed in advance
+        sstream = "xref\n"                  \
+                  "0 2\n"                   \
+                  "0000000000 65535 f\n"    \
+                  "0000000017 00000 n\n"    \
+                  "trailer\n";
+        if ((sgl = test_prepare_sgl_buffer(sstream, strlen(sstream) + 1)) == NULL)
+            goto failed;
+
+        if ((sgl->xref = xref_init()) == NULL ||
+            read_xref_table(sgl) != ERR_NONE ||
+            sgl->xref->subsection_count != 0 ||
+            skip_word(sgl, "trailer") != ERR_NONE)
+        {
+            goto failed;
+        }
+
+        ref.object_num = 1;
+        ref.generation_num = 0;
+        if (xref_get_offset(sgl, &ref, &offset) != ERR_NONE || offset != 17)
+            goto failed;
+
+        sigil_free(&sgl);
+
+        // high object number before the trailer is known, the table stays small
+        sstream = "xref\n"                  \
+                  "8388000 1\n"             \
+                  "0000000017 00000 n\n"    \
+                  "trailer\n<</Size 2>>\n";
+        if ((sgl = test_prepare_sgl_buffer(sstream, strlen(sstream) + 1)) == NULL)
+            goto failed;
+
+        if ((sgl->xref = xref_init()) == NULL ||
+            read_xref_table(sgl) != ERR_NONE ||
+            sgl->xref->capacity != XREF_PREALLOCATION)
+        {
+            goto failed;
+        }
+
+        ref.object_num = 8388000;
+        ref.generation_num = 0;
+        if (xref_get_offset(sgl, &ref, &offset) != ERR_NONE || offset != 17)
+            goto failed;
+
+        sigil_free(&sgl);
+    }
+
+    print_test_result(1, verbosity);
+
+    // TEST: fn read_xref_stream
+    print_test_item("fn read_xref_stream", verbosity);
+
+    {
+        reference_t ref;
+        size_t offset;
+
+        sgl = test_prepare_sgl_path("test/xref_stream.pdf");
+        if (sgl == NULL)
+            goto failed;
+
+        if (read_startxref(sgl) != ERR_NONE ||
+            sgl->offset_startxref != 58415 ||
+            pdf_move_pos_abs(sgl, sgl->offset_startxref) != ERR_NONE ||
+            (sgl->xref = xref_init()) == NULL ||
+            process_xref(sgl) != ERR_NONE ||
+            process_xref_streams(sgl) != ERR_NONE ||
+            sgl->xref_type != XREF_TYPE_STREAM ||
+            sgl->xref->size_from_trailer != 20 ||
+            sgl->xref->prev_section != 58077 ||
+            sgl->ref_catalog_dict.object_num != 12)
+        {
+            goto failed;
+        }
+
+        ref.object_num = 12;
+        ref.generation_num = 0;
+        if (xref_get_offset(sgl, &ref, &offset) != ERR_NONE || offset != 10639)
+            goto failed;
+
+        ref.object_num = 19;
+        if (xref_get_offset(sgl, &ref, &offset) != ERR_NONE || offset != 58415)
+            goto failed;
+
+        // not in the stream, loaded from the older table on demand
+        ref.object_num = 14;
+        if (sgl->xref->section_count != 1 ||
+            xref_get_offset(sgl, &ref, &offset) != ERR_NONE ||
+            offset != 10943 ||
+            sgl->xref->section_count < 2)
+        {
+            goto failed;
+        }
+
+        sigil_free(&sgl);
+    }
+
+    print_test_result(1, verbosity);
+
+    // TEST: fn process_xref_streams
+    print_test_item("fn process_xref_streams", verbosity);
+
+    {
+        char pdf[4096];
+        size_t pos,
+               offset,
+               count = 2 * XREF_THREADS_MAX + 1;
+        reference_t ref;
+
+        pos = test_xref_stream_chain(pdf, count);
+        if ((sgl = test_prepare_sgl_buffer(pdf, pos)) == NULL)
+            goto failed;
+
+        if (read_startxref(sgl) != ERR_NONE ||
+            (sgl->xref = xref_init()) == NULL)
+        {
+            goto failed;
+        }
+
+        // only the dictionaries through the /Prev links
+        sgl->xref->prev_section = sgl->offset_startxref;
+        while (sgl->xref->prev_section > 0) {
+            offset = sgl->xref->prev_section;
+            sgl->xref->prev_section = 0;
+
+            if (pdf_move_pos_abs(sgl, offset) != ERR_NONE ||
+                process_xref(sgl) != ERR_NONE)
+            {
+                goto failed;
+            }
+        }
+
+        if (sgl->xref->section_count != count ||
+            sgl->xref->stream_count != count ||
+            process_xref_streams(sgl) != ERR_NONE ||
+            sgl->xref->stream_count != 0)
+        {
+            goto failed;
+        }
+
+        // the newest one wins
+        ref.object_num = 1;
+        ref.generation_num = 0;
+        if (xref_get_offset(sgl, &ref, &offset) != ERR_NONE ||
+            offset != 10 + count - 1)
+        {
+            goto failed;
+        }
+
+        for (size_t i = 0; i < count; i++) {
+            ref.object_num = 100 + i;
+            if (xref_get_offset(sgl, &ref, &offset) != ERR_NONE ||
+                offset != 256 + i)
+            {
+                goto failed;
+            }
+        }
+
+        // regardless of the order of adding
+        ref.object_num = 1;
+        if (add_xref_entry_at(sgl->xref, 1, 7, 0, XREF_ENTRY_IN_USE, 5) != ERR_NONE ||
+            xref_get_offset(sgl, &ref, &offset) != ERR_NONE ||
+            offset != 10 + count - 1)
+        {
+            goto failed;
+        }
+
+        sigil_free(&sgl);
+    }
+
+    print_test_result(1, verbosity);
+
+    // TEST: fn xref_load_sections
+    print_test_item("fn xref_load_sections", verbosity);
+
+    {
+        char pdf[4096];
+        size_t pos,
+               offset,
+               count = 2 * XREF_THREADS_MAX + 1;
+        reference_t ref;
+
+        pos = test_xref_stream_chain(pdf, count);
+        if ((sgl = test_prepare_sgl_buffer(pdf, pos)) == NULL)
+            goto failed;
+
+        if (read_startxref(sgl) != ERR_NONE ||
+            (sgl->xref = xref_init()) == NULL)
+        {
+            goto failed;
+        }
+
+        // the newest section only
+        sgl->xref->prev_section = sgl->offset_startxref;
+        if (xref_load_sections(sgl, 1) != ERR_NONE ||
+            sgl->xref->section_count != 1 ||
+            sgl->xref->prev_section <= 0)
+        {
+            goto failed;
+        }
+
+        // found in the newest section
+        ref.generation_num = 0;
+        ref.object_num = 1;
+        if (xref_get_offset(sgl, &ref, &offset) != ERR_NONE ||
+            offset != 10 + count - 1 ||
+            sgl->xref->section_count != 1)
+        {
+            goto failed;
+        }
+
+        // older sections loaded on miss, without moving the position
+        pos = sgl->pdf_data.buf_pos;
+        ref.object_num = 100 + count - 2;
+        if (xref_get_offset(sgl, &ref, &offset) != ERR_NONE ||
+            offset != 256 + count - 2 ||
+            sgl->xref->section_count < 2 ||
+            sgl->xref->section_count >= count ||
+            sgl->pdf_data.buf_pos != pos)
+        {
+            goto failed;
+        }
+
+        ref.object_num = 100;
+        if (xref_get_offset(sgl, &ref, &offset) != ERR_NONE ||
+            offset != 256 ||
+            sgl->xref->section_count != count ||
+            sgl->xref->prev_section != 0)
+        {
+            goto failed;
+        }
+
+        // nothing more to load
+        ref.object_num = 99;
+        if (xref_get_offset(sgl, &ref, &offset) != ERR_NO_DATA ||
+            xref_load_sections(sgl, 1) != ERR_NO_DATA)
+        {
+            goto failed;
+        }
+
+        sigil_free(&sgl);
+    }
+
+    print_test_result(1, verbosity);
+
+    // TEST: fn read_startxref
+    print_test_item("fn read_startxref", verbosity);
+
+    {
+        char *sstream = "abcdefghi\n" \
+                        "startxref\n" \
+                        "1234567890\n"\
+                        "\045\045EOF"; // %%EOF
+        if ((sgl = test_prepare_sgl_buffer(sstream, strlen(sstream) + 1)) == NULL)
+            goto failed;
+
+        if (read_startxref(sgl) != ERR_NONE ||
+            sgl->offset_startxref != 1234567890 ||
+            sgl->eof_count != 1 || sgl->offset_eof[0] != 31)
+        {
+            goto failed;
+        }
+
+        sigil_free(&sgl);
+
+        // incremental update, the last "startxref" is the valid one
+        sstream = "startxref\n"    \
+                  "42\n"           \
+                  "\045\045EOF\n"  \
+                  "1 0 obj\n"      \
+                  "startxref\n"    \
+                  "4321\n"         \
+                  "\045\045EOF\n";
+        if ((sgl = test_prepare_sgl_buffer(sstream, strlen(sstream) + 1)) == NULL)
+            goto failed;
+
+        if (read_startxref(sgl) != ERR_NONE ||
+            sgl->offset_startxref != 4321 ||
+            sgl->eof_count != 2 ||
+            sgl->offset_eof[0] != 13 || sgl->offset_eof[1] != 42)
+        {
+            goto failed;
+        }
+
+        sigil_free(&sgl);
+
+        sstream = "trailer\n\045\045EOF";
+        if ((sgl = test_prepare_sgl_buffer(sstream, strlen(sstream) + 1)) == NULL)
+            goto failed;
+
+        if (read_startxref(sgl) != ERR_PDF_CONTENT)
+            goto failed;
+
+        sigil_free(&sgl);
+    }
+
+    print_test_result(1, verbosity);
+
+    // TEST: fn xref_reconstruct
+    print_test_item("fn xref_reconstruct", verbosity);
+
+    {
+        char *sstream = "\045PDF-1.4\n"
+                        "1 0 obj\n<</Type /Catalog /Pages 2 0 R>>\nendobj\n"
+                        "2 0 obj\n<</Count 0 /T (3 0 objects x4 0 obj)>>\nendobj\n"
+                        "2 0 obj\n<</Count 1>>\nendobj\n"
+                        "\045\045EOF\n";
+        char *data = NULL;
+        reference_t ref;
+        uint8_t type;
+        size_t offset,
+               generation,
+               size;
+
+        if ((sgl = test_prepare_sgl_buffer(sstream, strlen(sstream))) == NULL)
+            goto failed;
+
+        if (xref_reconstruct(sgl) != ERR_NONE ||
+            !sgl->xref_reconstructed ||
+            sgl->ref_catalog_dict.object_num != 1 ||
+            sgl->ref_catalog_dict.generation_num != 0)
+        {
+            goto failed;
+        }
+
+        // the last occurrence, no entries from "endobj" and the strings
+        ref.generation_num = 0;
+        ref.object_num = 1;
+        if (xref_get_entry(sgl, &ref, &type, &offset, &generation) != ERR_NONE ||
+            type != XREF_ENTRY_IN_USE || offset != 9)
+        {
+            goto failed;
+        }
+
+        ref.object_num = 2;
+        if (xref_get_entry(sgl, &ref, &type, &offset, &generation) != ERR_NONE ||
+            offset != (size_t)(strstr(sstream, "2 0 obj\n<</Count 1") - sstream))
+        {
+            goto failed;
+        }
+
+        ref.object_num = 3;
+        if (xref_get_entry(sgl, &ref, &type, &offset, &generation) != ERR_NO_DATA)
+            goto failed;
+        ref.object_num = 4;
+        if (xref_get_entry(sgl, &ref, &type, &offset, &generation) != ERR_NO_DATA)
+            goto failed;
+
+        sigil_free(&sgl);
+
+        // read in blocks, with the header across the block boundary
+        size = READ_AHEAD_SIZE + 64;
+        data = mem_alloc(sizeof(*data) * (size + 1));
+        if (data == NULL)
+            goto failed;
+
+        memset(data, ' ', size);
+        data[size] = '\0';
+        memcpy(data, sstream, strlen(sstream));
+        memcpy(data + READ_AHEAD_SIZE - 5, "7 0 obj", 7);
+
+        if ((sgl = test_prepare_sgl_buffer(data, size)) == NULL) {
+            mem_free(data);
+            goto failed;
+        }
+
+        test_string_reader(&(sgl->pdf_data.reader), data);
+        sgl->pdf_data.buffer = NULL;
+
+        ref.object_num = 7;
+        if (xref_reconstruct(sgl) != ERR_NONE ||
+            sgl->ref_catalog_dict.object_num != 1 ||
+            xref_get_entry(sgl, &ref, &type, &offset, &generation) != ERR_NONE ||
+            offset != READ_AHEAD_SIZE - 5)
+        {
+            mem_free(data);
+            goto failed;
+        }
+
+        sigil_free(&sgl);
+        mem_free(data);
+    }
+
+    print_test_result(1, verbosity);
+
+    // TEST: verification of the files with damaged cross-reference table
+    print_test_item("VERIFY with damaged xref", verbosity);
+
+    {
+        const char *files[] = {
+            "test/subtype_adbe.x509.rsa_sha1.pdf",
+            "test/object_stream.pdf"
+        };
+        char *data = NULL;
+        reference_t ref;
+        uint8_t type;
+        size_t size,
+               pos,
+               offset,
+               generation;
+        int result;
+
+        for (size_t i = 0; i < 2 * sizeof(files) / sizeof(*files); i++) {
+            if ((sgl = test_prepare_sgl_path(files[i / 2])) == NULL)
+                goto failed;
+
+            size = sgl->pdf_data.size;
+            data = mem_alloc(sizeof(*data) * (size + 256));
+            if (data == NULL)
+                goto failed;
+            memcpy(data, sgl->pdf_data.buffer, size);
+            sigil_free(&sgl);
+
+            // appended update - broken startxref, or the catalog not at
+            // the offset from the table
+            pos = size;
+            if (i % 2 == 0) {
+                pos += (size_t)sprintf(data + pos,
+                    "startxref\n999999\n\045\045EOF\n");
+            } else {
+                pos += (size_t)sprintf(data + pos,
+                    "xref\n0 1\n0000000000 65535 f \n12 1\n0000000100 00000 n \n"
+                    "trailer\n<</Size 23 /Root 12 0 R>>\nstartxref\n%zu\n"
+                    "\045\045EOF\n", size);
+            }
+
+            if ((sgl = test_prepare_sgl_buffer(data, pos)) == NULL) {
+                mem_free(data);
+                goto failed;
+            }
+
+            if (sigil_verify(sgl) != ERR_NONE ||
+                sigil_get_xref_reconstructed(sgl, &result) != ERR_NONE ||
+                result != 1 ||
+                sigil_get_data_integrity_result(sgl, &result) != ERR_NONE ||
+                result != HASH_CMP_RESULT_MATCH)
+            {
+                mem_free(data);
+                goto failed;
+            }
+
+            // catalog from the object stream, not the older uncompressed one
+            ref.object_num = 12;
+            ref.generation_num = 0;
+            if (i / 2 == 1 &&
+                (xref_get_entry(sgl, &ref, &type, &offset, &generation) != ERR_NONE ||
+                 type != XREF_ENTRY_COMPRESSED || offset != 19))
+            {
+                mem_free(data);
+                goto failed;
+            }
+
+            sigil_free(&sgl);
+            mem_free(data);
+        }
+
+        // intact file is not reconstructed
+        if ((sgl = test_prepare_sgl_path(files[0])) == NULL)
+            goto failed;
+
+        if (sigil_verify(sgl) != ERR_NONE ||
+            sigil_get_xref_reconstructed(sgl, &result) != ERR_NONE ||
+            result != 0)
+        {
+            goto failed;
+        }
+
+        // neither because of a reference to a missing object
+        ref.object_num = 999;
+        ref.generation_num = 0;
+        if (pdf_goto_obj(sgl, &ref) != ERR_NO_DATA ||
+            sigil_get_xref_reconstructed(sgl, &result) != ERR_NONE ||
+            result != 0)
         {
             goto failed;
         }
@@ -1,4 +1,5 @@
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <sigil.h>
 #include <constants.h>
@@ -30,6 +31,9 @@ void print_help(void)
             "         PDF file with a digital signature for the verification. \n"
             "     -h, --help                                                  \n"
             "         Output a program usage message and exit.                \n"
+            "     -j, --jobs                                                  \n"
+            "         Maximum number of threads verifying the signatures of   \n"
+            "         the document in parallel (1 by default).                \n"
             "     -q, --quiet                                                 \n"
             "         Do not print anything to standard/error output.         \n"
             "     -td, --trusted-dir                                          \n"
@@ -58,11 +62,15 @@ int main(int argc, char *argv[])
     int result = VERIFY_FAILED;
     int result_integrity = HASH_CMP_RESULT_UNKNOWN;
     int result_certificate = CERT_STATUS_UNKNOWN;
+    int xref_reconstructed = 0;
+    int result_signature;
+    size_t signature_count = 0;
     int ret_code = 1;
     int help = 0;
     int quiet = 0;
     int trusted_system = 0;
     int cert_info = 0;
+    unsigned long jobs = 1;
     const char *trusted_file = NULL;
     const char *trusted_dir = NULL;
     const char *file = NULL;
@@ -91,6 +99,11 @@ int main(int argc, char *argv[])
                 break;
             }
             file = argv[pos];
+        } else if (strcmp(argv[pos], "-j") == 0 || strcmp(argv[pos], "--jobs") == 0) {
+            if (++pos >= argc) {
+                break;
+            }
+            jobs = strtoul(argv[pos], NULL, 10);
         } else if (strcmp(argv[pos], "-ci") == 0 || strcmp(argv[pos], "--cert-info") == 0) {
             cert_info = 1;
         } else {
@@ -163,6 +176,14 @@ int main(int argc, char *argv[])
         }
     }
 
+    if (sigil_set_verify_threads(sgl, (size_t)jobs) != ERR_NONE) {
+        if (!quiet) {
+            fprintf(stderr, COLOR_RED
+                    " ERROR setting number of jobs\n"COLOR_RESET);
+        }
+        goto end;
+    }
+
     // verify and save the result to the context
     err = sigil_verify(sgl);
     if (err != ERR_NONE) {
@@ -219,7 +240,32 @@ int main(int argc, char *argv[])
         printf("\n");
         printf("     %-20s", "hash function:");
         sigil_print_hash_fn(sgl);
-        printf("\n\n");
+        printf("\n");
+        if (sigil_get_xref_reconstructed(sgl, &xref_reconstructed) == ERR_NONE &&
+            xref_reconstructed)
+        {
+            printf("     %-20s", "xref reconstructed:");
+            printf("YES\n");
+        }
+        if (sigil_get_signature_count(sgl, &signature_count) == ERR_NONE &&
+            signature_count > 1)
+        {
+            printf("     %-20s%zu\n", "signatures:", signature_count);
+            for (size_t i = 0; i < signature_count; i++) {
+                printf("     %-20zu", i + 1);
+                err = sigil_get_signature_result(sgl, i, &result_signature);
+                if (err == ERR_NOT_IMPLEMENTED || err == ERR_PARAMETER) {
+                    printf(COLOR_RED"UNKNOWN\n"COLOR_RESET);
+                } else if (err != ERR_NONE) {
+                    printf(COLOR_RED"FAILED (%s)\n"COLOR_RESET, sigil_err_string(err));
+                } else if (result_signature == VERIFY_SUCCESS) {
+                    printf(COLOR_GREEN"VERIFIED\n"COLOR_RESET);
+                } else {
+                    printf(COLOR_RED"FAILED\n"COLOR_RESET);
+                }
+            }
+        }
+        printf("\n");
         printf("     DATA INTEGRITY\n");
         printf("     --------------\n");
         printf("     %-20s", "original digest:");
@@ -228,6 +274,9 @@ int main(int argc, char *argv[])
         printf("     %-20s", "computed digest:");
         sigil_print_computed_digest(sgl);
         printf("\n");
+        printf("     %-20s", "file SHA-256:");
+        sigil_print_file_digest(sgl);
+        printf("\n");
         printf("     %-20s", "digest match:");
         switch (result_integrity) {
             case HASH_CMP_RESULT_MATCH:
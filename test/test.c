@@ -1,6 +1,7 @@
 #include <stdio.h>
 #include <string.h>
 #include "acroform.h"
+#include "arena.h"
 #include "auxiliary.h"
 #include "catalog.h"
 #include "cert.h"
@@ -8,10 +9,15 @@
 #include "contents.h"
 #include "cryptography.h"
 #include "header.h"
+#include "mem.h"
+#include "objstm.h"
+#include "pool.h"
 #include "sig_dict.h"
 #include "sig_field.h"
 #include "sigil.h"
+#include "stream.h"
 #include "trailer.h"
+#include "uring.h"
 #include "xref.h"
 
 static void print_usage(const char *prog)
@@ -56,12 +62,24 @@ int main(int argc, char **argv)
         failed++;
     if (sigil_auxiliary_self_test(verbosity) != 0)
         failed++;
+    if (sigil_mem_self_test(verbosity) != 0)
+        failed++;
+    if (sigil_pool_self_test(verbosity) != 0)
+        failed++;
+    if (sigil_arena_self_test(verbosity) != 0)
+        failed++;
+    if (sigil_uring_self_test(verbosity) != 0)
+        failed++;
     if (sigil_header_self_test(verbosity) != 0)
         failed++;
+    if (sigil_stream_self_test(verbosity) != 0)
+        failed++;
     if (sigil_trailer_self_test(verbosity) != 0)
         failed++;
     if (sigil_xref_self_test(verbosity) != 0)
         failed++;
+    if (sigil_objstm_self_test(verbosity) != 0)
+        failed++;
     if (sigil_acroform_self_test(verbosity) != 0)
         failed++;
     if (sigil_catalog_self_test(verbosity) != 0)